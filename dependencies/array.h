@@ -3,7 +3,7 @@
  * If you want to define a new array type put 'ARRAY_H_DEFINE_ARRAY(TYPE_HERE)'
  * e.g. ARRAY_H_DEFINE_ARRAY(car_t) // 'car_t' would be a struct
  *
- * Version: 2.2
+ * Version: 2.3
  * Created by Duncan (CoffeeCatRailway) on 01/04/2025.
  * https://gist.github.com/CoffeeCatRailway/c55f8f56aaf40e2ecd5c3c6994370289
  *
@@ -44,15 +44,55 @@
  * Changelog 2.2:
  *	- Method declarations
  *	- Methods that alter array values and/or capacity now take array pointer pointer
+ *
+ * 17/10/2026
+ * Changelog 2.3:
+ *	- Capacity now grows geometrically (doubles), 'capacityIncrement' is only the minimum step
+ *	- Added 'array_type_reserve', 'array_type_push_n', 'array_type_append' & 'array_type_resize_uninitialized'
+ *	- Elements are aligned to 'ARRAY_H_ALIGNMENT' so simd code can load/store straight into them
+ *	- 'array_type_remove_at' uses memmove, the ranges overlap
+ *	- 'array_type_adjust' no longer underflows on empty arrays
  */
 
 #ifndef ARRAY_H_
 #define ARRAY_H_
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Must be a power of 2, 32 covers avx
+#ifndef ARRAY_H_ALIGNMENT
+#define ARRAY_H_ALIGNMENT 32
+#endif
+
+// Elements sit after the header, rounded up to 'ARRAY_H_ALIGNMENT'
+static inline char* array_h_elements(void* header, const size_t headerSize)
+{
+	const uintptr_t elements = (uintptr_t) header + headerSize;
+	return (char*) ((elements + ARRAY_H_ALIGNMENT - 1) & ~(uintptr_t) (ARRAY_H_ALIGNMENT - 1));
+}
+
+// Reallocates a header + elements block, realloc can change the alignment padding so the elements are moved to match
+static void* array_h_realloc(void* header, const size_t headerSize, const void* elements, const size_t usedBytes,
+							 const size_t capacityBytes, void** newElements)
+{
+	const size_t offset = header ? (size_t) ((const char*) elements - (const char*) header) : 0;
+	void* newHeader = realloc(header, headerSize + ARRAY_H_ALIGNMENT - 1 + capacityBytes);
+	if (newHeader == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to reallocate array!\n");
+		free(header);
+		exit(EXIT_FAILURE);
+	}
+	char* aligned = array_h_elements(newHeader, headerSize);
+	if (header && usedBytes && aligned != (char*) newHeader + offset)
+		memmove(aligned, (char*) newHeader + offset, usedBytes);
+	*newElements = aligned;
+	return newHeader;
+}
+
 #define ARRAY_H_DEFINE_ARRAY(type) \
 	typedef struct array_##type##_t \
 	{ \
@@ -64,23 +104,41 @@
 	\
 	static array_##type##_t* array_##type##_create(const size_t capacity); \
 	static void array_##type##_delete(array_##type##_t* array); \
+	static void array_##type##_reserve(array_##type##_t** array, const size_t capacity); \
 	static void array_##type##_push(array_##type##_t** array, type element); \
+	static void array_##type##_push_n(array_##type##_t** array, const type* elements, const size_t count); \
+	static void array_##type##_append(array_##type##_t** array, const array_##type##_t* other); \
+	static void array_##type##_resize_uninitialized(array_##type##_t** array, const size_t size); \
 	static type array_##type##_remove_at(array_##type##_t** array, const size_t i); \
 	static void array_##type##_adjust(array_##type##_t** array); \
 	\
+	static void array_##type##_realloc(array_##type##_t** array, const size_t capacity) \
+	{ \
+		void* elements; \
+		array_##type##_t* newArray = array_h_realloc(*array, sizeof(array_##type##_t), *array ? (*array)->array : NULL, \
+													 *array ? (*array)->size * sizeof(type) : 0, capacity * sizeof(type), &elements); \
+		newArray->capacity = capacity; \
+		newArray->array = (type*) elements; \
+		*array = newArray; \
+	} \
+	\
+	/* Doubles, or more if 'required' needs it, so pushing n elements is amortized O(n) */ \
+	static void array_##type##_grow(array_##type##_t** array, const size_t required) \
+	{ \
+		size_t capacity = (*array)->capacity * 2; \
+		if (capacity < (*array)->capacity + (*array)->capacityIncrement) \
+			capacity = (*array)->capacity + (*array)->capacityIncrement; \
+		if (capacity < required) \
+			capacity = required; \
+		array_##type##_realloc(array, capacity); \
+	} \
+	\
 	static array_##type##_t* array_##type##_create(const size_t capacity) \
 	{ \
-		array_##type##_t* array = malloc(sizeof(array_##type##_t) + capacity * sizeof(type)); \
-		if (array == NULL) \
-		{ \
-			fprintf(stderr, "Out of memory! Failed to allocate array!\n"); \
-			array_##type##_delete(array); \
-			exit(EXIT_FAILURE); \
-		} \
+		array_##type##_t* array = NULL; \
+		array_##type##_realloc(&array, capacity); \
 		array->size = 0; \
-		array->capacity = capacity; \
 		array->capacityIncrement = 2; \
-		array->array = (type*) (array + 1); \
 		return array; \
 	} \
 	\
@@ -91,24 +149,39 @@
 		free(array); \
 	} \
 	\
+	static void array_##type##_reserve(array_##type##_t** array, const size_t capacity) \
+	{ \
+		if (capacity > (*array)->capacity) \
+			array_##type##_realloc(array, capacity); \
+	} \
+	\
 	static void array_##type##_push(array_##type##_t** array, type element) \
 	{ \
-		(*array)->size++; \
-		if ((*array)->size > (*array)->capacity) \
-		{ \
-			(*array)->capacity += (*array)->capacityIncrement; \
-			array_##type##_t* newArray = realloc(*array, sizeof(array_##type##_t) + (*array)->capacity * sizeof(type)); \
-			if (newArray == NULL) \
-			{ \
-				fprintf(stderr, "Out of memory! Failed to reallocate array!\n"); \
-				array_##type##_delete(newArray); \
-				array_##type##_delete(*array); \
-				exit(EXIT_FAILURE); \
-			} \
-			*array = newArray; \
-			(*array)->array = (type*) (*array + 1); \
-		} \
-		(*array)->array[(*array)->size - 1] = element; \
+		if ((*array)->size == (*array)->capacity) \
+			array_##type##_grow(array, (*array)->size + 1); \
+		(*array)->array[(*array)->size++] = element; \
+	} \
+	\
+	static void array_##type##_push_n(array_##type##_t** array, const type* elements, const size_t count) \
+	{ \
+		if ((*array)->size + count > (*array)->capacity) \
+			array_##type##_grow(array, (*array)->size + count); \
+		if (count) \
+			memcpy(&(*array)->array[(*array)->size], elements, count * sizeof(type)); \
+		(*array)->size += count; \
+	} \
+	\
+	static void array_##type##_append(array_##type##_t** array, const array_##type##_t* other) \
+	{ \
+		array_##type##_push_n(array, other->array, other->size); \
+	} \
+	\
+	/* New elements are left as is, for callers that write them straight into 'array' */ \
+	static void array_##type##_resize_uninitialized(array_##type##_t** array, const size_t size) \
+	{ \
+		if (size > (*array)->capacity) \
+			array_##type##_grow(array, size); \
+		(*array)->size = size; \
 	} \
 	\
 	static type array_##type##_remove_at(array_##type##_t** array, const size_t i) \
@@ -117,7 +190,7 @@
 		if (i < (*array)->size - 1) \
 		{ \
 			const size_t segmentSize = ((*array)->size - i - 1) * sizeof(type); \
-			memcpy(&(*array)->array[i], &(*array)->array[i + 1], segmentSize); \
+			memmove(&(*array)->array[i], &(*array)->array[i + 1], segmentSize); \
 		} \
 		(*array)->size--; \
 		return value; \
@@ -125,21 +198,12 @@
 	\
 	static void array_##type##_adjust(array_##type##_t** array) \
 	{ \
-		const size_t capacityAdjusted = (*array)->size - 1 - (((*array)->size - 1) % (*array)->capacityIncrement) + (*array)->capacityIncrement; \
+		const size_t increment = (*array)->capacityIncrement ? (*array)->capacityIncrement : 1; \
+		size_t capacityAdjusted = ((*array)->size + increment - 1) / increment * increment; \
+		if (capacityAdjusted == 0) \
+			capacityAdjusted = increment; \
 		if (capacityAdjusted != (*array)->capacity) \
-		{ \
-			(*array)->capacity = capacityAdjusted; \
-			array_##type##_t* newArray = realloc(*array, sizeof(array_##type##_t) + (*array)->capacity * sizeof(type)); \
-			if (newArray == NULL) \
-			{ \
-				fprintf(stderr, "Out of memory! Failed to reallocate array!\n"); \
-				array_##type##_delete(newArray); \
-				array_##type##_delete(*array); \
-				exit(EXIT_FAILURE); \
-			} \
-			*array = newArray; \
-			(*array)->array = (type*) (*array + 1); \
-		} \
+			array_##type##_realloc(array, capacityAdjusted); \
 	}
 
 // ARRAY_H_DEFINE_ARRAY(int) // array_int_t
@@ -168,4 +232,9 @@ ARRAY_H_DEFINE_ARRAY(float) // array_float_t
 // array_int_remove_at(&array_int, 0);				// size=2 capacity=4
 // array_int_adjust(&array_int);					// size=2 capacity=2
 
+// Bulk appends copy a whole span at once, reserve up front when the final size is known
+// array_int_reserve(&array_int, 1000);				// size=2 capacity=1000
+// array_int_push_n(&array_int, values, 998);		// size=1000 capacity=1000
+// array_int_resize_uninitialized(&array_int, 1200);	// size=1200 capacity=2000, elements 1000+ are garbage until written
+
 #endif /* ARRAY_H_ */
@@ -0,0 +1,12 @@
+// Shared by every program, written once a frame by frameBlockUpdate (frameblock.h)
+layout(std140, binding = 0) uniform Frame
+{
+	mat4 u_view;
+	mat4 u_projection;
+	mat4 u_viewProjection;
+	mat4 u_inverseView;
+	mat4 u_inverseProjection;
+	vec3 u_viewPos;
+	float u_time;
+	vec2 u_viewportSize;
+};
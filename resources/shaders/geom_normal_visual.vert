@@ -1,17 +1,31 @@
-#version 330 core
+#version 430 core
+
+#include "frame.glsl"
 
-uniform mat4 u_projection;
-uniform mat4 u_view;
 uniform mat4 u_model;
+uniform vec3 u_positionOffset;
+uniform vec3 u_positionScale;
 
-in vec3 i_position;
-in vec3 i_normal;
-in vec2 i_uv;
+layout (location = 0) in vec3 i_position;
+layout (location = 1) in ivec3 i_qtangent;
+layout (location = 2) in vec2 i_uv;
 
 out vec3 vs_normal;
 
+// Only the normal of meshUnpackQTangent's frame
+vec3 decodeNormal(ivec3 packed) {
+    int largest = (packed.x & 1) | ((packed.y & 1) << 1);
+    vec3 small = vec3(packed) * (.70710678 / 32767.);
+    float rebuilt = sqrt(max(1. - dot(small, small), 0.));
+    vec4 q = largest == 0 ? vec4(rebuilt, small) :
+        largest == 1 ? vec4(small.x, rebuilt, small.yz) :
+        largest == 2 ? vec4(small.xy, rebuilt, small.z) : vec4(small, rebuilt);
+    return vec3(2. * (q.x * q.z + q.w * q.y), 2. * (q.y * q.z - q.w * q.x), 1. - 2. * (q.x * q.x + q.y * q.y));
+}
+
 void main() {
     mat3 normalMatrix = mat3(transpose(inverse(u_view * u_model)));
-    vs_normal = vec3(vec4(normalMatrix * i_normal, 0.));
-    gl_Position = u_view * u_model * vec4(i_position, 1.);
+    vs_normal = vec3(vec4(normalMatrix * decodeNormal(i_qtangent), 0.));
+    vec3 position = u_positionOffset + i_position * u_positionScale;
+    gl_Position = u_view * u_model * vec4(position, 1.);
 }
\ No newline at end of file
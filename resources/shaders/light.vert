@@ -1,32 +1,74 @@
-#version 330 core
+#version 430 core
 
-uniform mat4 u_projection;
-uniform mat4 u_view;
+#include "frame.glsl"
+
+// INSTANCED variants take the model matrix per instance, see lightingDefines in main.c
+#ifndef INSTANCED
 uniform mat4 u_model;
-uniform int u_isInstance;
+uniform mat3 u_normalMatrix; // Inverse transpose of u_model, from the transform store
+#endif
+uniform vec3 u_positionOffset;
+uniform vec3 u_positionScale;
 
 layout (location = 0) in vec3 i_position;
+#ifdef GLTF_VERTICES
+// glTF's own attributes, uploaded as they are in the file, see GLTF_NORMAL_LOCATION
 layout (location = 1) in vec3 i_normal;
+layout (location = 7) in vec4 i_tangent;
+#else
+layout (location = 1) in ivec3 i_qtangent; // Smallest three quaternion, see meshPackQTangent
+#endif
 layout (location = 2) in vec2 i_uv;
 layout (location = 3) in mat4 i_instanceMatrix;
 
 out vec3 v_fragPos;
 out vec3 v_normal;
+out vec4 v_tangent; // w is the bitangent's sign
 out vec2 v_uv;
 
+// Mirrors meshUnpackQTangent
+void decodeTangentFrame(ivec3 packed, out vec3 normal, out vec4 tangent)
+{
+	int largest = (packed.x & 1) | ((packed.y & 1) << 1);
+	vec3 small = vec3(packed) * (.70710678 / 32767.);
+	float rebuilt = sqrt(max(1. - dot(small, small), 0.));
+	vec4 q = largest == 0 ? vec4(rebuilt, small) :
+		largest == 1 ? vec4(small.x, rebuilt, small.yz) :
+		largest == 2 ? vec4(small.xy, rebuilt, small.z) : vec4(small, rebuilt);
+
+	normal = vec3(2. * (q.x * q.z + q.w * q.y), 2. * (q.y * q.z - q.w * q.x), 1. - 2. * (q.x * q.x + q.y * q.y));
+	tangent.xyz = vec3(1. - 2. * (q.y * q.y + q.z * q.z), 2. * (q.x * q.y + q.w * q.z), 2. * (q.x * q.z - q.w * q.y));
+	tangent.w = (packed.z & 1) != 0 ? -1. : 1.;
+}
+
 void main()
 {
-	mat4 model = mat4(mix(u_model[0], i_instanceMatrix[0], float(u_isInstance)),
-		mix(u_model[1], i_instanceMatrix[1], float(u_isInstance)),
-		mix(u_model[2], i_instanceMatrix[2], float(u_isInstance)),
-		mix(u_model[3], i_instanceMatrix[3], float(u_isInstance))
-	);
-	v_fragPos = vec3(model * vec4(i_position, 1.));
-
-//	v_normal = normalize(i_normal);
-	v_normal = normalize(mat3(transpose(inverse(model))) * i_normal);
-//	v_normal = normalize(cross(dFdx(v_fragPos), dFdy(v_fragPos)));
+#ifdef INSTANCED
+	mat4 model = i_instanceMatrix;
+	// Instances still build theirs here, everything else gets it precomputed
+	mat3 normalMatrix = mat3(transpose(inverse(model)));
+#else
+	mat4 model = u_model;
+	mat3 normalMatrix = u_normalMatrix;
+#endif
+	vec3 position = u_positionOffset + i_position * u_positionScale;
+	v_fragPos = vec3(model * vec4(position, 1.));
+
+	vec3 normal;
+	vec4 tangent;
+#ifdef GLTF_VERTICES
+	// Flipped to bottom left uvs like converted meshes get on load, which mirrors the bitangent
+	normal = i_normal;
+	tangent = vec4(i_tangent.xyz, -i_tangent.w);
+	v_uv = vec2(i_uv.x, 1. - i_uv.y);
+#else
+	decodeTangentFrame(i_qtangent, normal, tangent);
 	v_uv = i_uv;
+#endif
+//	v_normal = normalize(normal);
+	v_normal = normalize(normalMatrix * normal);
+	v_tangent = vec4(normalize(mat3(model) * tangent.xyz), tangent.w);
+//	v_normal = normalize(cross(dFdx(v_fragPos), dFdy(v_fragPos)));
 	
-	gl_Position = u_projection * u_view * vec4(v_fragPos, 1.);
+	gl_Position = u_viewProjection * vec4(v_fragPos, 1.);
 }
\ No newline at end of file
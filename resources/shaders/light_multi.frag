@@ -1,53 +1,73 @@
-#version 330 core
+#version 430 core
+
+#include "frame.glsl"
+
 precision mediump float;
 
 #define F_LHT_DIRECT 1
 #define F_LHT_POINT 2
 #define F_LHT_SPOT 3
 
-#define N_LIGHTS 8
+// Injected per variant (see lightingDefines in main.c), these defaults are only for compiling it on its own. They're the
+// light counts rounded up to a power of two, the loops stop at the exact ones from the buffer
+#ifndef NUM_DIRECT
+#define NUM_DIRECT 0
+#endif
+#ifndef NUM_POINT
+#define NUM_POINT 0
+#endif
+#ifndef NUM_SPOT
+#define NUM_SPOT 0
+#endif
 
 struct Material
 {
 	sampler2D diffuseTex;
 	sampler2D specularTex;
+	sampler2D normalTex; // Tangent space, only read by HAS_NORMAL_MAP variants
+	vec3 diffuseColor; // Kd & Ks from the mtl, white when only textures are used
+	vec3 specularColor;
 	
 	float shininess;
 };
 
+// Packed on the CPU (light.c), cut offs are already cosines & the constant attenuation term is always 1
 struct Light
 {
-	bool enable;
-	int mode;
 	vec3 position;
+	int mode;
 	vec3 direction;
 	float cutOffInner;
-	float cutOffOuter;
-
 	vec3 ambient;
+	float cutOffOuter;
 	vec3 diffuse;
-	vec3 specular;
-
-	float constant;
 	float linear;
+	vec3 specular;
 	float quadratic;
 };
 
+// Only enabled lights, grouped by mode (direct, point then spot) so each loop knows its mode at compile time
+layout(std430, binding = 0) readonly buffer Lights
+{
+	uint u_numLights;
+	uint u_numDirect;
+	uint u_numPoint;
+	uint u_numSpot;
+	Light u_lights[];
+};
+
 uniform samplerCube u_skybox;
 
-uniform vec3 u_viewPos;
 uniform Material u_material;
 
-uniform Light u_lights[N_LIGHTS];
-
 in vec3 v_fragPos;
 in vec3 v_normal;
+in vec4 v_tangent;
 in vec2 v_uv;
 
 out vec4 FragColor;
 
-vec3 blinnPhong(Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 specularMap);
-vec3 phong(Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 diffuseMap, vec3 specularMap);
+vec3 blinnPhong(const int mode, Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 specularMap);
 
 vec3 calcDirectLight(Light light, vec3 normal, vec3 viewDir, vec3 diffuseMap, vec3 specularMap);
 vec3 calcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseMap, vec3 specularMap);
@@ -59,27 +79,45 @@ void main()
 	vec4 diffuseMap = texture(u_material.diffuseTex, v_uv);
 	if (diffuseMap.a < .1)
 		discard;
-	vec3 specularMap = texture(u_material.specularTex, v_uv).rgb;
+	diffuseMap.rgb *= u_material.diffuseColor;
+	// Materials without a specular map bind white
+	vec3 specularMap = texture(u_material.specularTex, v_uv).rgb * u_material.specularColor;
+
+	vec3 normal = normalize(v_normal);
+#ifdef HAS_NORMAL_MAP
+	// Re-orthogonalized, interpolation skews the frame between vertices
+	vec3 tangent = normalize(v_tangent.xyz - normal * dot(normal, v_tangent.xyz));
+	vec3 bitangent = cross(normal, tangent) * v_tangent.w;
+	vec3 tangentNormal = texture(u_material.normalTex, v_uv).rgb * 2. - 1.;
+	normal = normalize(mat3(tangent, bitangent, normal) * tangentNormal);
+#endif
 
 	vec3 viewDir = normalize(u_viewPos - v_fragPos);
 
-	bool blinn = true;
 	vec3 result = vec3(0.);
-	for (int i = 0; i < N_LIGHTS; i++)
-	{
-		if (!u_lights[i].enable)
-			continue;
-		if (blinn)
-			result += blinnPhong(u_lights[i], viewDir, v_normal, v_fragPos, specularMap);
-		else
-			result += phong(u_lights[i], viewDir, v_normal, v_fragPos, diffuseMap.rgb, specularMap);
-	}
-	if (blinn)
-	{
-		result = diffuseMap.rgb * result;
-
-		result = pow(result, vec3(1. / 2.));
-	}
+	uint numDirect = min(u_numDirect, uint(NUM_DIRECT));
+	uint numPoint = min(u_numPoint, uint(NUM_POINT));
+	uint numSpot = min(u_numSpot, uint(NUM_SPOT));
+	uint firstPoint = u_numDirect;
+	uint firstSpot = u_numDirect + u_numPoint;
+#ifdef BLINN
+	for (uint i = 0u; i < numDirect; i++)
+		result += blinnPhong(F_LHT_DIRECT, u_lights[i], viewDir, normal, v_fragPos, specularMap);
+	for (uint i = 0u; i < numPoint; i++)
+		result += blinnPhong(F_LHT_POINT, u_lights[firstPoint + i], viewDir, normal, v_fragPos, specularMap);
+	for (uint i = 0u; i < numSpot; i++)
+		result += blinnPhong(F_LHT_SPOT, u_lights[firstSpot + i], viewDir, normal, v_fragPos, specularMap);
+
+	result = diffuseMap.rgb * result;
+	result = pow(result, vec3(1. / 2.));
+#else
+	for (uint i = 0u; i < numDirect; i++)
+		result += calcDirectLight(u_lights[i], normal, viewDir, diffuseMap.rgb, specularMap);
+	for (uint i = 0u; i < numPoint; i++)
+		result += calcPointLight(u_lights[firstPoint + i], normal, v_fragPos, viewDir, diffuseMap.rgb, specularMap);
+	for (uint i = 0u; i < numSpot; i++)
+		result += calcSpotLight(u_lights[firstSpot + i], normal, v_fragPos, viewDir, diffuseMap.rgb, specularMap);
+#endif
 
 //	vec3 I = normalize(v_fragPos - u_viewPos);
 //	vec3 R = refract(I, v_normal, 1. / 1.33);
@@ -94,14 +132,15 @@ void main()
 	FragColor = vec4(result, diffuseMap.a);// * (1. - depthVec) + depthVec;
 }
 
-vec3 blinnPhong(Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 specularMap)
+// 'mode' is always a literal, so the branches on it fold away
+vec3 blinnPhong(const int mode, Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 specularMap)
 {
 	// ambient
 	vec3 ambient = .1 * light.specular;
 
 	// diffuse
 	vec3 lightDir;
-	if (light.mode == F_LHT_DIRECT)
+	if (mode == F_LHT_DIRECT)
 	lightDir = normalize(-light.direction);
 	else
 	lightDir = normalize(light.position - fragPos);
@@ -113,15 +152,15 @@ vec3 blinnPhong(Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 specu
 	float spec = pow(max(dot(normal, halfwayDir), 0.), u_material.shininess);
 	vec3 specular = spec * light.specular * specularMap;
 
-	if (light.mode != F_LHT_DIRECT)
+	if (mode != F_LHT_DIRECT)
 	{
 		// attenuation
 		float distance = length(light.position - fragPos);
-		float attenuation = 1. / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+		float attenuation = 1. / (1. + light.linear * distance + light.quadratic * (distance * distance));
 
 		// spotlight intensoty
 		float intensity = 1.;
-		if (light.mode == F_LHT_SPOT)
+		if (mode == F_LHT_SPOT)
 		{
 			float theta = dot(lightDir, normalize(-light.direction));
 			float epsilon = light.cutOffInner - light.cutOffOuter;
@@ -136,20 +175,6 @@ vec3 blinnPhong(Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 specu
 	return ambient + diffuse + specular;
 }
 
-vec3 phong(Light light, vec3 viewDir, vec3 normal, vec3 fragPos, vec3 diffuseMap, vec3 specularMap)
-{
-	vec3 result = vec3(0.);
-	if (light.mode == F_LHT_DIRECT)
-	result += calcDirectLight(light, normal, viewDir, diffuseMap, specularMap);
-
-	if (light.mode == F_LHT_POINT)
-	result += calcPointLight(light, normal, fragPos, viewDir, diffuseMap, specularMap);
-
-	if (light.mode == F_LHT_SPOT)
-	result += calcSpotLight(light, normal, fragPos, viewDir, diffuseMap, specularMap);
-	return result;
-}
-
 vec3 calcDirectLight(Light light, vec3 normal, vec3 viewDir, vec3 diffuseMap, vec3 specularMap)
 {
 	vec3 lightDir = normalize(-light.direction);
@@ -175,7 +200,7 @@ vec3 calcPointLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 d
 	float spec = pow(max(dot(viewDir, reflectDir), 0.), u_material.shininess);
 	// attenuation
 	float distance = length(light.position - fragPos);
-	float attenuation = 1. / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+	float attenuation = 1. / (1. + light.linear * distance + light.quadratic * (distance * distance));
 	// combine
 	vec3 ambient = light.ambient * diffuseMap;
 	vec3 diffuse = light.diffuse * diff * diffuseMap;
@@ -196,7 +221,7 @@ vec3 calcSpotLight(Light light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 di
 	float spec = pow(max(dot(viewDir, reflectDir), 0.), u_material.shininess);
 	// attenuation
 	float distance = length(light.position - fragPos);
-	float attenuation = 1. / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+	float attenuation = 1. / (1. + light.linear * distance + light.quadratic * (distance * distance));
 	// spotlight intensoty
 	float theta = dot(lightDir, normalize(-light.direction));
 	float epsilon = light.cutOffInner - light.cutOffOuter;
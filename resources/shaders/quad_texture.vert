@@ -1,7 +1,7 @@
 #version 330 core
 
-in vec2 i_position;
-in vec2 i_uv;
+layout (location = 0) in vec2 i_position;
+layout (location = 1) in vec2 i_uv;
 
 out vec2 v_uv;
 
@@ -1,12 +1,15 @@
-#version 330 core
+#version 430 core
+
+#include "frame.glsl"
 
 uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
+uniform vec3 u_positionOffset;
+uniform vec3 u_positionScale;
 
-in vec3 i_position;
+layout (location = 0) in vec3 i_position;
 
 void main()
 {
-	gl_Position = u_projection * u_view * u_model * vec4(i_position, 1.);
+	vec3 position = u_positionOffset + i_position * u_positionScale;
+	gl_Position = u_viewProjection * u_model * vec4(position, 1.);
 }
\ No newline at end of file
@@ -1,15 +1,19 @@
-#version 330 core
+#version 430 core
 
-in vec3 i_position;
+#include "frame.glsl"
 
-uniform mat4 u_projection;
-uniform mat4 u_view;
+layout (location = 0) in vec3 i_position;
+
+uniform vec3 u_positionOffset;
+uniform vec3 u_positionScale;
 
 out vec3 v_uv;
 
 void main()
 {
-    v_uv = i_position;
-    vec4 pos = u_projection * u_view * vec4(i_position, 1.);
+    vec3 position = u_positionOffset + i_position * u_positionScale;
+    v_uv = position;
+    // No translation, the sky stays put around the camera
+    vec4 pos = u_projection * mat4(mat3(u_view)) * vec4(position, 1.);
     gl_Position = pos.xyww;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+struct arenaBlock_t
+{
+	arenaBlock_t* previous;
+	size_t capacity; // Bytes after the header
+	size_t offset;
+};
+
+// The header is padded so the data after it keeps the block's alignment
+#define BLOCK_HEADER_SIZE ((sizeof(arenaBlock_t) + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1))
+
+static size_t alignSize(const size_t size)
+{
+	return (size + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+}
+
+static arenaBlock_t* createBlock(const arena_t* arena, arenaBlock_t* previous, const size_t capacity)
+{
+	// Sizes are multiples of the alignment so aligned_alloc is happy
+#ifdef _WIN32
+	arenaBlock_t* block = _aligned_malloc(BLOCK_HEADER_SIZE + capacity, ARENA_ALIGNMENT);
+#else
+	arenaBlock_t* block = aligned_alloc(ARENA_ALIGNMENT, BLOCK_HEADER_SIZE + capacity);
+#endif
+	if (block == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate %zu bytes for arena %s!\n", capacity, arena->name);
+		exit(EXIT_FAILURE);
+	}
+	block->previous = previous;
+	block->capacity = capacity;
+	block->offset = 0;
+	return block;
+}
+
+static void destroyBlock(arenaBlock_t* block)
+{
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+void arenaInit(arena_t* arena, const char* name, const size_t blockSize)
+{
+	arena->name = name;
+	arena->blockSize = alignSize(blockSize ? blockSize : ARENA_ALIGNMENT);
+	arena->block = createBlock(arena, NULL, arena->blockSize);
+	arena->used = 0;
+	arena->peak = 0;
+}
+
+void arenaDestroy(arena_t* arena)
+{
+	while (arena->block)
+	{
+		arenaBlock_t* previous = arena->block->previous;
+		destroyBlock(arena->block);
+		arena->block = previous;
+	}
+	arena->used = 0;
+}
+
+void* arenaAlloc(arena_t* arena, size_t size)
+{
+	size = alignSize(size);
+	arenaBlock_t* block = arena->block;
+	if (block->capacity - block->offset < size)
+	{
+		// Spill, the old block's tail is wasted until the next reset folds everything into one
+		const size_t capacity = size > block->capacity ? size : block->capacity;
+		block = arena->block = createBlock(arena, block, capacity);
+	}
+
+	void* memory = (unsigned char*) block + BLOCK_HEADER_SIZE + block->offset;
+	block->offset += size;
+	arena->used += size;
+	if (arena->used > arena->peak)
+		arena->peak = arena->used;
+	return memory;
+}
+
+void* arenaAllocZero(arena_t* arena, const size_t size)
+{
+	return memset(arenaAlloc(arena, size), 0, size);
+}
+
+char* arenaPrintf(arena_t* arena, const char* format, ...)
+{
+	va_list args, argsCopy;
+	va_start(args, format);
+	va_copy(argsCopy, args);
+	const int length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	const size_t size = (size_t) (length > 0 ? length : 0) + 1;
+	char* string = arenaAlloc(arena, size);
+	vsnprintf(string, size, format, argsCopy);
+	va_end(argsCopy);
+	return string;
+}
+
+void arenaReset(arena_t* arena)
+{
+	if (arena->block->previous)
+	{
+		arenaDestroy(arena);
+		arena->block = createBlock(arena, NULL, arena->peak > arena->blockSize ? arena->peak : arena->blockSize);
+		printf("Arena %s grown to %.1f KB\n", arena->name, (double) arena->block->capacity / 1024.);
+	}
+	arena->block->offset = 0;
+	arena->used = 0;
+}
+
+arenaMark_t arenaGetMark(arena_t* arena)
+{
+	return (arenaMark_t) {arena, arena->block, arena->block->offset, arena->used};
+}
+
+void arenaRewind(const arenaMark_t mark)
+{
+	arena_t* arena = mark.arena;
+	if (mark.used == 0)
+	{
+		arenaReset(arena);
+		return;
+	}
+	while (arena->block != mark.block)
+	{
+		arenaBlock_t* previous = arena->block->previous;
+		destroyBlock(arena->block);
+		arena->block = previous;
+	}
+	arena->block->offset = mark.offset;
+	arena->used = mark.used;
+}
+
+static pthread_once_t scratchOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t scratchKey;
+
+static void destroyScratch(void* scratch)
+{
+	arenaDestroy(scratch);
+	free(scratch);
+}
+
+static void createScratchKey()
+{
+	pthread_key_create(&scratchKey, destroyScratch);
+}
+
+arena_t* arenaScratch()
+{
+	pthread_once(&scratchOnce, createScratchKey);
+	arena_t* scratch = pthread_getspecific(scratchKey);
+	if (scratch == NULL)
+	{
+		scratch = malloc(sizeof(arena_t));
+		if (scratch == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate scratch arena!\n");
+			exit(EXIT_FAILURE);
+		}
+		arenaInit(scratch, "scratch", ARENA_SCRATCH_SIZE);
+		pthread_setspecific(scratchKey, scratch);
+	}
+	return scratch;
+}
+
+void arenaScratchRelease()
+{
+	pthread_once(&scratchOnce, createScratchKey);
+	arena_t* scratch = pthread_getspecific(scratchKey);
+	if (scratch)
+	{
+		destroyScratch(scratch);
+		pthread_setspecific(scratchKey, NULL);
+	}
+}
+
+#if defined(ARENA_CHECK_HEAP) && defined(__GLIBC__)
+// Interposes the allocator so every heap allocation on a thread is counted, glibc keeps the real ones under __libc_*
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* memory, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+
+static _Thread_local uint64_t heapAllocations = 0;
+
+void* malloc(const size_t size)
+{
+	heapAllocations++;
+	return __libc_malloc(size);
+}
+
+void* calloc(const size_t count, const size_t size)
+{
+	heapAllocations++;
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, const size_t size)
+{
+	heapAllocations++;
+	return __libc_realloc(memory, size);
+}
+
+void* aligned_alloc(const size_t alignment, const size_t size)
+{
+	heapAllocations++;
+	return __libc_memalign(alignment, size);
+}
+
+uint64_t arenaHeapAllocations()
+{
+	return heapAllocations;
+}
+#else
+uint64_t arenaHeapAllocations()
+{
+	return 0;
+}
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Bump allocators, a frame arena that's reset every frame & per thread scratch arenas for loaders
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_ALIGNMENT 32 // Every allocation, so cglm's simd mat4 paths are always safe
+#define ARENA_FRAME_SIZE (1024 * 1024)
+#define ARENA_SCRATCH_SIZE (4 * 1024 * 1024)
+#define ARENA_WARMUP_FRAMES 120 // Frames before ARENA_CHECK_HEAP builds start checking
+
+typedef struct arenaBlock_t arenaBlock_t;
+
+typedef struct arena_t
+{
+	const char* name;
+	arenaBlock_t* block; // Newest, older blocks only stick around until the next reset
+	size_t blockSize; // Smallest block
+	size_t used; // Across every block
+	size_t peak;
+} arena_t;
+
+// Where to rewind to, so scratch allocations can be scoped to a function
+typedef struct arenaMark_t
+{
+	arena_t* arena;
+	arenaBlock_t* block;
+	size_t offset;
+	size_t used;
+} arenaMark_t;
+
+void arenaInit(arena_t* arena, const char* name, size_t blockSize);
+void arenaDestroy(arena_t* arena);
+
+// Never NULL, spills into a new block when full instead of failing
+void* arenaAlloc(arena_t* arena, size_t size);
+void* arenaAllocZero(arena_t* arena, size_t size);
+char* arenaPrintf(arena_t* arena, const char* format, ...);
+
+// Frees everything, an arena that spilled is regrown into one block of its peak so the next cycle won't
+void arenaReset(arena_t* arena);
+arenaMark_t arenaGetMark(arena_t* arena);
+void arenaRewind(arenaMark_t mark);
+
+// This thread's scratch arena, created on first use & kept (at its peak) for the thread's lifetime
+// Take a mark before using it & rewind to it when done, nothing may outlive the rewind
+arena_t* arenaScratch();
+// Only needed on the main thread, worker threads free theirs on exit
+void arenaScratchRelease();
+
+// Heap allocations made by this thread so far, only counted in ARENA_CHECK_HEAP builds (glibc), 0 otherwise
+uint64_t arenaHeapAllocations();
+
+#endif //ARENA_H
@@ -37,6 +37,38 @@ void cameraGetViewMatrix(camera_t* camera, mat4* view)
 	glm_lookat(camera->position, center, camera->up, *view);
 }
 
+void cameraUpdateFrustum(camera_t* camera, const mat4 viewProjection)
+{
+	// Each plane is the 4th row of the matrix plus/minus one of the others (cglm is column major, so m[column][row])
+	vec4* planes = camera->frustum.planes;
+	for (int i = 0; i < 4; i++)
+	{
+		const float row3 = viewProjection[i][3];
+		planes[FRUSTUM_LEFT][i] = row3 + viewProjection[i][0];
+		planes[FRUSTUM_RIGHT][i] = row3 - viewProjection[i][0];
+		planes[FRUSTUM_BOTTOM][i] = row3 + viewProjection[i][1];
+		planes[FRUSTUM_TOP][i] = row3 - viewProjection[i][1];
+		planes[FRUSTUM_NEAR][i] = row3 + viewProjection[i][2];
+		planes[FRUSTUM_FAR][i] = row3 - viewProjection[i][2];
+	}
+	for (int i = 0; i < FRUSTUM_PLANES; i++)
+	{
+		const float length = glm_vec3_norm(planes[i]);
+		if (length > 0.f)
+			glm_vec4_scale(planes[i], 1.f / length, planes[i]);
+	}
+}
+
+bool frustumTestSphere(const frustum_t* frustum, const vec3 center, const float radius)
+{
+	for (int i = 0; i < FRUSTUM_PLANES; i++)
+	{
+		if (glm_vec3_dot((float*) frustum->planes[i], (float*) center) + frustum->planes[i][3] < -radius)
+			return false;
+	}
+	return true;
+}
+
 void cameraMoveForward(camera_t* camera, const float delta)
 {
 	vec3 step;
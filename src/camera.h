@@ -5,10 +5,29 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include <stdbool.h>
+
 #include <cglm/cglm.h>
 
 #define GLOBAL_UP (vec3){0.f, 1.f, 0.f}
 
+enum
+{
+	FRUSTUM_LEFT = 0,
+	FRUSTUM_RIGHT,
+	FRUSTUM_BOTTOM,
+	FRUSTUM_TOP,
+	FRUSTUM_NEAR,
+	FRUSTUM_FAR,
+	FRUSTUM_PLANES
+};
+
+// World space planes (normal, distance), normalized so dot(normal, p) + distance is the signed distance, positive inside
+typedef struct frustum_t
+{
+	vec4 planes[FRUSTUM_PLANES];
+} frustum_t;
+
 typedef struct camera_t
 {
 	vec3 position;
@@ -23,12 +42,17 @@ typedef struct camera_t
 	float fov;
 	float near;
 	float far;
+
+	frustum_t frustum; // Updated by cameraUpdateFrustum
 } camera_t;
 
 camera_t* cameraCreate(const vec3 pos, float yaw, float pitch, float pitchConstraint, float fov, float near, float far);
 void cameraDelete(camera_t* camera);
 
 void cameraGetViewMatrix(camera_t* camera, mat4* view);
+// Gribb/Hartmann plane extraction from projection * view
+void cameraUpdateFrustum(camera_t* camera, const mat4 viewProjection);
+bool frustumTestSphere(const frustum_t* frustum, const vec3 center, float radius);
 
 void cameraMoveForward(camera_t* camera, float delta);
 void cameraMoveBackward(camera_t* camera, float delta);
@@ -0,0 +1,294 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cull.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CULL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(CULL_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CULL_SSE
+#endif
+
+#if defined(CULL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CULL_AVX2
+#define CULL_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(CULL_X86) && defined(_MSC_VER)
+#define CULL_AVX2
+#define CULL_TARGET_AVX2
+#endif
+
+static void* allocAligned(const size_t size)
+{
+	// 32 bytes for avx loads, size is always a multiple of the batch so aligned_alloc is happy
+#ifdef _WIN32
+	return _aligned_malloc(size, 32);
+#else
+	return aligned_alloc(32, size);
+#endif
+}
+
+static void freeAligned(void* memory)
+{
+#ifdef _WIN32
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+static inline int lowestBit(const uint32_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return (int) index;
+#else
+	return __builtin_ctz(bits);
+#endif
+}
+
+cullSpheres_t* cullSpheresCreate(const size_t count)
+{
+	cullSpheres_t* spheres = malloc(sizeof(cullSpheres_t));
+	const size_t padded = (count + CULL_BATCH - 1) / CULL_BATCH * CULL_BATCH + CULL_BATCH;
+	if (spheres)
+	{
+		spheres->count = count;
+		spheres->x = allocAligned(padded * sizeof(float));
+		spheres->y = allocAligned(padded * sizeof(float));
+		spheres->z = allocAligned(padded * sizeof(float));
+		spheres->radius = allocAligned(padded * sizeof(float));
+	}
+	if (spheres == NULL || spheres->x == NULL || spheres->y == NULL || spheres->z == NULL || spheres->radius == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate culling spheres!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	memset(spheres->x, 0, padded * sizeof(float));
+	memset(spheres->y, 0, padded * sizeof(float));
+	memset(spheres->z, 0, padded * sizeof(float));
+	for (size_t i = 0; i < padded; i++)
+		spheres->radius[i] = -FLT_MAX; // Can never pass a plane test
+	return spheres;
+}
+
+void cullSpheresDestroy(cullSpheres_t* spheres)
+{
+	freeAligned(spheres->x);
+	freeAligned(spheres->y);
+	freeAligned(spheres->z);
+	freeAligned(spheres->radius);
+	free(spheres);
+}
+
+void cullSpheresSet(cullSpheres_t* spheres, const size_t index, const vec3 center, const float radius)
+{
+	spheres->x[index] = center[0];
+	spheres->y[index] = center[1];
+	spheres->z[index] = center[2];
+	spheres->radius[index] = radius;
+}
+
+static size_t cullScalar(const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible)
+{
+	size_t numVisible = 0;
+	for (size_t i = 0; i < spheres->count; i++)
+	{
+		bool inside = true;
+		for (int p = 0; p < FRUSTUM_PLANES && inside; p++)
+		{
+			const float* plane = frustum->planes[p];
+			inside = plane[0] * spheres->x[i] + plane[1] * spheres->y[i] + plane[2] * spheres->z[i] + plane[3] >= -spheres->radius[i];
+		}
+		visible[numVisible] = (uint32_t) i;
+		numVisible += inside;
+	}
+	return numVisible;
+}
+
+#ifdef CULL_SSE
+static size_t cullSSE(const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible)
+{
+	__m128 planes[FRUSTUM_PLANES][4];
+	for (int p = 0; p < FRUSTUM_PLANES; p++)
+	{
+		for (int k = 0; k < 4; k++)
+			planes[p][k] = _mm_set1_ps(frustum->planes[p][k]);
+	}
+
+	size_t numVisible = 0;
+	for (size_t i = 0; i < spheres->count; i += 4)
+	{
+		const __m128 x = _mm_load_ps(&spheres->x[i]);
+		const __m128 y = _mm_load_ps(&spheres->y[i]);
+		const __m128 z = _mm_load_ps(&spheres->z[i]);
+		const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(&spheres->radius[i]));
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int p = 0; p < FRUSTUM_PLANES; p++)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(planes[p][0], x), planes[p][3]);
+			distance = _mm_add_ps(_mm_mul_ps(planes[p][1], y), distance);
+			distance = _mm_add_ps(_mm_mul_ps(planes[p][2], z), distance);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		// Padding has a radius of -FLT_MAX so the last batch needs no mask
+		uint32_t bits = (uint32_t) _mm_movemask_ps(inside);
+		while (bits)
+		{
+			visible[numVisible++] = (uint32_t) (i + lowestBit(bits));
+			bits &= bits - 1;
+		}
+	}
+	return numVisible;
+}
+#endif
+
+#ifdef CULL_AVX2
+CULL_TARGET_AVX2 static size_t cullAVX2(const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible)
+{
+	__m256 planes[FRUSTUM_PLANES][4];
+	for (int p = 0; p < FRUSTUM_PLANES; p++)
+	{
+		for (int k = 0; k < 4; k++)
+			planes[p][k] = _mm256_set1_ps(frustum->planes[p][k]);
+	}
+
+	size_t numVisible = 0;
+	for (size_t i = 0; i < spheres->count; i += 8)
+	{
+		const __m256 x = _mm256_load_ps(&spheres->x[i]);
+		const __m256 y = _mm256_load_ps(&spheres->y[i]);
+		const __m256 z = _mm256_load_ps(&spheres->z[i]);
+		const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_load_ps(&spheres->radius[i]));
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int p = 0; p < FRUSTUM_PLANES; p++)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(planes[p][0], x), planes[p][3]);
+			distance = _mm256_add_ps(_mm256_mul_ps(planes[p][1], y), distance);
+			distance = _mm256_add_ps(_mm256_mul_ps(planes[p][2], z), distance);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+
+		uint32_t bits = (uint32_t) _mm256_movemask_ps(inside);
+		while (bits)
+		{
+			visible[numVisible++] = (uint32_t) (i + lowestBit(bits));
+			bits &= bits - 1;
+		}
+	}
+	return numVisible;
+}
+
+static bool cpuHasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	const bool osSaves = (info[2] & (1 << 27)) && (info[2] & (1 << 28)); // osxsave & avx
+	if (!osSaves || (_xgetbv(0) & 6) != 6)
+		return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+bool cullPathSupported(const cullPath_t path)
+{
+	switch (path)
+	{
+		case CULL_PATH_SCALAR:
+			return true;
+#ifdef CULL_SSE
+		case CULL_PATH_SSE:
+			return true;
+#endif
+#ifdef CULL_AVX2
+		case CULL_PATH_AVX2:
+		{
+			static int supported = -1;
+			if (supported < 0)
+				supported = cpuHasAVX2();
+			return supported;
+		}
+#endif
+		default:
+			return false;
+	}
+}
+
+cullPath_t cullGetPath()
+{
+	static cullPath_t path = CULL_PATH_COUNT;
+	if (path == CULL_PATH_COUNT)
+	{
+		path = CULL_PATH_SCALAR;
+		for (int i = CULL_PATH_COUNT - 1; i > CULL_PATH_SCALAR; i--)
+		{
+			if (cullPathSupported((cullPath_t) i))
+			{
+				path = (cullPath_t) i;
+				break;
+			}
+		}
+	}
+	return path;
+}
+
+const char* cullPathName(const cullPath_t path)
+{
+	switch (path)
+	{
+		case CULL_PATH_SCALAR:
+			return "scalar";
+		case CULL_PATH_SSE:
+			return "sse";
+		case CULL_PATH_AVX2:
+			return "avx2";
+		default:
+			return "unknown";
+	}
+}
+
+size_t cullFrustumSpheres(const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible)
+{
+	return cullFrustumSpheresPath(cullGetPath(), frustum, spheres, visible);
+}
+
+size_t cullFrustumSpheresPath(const cullPath_t path, const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible)
+{
+	switch (path)
+	{
+#ifdef CULL_AVX2
+		case CULL_PATH_AVX2:
+			if (cullPathSupported(CULL_PATH_AVX2))
+				return cullAVX2(frustum, spheres, visible);
+			break;
+#endif
+#ifdef CULL_SSE
+		case CULL_PATH_SSE:
+			return cullSSE(frustum, spheres, visible);
+#endif
+		default:
+			break;
+	}
+	return cullScalar(frustum, spheres, visible);
+}
@@ -0,0 +1,47 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Batched frustum culling of bounding spheres, sse/avx2 with a scalar fallback picked at runtime
+ */
+
+#ifndef CULL_H
+#define CULL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "camera.h"
+
+#define CULL_BATCH 8 // Sphere arrays are padded to a multiple of this
+
+typedef enum cullPath_t
+{
+	CULL_PATH_SCALAR = 0,
+	CULL_PATH_SSE,
+	CULL_PATH_AVX2,
+	CULL_PATH_COUNT
+} cullPath_t;
+
+// Separate arrays so a batch of spheres loads straight into simd registers, padding is never visible
+typedef struct cullSpheres_t
+{
+	float* x;
+	float* y;
+	float* z;
+	float* radius;
+	size_t count;
+} cullSpheres_t;
+
+cullSpheres_t* cullSpheresCreate(size_t count);
+void cullSpheresDestroy(cullSpheres_t* spheres);
+void cullSpheresSet(cullSpheres_t* spheres, size_t index, const vec3 center, float radius);
+
+// Fastest path the cpu supports, detected once
+cullPath_t cullGetPath();
+bool cullPathSupported(cullPath_t path);
+const char* cullPathName(cullPath_t path);
+
+// Writes the indices of the spheres touching the frustum to 'visible' (spheres->count big) in order & returns how many
+size_t cullFrustumSpheres(const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible);
+size_t cullFrustumSpheresPath(cullPath_t path, const frustum_t* frustum, const cullSpheres_t* spheres, uint32_t* visible);
+
+#endif //CULL_H
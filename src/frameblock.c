@@ -0,0 +1,42 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "frameblock.h"
+
+_Static_assert(offsetof(frameBlock_t, time) == 332 && sizeof(frameBlock_t) == 352,
+			   "frameBlock_t has to match the std140 Frame block");
+
+GLuint frameBlockCreate()
+{
+	GLuint buffer;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, sizeof(frameBlock_t), NULL, GL_DYNAMIC_STORAGE_BIT);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, buffer);
+	return buffer;
+}
+
+void frameBlockDestroy(const GLuint buffer)
+{
+	glDeleteBuffers(1, &buffer);
+}
+
+void frameBlockUpdate(const GLuint buffer, const camera_t* camera, mat4 view, mat4 projection, const float time,
+					  const GLsizei width, const GLsizei height)
+{
+	frameBlock_t block;
+	glm_mat4_copy(view, block.view);
+	glm_mat4_copy(projection, block.projection);
+	glm_mat4_mul(projection, view, block.viewProjection);
+	glm_mat4_inv(view, block.inverseView);
+	glm_mat4_inv(projection, block.inverseProjection);
+	memcpy(block.viewPos, camera->position, sizeof(vec3));
+	block.time = time;
+	block.viewportSize[0] = (float) width;
+	block.viewportSize[1] = (float) height;
+	block.padding[0] = block.padding[1] = 0.f;
+	glNamedBufferSubData(buffer, 0, sizeof(frameBlock_t), &block);
+}
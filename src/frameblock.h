@@ -0,0 +1,38 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Per frame camera uniform block every shader program reads (resources/shaders/frame.glsl), written once a frame
+ */
+
+#ifndef FRAMEBLOCK_H
+#define FRAMEBLOCK_H
+
+#include <glad/glad.h>
+#include <cglm/cglm.h>
+
+#include "camera.h"
+
+#define FRAME_BLOCK_BINDING 0 // layout(binding) of the Frame block in frame.glsl
+
+// std140 Frame in frame.glsl
+typedef struct frameBlock_t
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	mat4 inverseView;
+	mat4 inverseProjection;
+	vec3 viewPos;
+	float time;
+	vec2 viewportSize;
+	vec2 padding;
+} frameBlock_t;
+
+// The buffer stays bound to FRAME_BLOCK_BINDING, nothing else uses that binding
+GLuint frameBlockCreate();
+void frameBlockDestroy(GLuint buffer);
+
+// Fills the block from the camera & the frame's matrices & uploads it in one go
+void frameBlockUpdate(GLuint buffer, const camera_t* camera, mat4 view, mat4 projection, float time, GLsizei width,
+					  GLsizei height);
+
+#endif //FRAMEBLOCK_H
@@ -9,6 +9,7 @@
 #include "GLFW/glfw3.h"
 
 #include "framebuffer.h"
+#include "glstate.h"
 
 void destroyTexturesAndFBO(const framebuffer_t* framebuffer);
 
@@ -26,6 +27,7 @@ void destroyTexturesAndFBO(const framebuffer_t* framebuffer)
 	glDeleteTextures(1, &framebuffer->depthTex);
 
 	glDeleteFramebuffers(1, &framebuffer->fbo);
+	glStateReset();
 }
 
 void framebufferDestroy(framebuffer_t* framebuffer)
@@ -47,6 +49,10 @@ bool framebufferInit(framebuffer_t* framebuffer)
 	glNamedFramebufferTexture(framebuffer->fbo, GL_COLOR_ATTACHMENT0, framebuffer->colorTex, 0);
 	glNamedFramebufferTexture(framebuffer->fbo, GL_DEPTH_ATTACHMENT, framebuffer->depthTex, 0);
 
+	// Per framebuffer state, so it's only set when the attachments change
+	glNamedFramebufferDrawBuffer(framebuffer->fbo, GL_COLOR_ATTACHMENT0);
+	glNamedFramebufferReadBuffer(framebuffer->fbo, GL_COLOR_ATTACHMENT0);
+
 	if (glCheckNamedFramebufferStatus(framebuffer->fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		return false;
 
@@ -77,18 +83,13 @@ void framebufferClear(const framebuffer_t* framebuffer)
 
 void framebufferBindToDraw(const framebuffer_t* framebuffer)
 {
-	const GLenum bufs[] = {GL_COLOR_ATTACHMENT0};
-	glNamedFramebufferDrawBuffers(framebuffer->fbo, 1, bufs);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer->fbo);
+	glStateBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer->fbo);
 }
 
 void framebufferCopyToDefault(const framebuffer_t* framebuffer)
 {
-	// Read from framebuffer's output to the default framebuffer
-	// This could be done once at init, doing here just to be safe
-	glNamedFramebufferReadBuffer(framebuffer->fbo, GL_COLOR_ATTACHMENT0);
-	glNamedFramebufferDrawBuffer(0, GL_BACK);
-
+	// Read from framebuffer's output to the default framebuffer, the read & draw buffers are set by framebufferInit
+	// & the default framebuffer always draws to GL_BACK
 	// Copy contents to default framebuffer
 	glBlitNamedFramebuffer(framebuffer->fbo, 0, 0, 0, framebuffer->width, framebuffer->height, 0, 0, framebuffer->width, framebuffer->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 }
@@ -0,0 +1,360 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "geometry.h"
+#include "glstate.h"
+#include "model.h"
+
+typedef struct geometryArenaSlot_t
+{
+	meshLayout_t layout;
+	geometryArena_t* arena;
+} geometryArenaSlot_t;
+
+static geometryArenaSlot_t arenas[GEOMETRY_MAX_ARENAS];
+static uint32_t numArenas = 0;
+
+static void freeListInsert(gpuAllocator_t* allocator, const uint32_t at, const gpuBlock_t block)
+{
+	if (allocator->numFree == allocator->maxFree)
+	{
+		const uint32_t maxFree = allocator->maxFree ? allocator->maxFree * 2 : 16;
+		gpuBlock_t* blocks = realloc(allocator->free, maxFree * sizeof(gpuBlock_t));
+		if (blocks == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate free list!\n");
+			exit(EXIT_FAILURE);
+		}
+		allocator->free = blocks;
+		allocator->maxFree = maxFree;
+	}
+	memmove(&allocator->free[at + 1], &allocator->free[at], (allocator->numFree - at) * sizeof(gpuBlock_t));
+	allocator->free[at] = block;
+	allocator->numFree++;
+}
+
+static void freeListRemove(gpuAllocator_t* allocator, const uint32_t at)
+{
+	memmove(&allocator->free[at], &allocator->free[at + 1], (allocator->numFree - at - 1) * sizeof(gpuBlock_t));
+	allocator->numFree--;
+}
+
+void gpuAllocatorInit(gpuAllocator_t* allocator, const uint32_t capacity)
+{
+	memset(allocator, 0, sizeof(gpuAllocator_t));
+	allocator->capacity = capacity;
+	if (capacity > 0)
+		freeListInsert(allocator, 0, (gpuBlock_t) {0, capacity});
+}
+
+void gpuAllocatorDestroy(gpuAllocator_t* allocator)
+{
+	free(allocator->free);
+	memset(allocator, 0, sizeof(gpuAllocator_t));
+}
+
+bool gpuAllocatorAlloc(gpuAllocator_t* allocator, const uint32_t size, gpuBlock_t* block)
+{
+	if (size == 0)
+	{
+		*block = (gpuBlock_t) {0, 0};
+		return true;
+	}
+
+	// Smallest block that fits keeps the big ones whole for big meshes
+	uint32_t best = UINT32_MAX;
+	for (uint32_t i = 0; i < allocator->numFree; i++)
+	{
+		if (allocator->free[i].size >= size && (best == UINT32_MAX || allocator->free[i].size < allocator->free[best].size))
+		{
+			best = i;
+			if (allocator->free[i].size == size)
+				break;
+		}
+	}
+	if (best == UINT32_MAX)
+		return false;
+
+	gpuBlock_t* freeBlock = &allocator->free[best];
+	*block = (gpuBlock_t) {freeBlock->offset, size};
+	freeBlock->offset += size;
+	freeBlock->size -= size;
+	if (freeBlock->size == 0)
+		freeListRemove(allocator, best);
+	allocator->used += size;
+	allocator->numAllocations++;
+	return true;
+}
+
+void gpuAllocatorFree(gpuAllocator_t* allocator, const gpuBlock_t block)
+{
+	if (block.size == 0)
+		return;
+
+	uint32_t at = 0;
+	while (at < allocator->numFree && allocator->free[at].offset < block.offset)
+		at++;
+
+	const bool mergePrevious = at > 0 && allocator->free[at - 1].offset + allocator->free[at - 1].size == block.offset;
+	const bool mergeNext = at < allocator->numFree && block.offset + block.size == allocator->free[at].offset;
+	if (mergePrevious && mergeNext)
+	{
+		allocator->free[at - 1].size += block.size + allocator->free[at].size;
+		freeListRemove(allocator, at);
+	} else if (mergePrevious)
+		allocator->free[at - 1].size += block.size;
+	else if (mergeNext)
+	{
+		allocator->free[at].offset = block.offset;
+		allocator->free[at].size += block.size;
+	} else
+		freeListInsert(allocator, at, block);
+
+	allocator->used -= block.size;
+	allocator->numAllocations--;
+}
+
+void gpuAllocatorGrow(gpuAllocator_t* allocator, const uint32_t capacity)
+{
+	if (capacity <= allocator->capacity)
+		return;
+	gpuBlock_t* last = allocator->numFree ? &allocator->free[allocator->numFree - 1] : NULL;
+	if (last && last->offset + last->size == allocator->capacity)
+		last->size += capacity - allocator->capacity;
+	else
+		freeListInsert(allocator, allocator->numFree, (gpuBlock_t) {allocator->capacity, capacity - allocator->capacity});
+	allocator->capacity = capacity;
+}
+
+gpuAllocatorStats_t gpuAllocatorGetStats(const gpuAllocator_t* allocator)
+{
+	gpuAllocatorStats_t stats = {
+		.capacity = allocator->capacity,
+		.used = allocator->used,
+		.numFreeBlocks = allocator->numFree,
+		.numAllocations = allocator->numAllocations
+	};
+	for (uint32_t i = 0; i < allocator->numFree; i++)
+		stats.largestFree = allocator->free[i].size > stats.largestFree ? allocator->free[i].size : stats.largestFree;
+
+	const uint32_t freeSize = allocator->capacity - allocator->used;
+	stats.occupancy = allocator->capacity ? (float) allocator->used / (float) allocator->capacity : 0.f;
+	stats.fragmentation = freeSize ? 1.f - (float) stats.largestFree / (float) freeSize : 0.f;
+	return stats;
+}
+
+static GLuint createBuffer(const size_t size)
+{
+	// Immutable, uploads go through glNamedBufferSubData
+	GLuint buffer;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, (GLsizeiptr) size, NULL, GL_DYNAMIC_STORAGE_BIT);
+	return buffer;
+}
+
+// Immutable storage can't be resized, so copy into a bigger buffer & point the vao at it, meshes only hold offsets
+static GLuint growBuffer(const GLuint buffer, const size_t oldSize, const size_t newSize)
+{
+	const GLuint newBuffer = createBuffer(newSize);
+	if (oldSize > 0)
+		glCopyNamedBufferSubData(buffer, newBuffer, 0, 0, (GLsizeiptr) oldSize);
+	glDeleteBuffers(1, &buffer);
+	return newBuffer;
+}
+
+static uint32_t growCapacity(const gpuAllocator_t* allocator, const uint32_t size)
+{
+	// Enough for the request even if the free space is scattered
+	uint64_t capacity = allocator->capacity ? allocator->capacity : 1;
+	while (capacity < (uint64_t) allocator->used + size)
+		capacity *= 2;
+	capacity *= 2;
+	if (capacity > UINT32_MAX)
+	{
+		fprintf(stderr, "Geometry arena is full! Failed to grow past %u!\n", allocator->capacity);
+		exit(EXIT_FAILURE);
+	}
+	return (uint32_t) capacity;
+}
+
+// Points a vao at the arena's buffers with the layout's attributes on binding 0
+static void setupVertexArray(const GLuint vao, const geometryArena_t* arena, const meshLayout_t* layout)
+{
+	glVertexArrayVertexBuffer(vao, 0, arena->vbo, 0, (GLsizei) arena->stride);
+	glVertexArrayElementBuffer(vao, arena->ebo);
+	for (uint32_t i = 0; i < layout->numAttributes; i++)
+	{
+		const meshAttribute_t* attribute = &layout->attributes[i];
+		if (attribute->integer)
+			glVertexArrayAttribIFormat(vao, attribute->location, (GLint) attribute->components, attribute->type,
+									   attribute->offset);
+		else
+			glVertexArrayAttribFormat(vao, attribute->location, (GLint) attribute->components, attribute->type,
+									  (GLboolean) attribute->normalized, attribute->offset);
+		glVertexArrayAttribBinding(vao, attribute->location, 0);
+		glEnableVertexArrayAttrib(vao, attribute->location);
+	}
+}
+
+// The arena slot for 'layout', numArenas if it has none yet. 'key' gets the layout to compare & store
+static uint32_t findArena(const meshLayout_t* layout, meshLayout_t* key)
+{
+	// Compare with unused attributes zeroed so stray bytes never split an arena
+	memset(key, 0, sizeof(meshLayout_t));
+	key->stride = layout->stride;
+	key->numAttributes = layout->numAttributes < MESH_MAX_ATTRIBUTES ? layout->numAttributes : MESH_MAX_ATTRIBUTES;
+	memcpy(key->attributes, layout->attributes, key->numAttributes * sizeof(meshAttribute_t));
+	uint32_t i = 0;
+	while (i < numArenas && memcmp(&arenas[i].layout, key, sizeof(meshLayout_t)) != 0)
+		i++;
+	return i;
+}
+
+bool geometryHasArena(const meshLayout_t* layout)
+{
+	meshLayout_t key;
+	return findArena(layout, &key) < numArenas || numArenas < GEOMETRY_MAX_ARENAS;
+}
+
+geometryArena_t* geometryArenaGet(const meshLayout_t* layout)
+{
+	meshLayout_t key;
+	const uint32_t found = findArena(layout, &key);
+	if (found < numArenas)
+		return arenas[found].arena;
+
+	if (numArenas == GEOMETRY_MAX_ARENAS)
+	{
+		fprintf(stderr, "Too many vertex layouts! Only %d geometry arenas are supported!\n", GEOMETRY_MAX_ARENAS);
+		exit(EXIT_FAILURE);
+	}
+	geometryArena_t* arena = malloc(sizeof(geometryArena_t));
+	if (arena == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate geometry arena!\n");
+		exit(EXIT_FAILURE);
+	}
+	arena->stride = key.stride;
+	arena->numGrows = 0;
+	gpuAllocatorInit(&arena->vertices, GEOMETRY_VERTEX_CAPACITY);
+	gpuAllocatorInit(&arena->indices, GEOMETRY_INDEX_CAPACITY);
+	arena->vbo = createBuffer((size_t) GEOMETRY_VERTEX_CAPACITY * key.stride);
+	arena->ebo = createBuffer(GEOMETRY_INDEX_CAPACITY);
+
+	glCreateVertexArrays(1, &arena->vao);
+	setupVertexArray(arena->vao, arena, &key);
+
+	// A mat4 attribute is 4 vec4 columns, stepping once per instance. Kept off the plain vao so only instanced draws
+	// ever see it
+	glCreateVertexArrays(1, &arena->instancedVao);
+	setupVertexArray(arena->instancedVao, arena, &key);
+	for (GLuint column = 0; column < 4; column++)
+	{
+		const GLuint location = GEOMETRY_INSTANCE_LOCATION + column;
+		glVertexArrayAttribFormat(arena->instancedVao, location, 4, GL_FLOAT, GL_FALSE, column * 4 * sizeof(float));
+		glVertexArrayAttribBinding(arena->instancedVao, location, GEOMETRY_INSTANCE_BINDING);
+		glEnableVertexArrayAttrib(arena->instancedVao, location);
+	}
+	glVertexArrayBindingDivisor(arena->instancedVao, GEOMETRY_INSTANCE_BINDING, 1);
+
+	arenas[numArenas].layout = key;
+	arenas[numArenas].arena = arena;
+	numArenas++;
+	return arena;
+}
+
+geometryRange_t geometryUpload(const meshLayout_t* layout, const uint32_t numVertices, const void* vertices,
+							   const uint32_t indexBytes, const void* indices)
+{
+	geometryRange_t range;
+	range.arena = geometryArenaGet(layout);
+	geometryArena_t* arena = range.arena;
+
+	if (!gpuAllocatorAlloc(&arena->vertices, numVertices, &range.vertices))
+	{
+		const uint32_t capacity = growCapacity(&arena->vertices, numVertices);
+		arena->vbo = growBuffer(arena->vbo, (size_t) arena->vertices.capacity * arena->stride, (size_t) capacity * arena->stride);
+		glVertexArrayVertexBuffer(arena->vao, 0, arena->vbo, 0, (GLsizei) arena->stride);
+		glVertexArrayVertexBuffer(arena->instancedVao, 0, arena->vbo, 0, (GLsizei) arena->stride);
+		gpuAllocatorGrow(&arena->vertices, capacity);
+		gpuAllocatorAlloc(&arena->vertices, numVertices, &range.vertices);
+		arena->numGrows++;
+	}
+
+	const uint32_t alignedIndexBytes = (indexBytes + GEOMETRY_INDEX_ALIGNMENT - 1) & ~(GEOMETRY_INDEX_ALIGNMENT - 1);
+	if (!gpuAllocatorAlloc(&arena->indices, alignedIndexBytes, &range.indices))
+	{
+		const uint32_t capacity = growCapacity(&arena->indices, alignedIndexBytes);
+		arena->ebo = growBuffer(arena->ebo, arena->indices.capacity, capacity);
+		glVertexArrayElementBuffer(arena->vao, arena->ebo);
+		glVertexArrayElementBuffer(arena->instancedVao, arena->ebo);
+		gpuAllocatorGrow(&arena->indices, capacity);
+		gpuAllocatorAlloc(&arena->indices, alignedIndexBytes, &range.indices);
+		arena->numGrows++;
+	}
+
+	if (numVertices > 0 && vertices)
+		glNamedBufferSubData(arena->vbo, (GLintptr) range.vertices.offset * arena->stride,
+							 (GLsizeiptr) numVertices * arena->stride, vertices);
+	if (indexBytes > 0 && indices)
+		glNamedBufferSubData(arena->ebo, range.indices.offset, indexBytes, indices);
+	return range;
+}
+
+void geometryRelease(geometryRange_t* range)
+{
+	if (range->arena == NULL)
+		return;
+	gpuAllocatorFree(&range->arena->vertices, range->vertices);
+	gpuAllocatorFree(&range->arena->indices, range->indices);
+	range->arena = NULL;
+}
+
+uint32_t geometryNumArenas()
+{
+	return numArenas;
+}
+
+geometryArena_t* geometryGetArena(const uint32_t i)
+{
+	return i < numArenas ? arenas[i].arena : NULL;
+}
+
+void geometryDestroyArenas()
+{
+	for (uint32_t i = 0; i < numArenas; i++)
+	{
+		geometryArena_t* arena = arenas[i].arena;
+		if (arena->vertices.numAllocations > 0 || arena->indices.numAllocations > 0)
+			fprintf(stderr, "Geometry arena %u still has %u meshes\n", i, arena->vertices.numAllocations);
+		glDeleteVertexArrays(1, &arena->vao);
+		glDeleteVertexArrays(1, &arena->instancedVao);
+		glDeleteBuffers(1, &arena->vbo);
+		glDeleteBuffers(1, &arena->ebo);
+		gpuAllocatorDestroy(&arena->vertices);
+		gpuAllocatorDestroy(&arena->indices);
+		free(arena);
+	}
+	numArenas = 0;
+	glStateReset();
+}
+
+void geometryPrintStats()
+{
+	for (uint32_t i = 0; i < numArenas; i++)
+	{
+		const geometryArena_t* arena = arenas[i].arena;
+		const gpuAllocatorStats_t vertices = gpuAllocatorGetStats(&arena->vertices);
+		const gpuAllocatorStats_t indices = gpuAllocatorGetStats(&arena->indices);
+		printf("Geometry arena %u (stride %u): %u meshes, vertices %u / %u (%.1f%% used, %.1f%% fragmented), "
+			   "indices %u / %u bytes (%.1f%% used, %.1f%% fragmented), grown %u times\n", i, arena->stride,
+			   vertices.numAllocations, vertices.used, vertices.capacity, vertices.occupancy * 100.f,
+			   vertices.fragmentation * 100.f, indices.used, indices.capacity, indices.occupancy * 100.f,
+			   indices.fragmentation * 100.f, arena->numGrows);
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glad/glad.h>
+
+#define GEOMETRY_MAX_ARENAS 8 // One per vertex layout
+#define GEOMETRY_VERTEX_CAPACITY (1 << 16) // Initial vertices per arena, doubles when full
+#define GEOMETRY_INDEX_CAPACITY (1 << 20) // Initial index bytes per arena, doubles when full
+#define GEOMETRY_INDEX_ALIGNMENT 4 // Index ranges start on 4 bytes so 16 & 32 bit indices can share a buffer
+#define GEOMETRY_INSTANCE_BINDING 1 // Where the instanced vao takes a buffer of per instance mat4s
+#define GEOMETRY_INSTANCE_LOCATION 3 // The mat4 takes this location & the next 3
+
+// Forward declared, model.h includes this
+typedef struct meshLayout_t meshLayout_t;
+
+typedef struct gpuBlock_t
+{
+	uint32_t offset;
+	uint32_t size;
+} gpuBlock_t;
+
+// Best fit over an offset sorted free list, freed blocks merge with their neighbours. Units are up to the caller
+typedef struct gpuAllocator_t
+{
+	uint32_t capacity;
+	uint32_t used;
+	uint32_t numAllocations;
+	uint32_t numFree;
+	uint32_t maxFree;
+	gpuBlock_t* free;
+} gpuAllocator_t;
+
+typedef struct gpuAllocatorStats_t
+{
+	uint32_t capacity;
+	uint32_t used;
+	uint32_t largestFree;
+	uint32_t numFreeBlocks;
+	uint32_t numAllocations;
+	float occupancy; // used / capacity
+	float fragmentation; // 1 - largestFree / free, 0 when all free space is one block
+} gpuAllocatorStats_t;
+
+// Every mesh with the same layout lives in these buffers & draws through the one vao
+typedef struct geometryArena_t
+{
+	GLuint vao, vbo, ebo;
+	// Same buffers plus a mat4 per instance, whoever draws instances attaches theirs to GEOMETRY_INSTANCE_BINDING
+	GLuint instancedVao;
+	uint32_t stride;
+	gpuAllocator_t vertices; // In vertices, so an allocation's offset is its base vertex
+	gpuAllocator_t indices; // In bytes
+	uint32_t numGrows;
+} geometryArena_t;
+
+// A mesh's place in an arena
+typedef struct geometryRange_t
+{
+	geometryArena_t* arena;
+	gpuBlock_t vertices;
+	gpuBlock_t indices;
+} geometryRange_t;
+
+void gpuAllocatorInit(gpuAllocator_t* allocator, uint32_t capacity);
+void gpuAllocatorDestroy(gpuAllocator_t* allocator);
+// False if no free block is big enough, 'size' of 0 always succeeds with an empty block
+bool gpuAllocatorAlloc(gpuAllocator_t* allocator, uint32_t size, gpuBlock_t* block);
+void gpuAllocatorFree(gpuAllocator_t* allocator, gpuBlock_t block);
+// Adds the new space to the end
+void gpuAllocatorGrow(gpuAllocator_t* allocator, uint32_t capacity);
+gpuAllocatorStats_t gpuAllocatorGetStats(const gpuAllocator_t* allocator);
+
+// Finds or creates the arena for 'layout', needs a GL context
+geometryArena_t* geometryArenaGet(const meshLayout_t* layout);
+// False if 'layout' has no arena & there's no room left for one, geometryArenaGet would exit
+bool geometryHasArena(const meshLayout_t* layout);
+// Uploads into the layout's arena, growing its buffers if they're full
+geometryRange_t geometryUpload(const meshLayout_t* layout, uint32_t numVertices, const void* vertices, uint32_t indexBytes,
+							   const void* indices);
+void geometryRelease(geometryRange_t* range);
+uint32_t geometryNumArenas();
+geometryArena_t* geometryGetArena(uint32_t i);
+// Call once every mesh is destroyed
+void geometryDestroyArenas();
+void geometryPrintStats();
+
+#endif //GEOMETRY_H
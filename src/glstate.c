@@ -0,0 +1,168 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include "glstate.h"
+
+// Never a real name or enum, whatever is set next doesn't match it
+#define UNKNOWN UINT32_MAX
+
+enum
+{
+	CAP_DEPTH_TEST,
+	CAP_BLEND,
+	CAP_CULL_FACE,
+	CAP_COUNT
+};
+
+static const GLenum caps[CAP_COUNT] = {GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE};
+
+// Zeroed is GL's own initial state for the names, so the counts still hold if nothing ever resets
+static struct
+{
+	GLuint program;
+	GLuint vao;
+	GLuint textures[GL_STATE_TEXTURE_UNITS];
+	GLuint samplers[GL_STATE_TEXTURE_UNITS];
+	GLuint drawFramebuffer;
+	GLuint readFramebuffer;
+
+	uint32_t enabled[CAP_COUNT]; // 0, 1 or UNKNOWN
+	GLenum depthFunc;
+	uint32_t depthMask;
+	GLenum blendSource;
+	GLenum blendDestination;
+	GLenum cullFace;
+
+	glStateStats_t stats;
+} state = {.enabled = {UNKNOWN, UNKNOWN, UNKNOWN}, .depthFunc = UNKNOWN, .depthMask = UNKNOWN, .blendSource = UNKNOWN,
+		   .blendDestination = UNKNOWN, .cullFace = UNKNOWN};
+
+// Records 'value' & returns true if it's a change, so the caller issues it
+static bool update(uint32_t* shadow, const uint32_t value)
+{
+	if (*shadow == value)
+	{
+		state.stats.elided++;
+		return false;
+	}
+	*shadow = value;
+	state.stats.issued++;
+	return true;
+}
+
+void glStateReset()
+{
+	state.program = state.vao = UNKNOWN;
+	for (uint32_t i = 0; i < GL_STATE_TEXTURE_UNITS; i++)
+		state.textures[i] = state.samplers[i] = UNKNOWN;
+	state.drawFramebuffer = state.readFramebuffer = UNKNOWN;
+	for (uint32_t i = 0; i < CAP_COUNT; i++)
+		state.enabled[i] = UNKNOWN;
+	state.depthFunc = state.depthMask = UNKNOWN;
+	state.blendSource = state.blendDestination = UNKNOWN;
+	state.cullFace = UNKNOWN;
+}
+
+void glStateUseProgram(const GLuint program)
+{
+	if (update(&state.program, program))
+		glUseProgram(program);
+}
+
+void glStateBindVertexArray(const GLuint vao)
+{
+	if (update(&state.vao, vao))
+		glBindVertexArray(vao);
+}
+
+void glStateBindTextureUnit(const GLuint unit, const GLuint texture)
+{
+	if (unit >= GL_STATE_TEXTURE_UNITS)
+	{
+		state.stats.issued++;
+		glBindTextureUnit(unit, texture);
+	} else if (update(&state.textures[unit], texture))
+		glBindTextureUnit(unit, texture);
+}
+
+void glStateBindSampler(const GLuint unit, const GLuint sampler)
+{
+	if (unit >= GL_STATE_TEXTURE_UNITS)
+	{
+		state.stats.issued++;
+		glBindSampler(unit, sampler);
+	} else if (update(&state.samplers[unit], sampler))
+		glBindSampler(unit, sampler);
+}
+
+void glStateBindFramebuffer(const GLenum target, const GLuint framebuffer)
+{
+	if (target == GL_FRAMEBUFFER)
+	{
+		// One call covers both, it's only skipped if neither changes
+		if (state.drawFramebuffer == framebuffer && state.readFramebuffer == framebuffer)
+		{
+			state.stats.elided++;
+			return;
+		}
+		state.drawFramebuffer = state.readFramebuffer = framebuffer;
+		state.stats.issued++;
+		glBindFramebuffer(target, framebuffer);
+	} else if (update(target == GL_DRAW_FRAMEBUFFER ? &state.drawFramebuffer : &state.readFramebuffer, framebuffer))
+		glBindFramebuffer(target, framebuffer);
+}
+
+void glStateSetEnabled(const GLenum cap, const bool enabled)
+{
+	uint32_t i = 0;
+	while (i < CAP_COUNT && caps[i] != cap)
+		i++;
+	if (i == CAP_COUNT)
+		state.stats.issued++;
+	else if (!update(&state.enabled[i], enabled))
+		return;
+
+	if (enabled)
+		glEnable(cap);
+	else
+		glDisable(cap);
+}
+
+void glStateDepthFunc(const GLenum func)
+{
+	if (update(&state.depthFunc, func))
+		glDepthFunc(func);
+}
+
+void glStateDepthMask(const GLboolean mask)
+{
+	if (update(&state.depthMask, mask))
+		glDepthMask(mask);
+}
+
+void glStateBlendFunc(const GLenum source, const GLenum destination)
+{
+	if (state.blendSource == source && state.blendDestination == destination)
+	{
+		state.stats.elided++;
+		return;
+	}
+	state.blendSource = source;
+	state.blendDestination = destination;
+	state.stats.issued++;
+	glBlendFunc(source, destination);
+}
+
+void glStateCullFace(const GLenum mode)
+{
+	if (update(&state.cullFace, mode))
+		glCullFace(mode);
+}
+
+glStateStats_t glStateEndFrame()
+{
+	const glStateStats_t stats = state.stats;
+	state.stats = (glStateStats_t) {0, 0};
+	return stats;
+}
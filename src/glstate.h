@@ -0,0 +1,43 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Shadow of the bound GL state, calls that wouldn't change anything are skipped & counted instead of reaching the driver
+ */
+
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glad/glad.h>
+
+#define GL_STATE_TEXTURE_UNITS 16 // Units past this are always issued
+
+typedef struct glStateStats_t
+{
+	uint32_t issued;
+	uint32_t elided;
+} glStateStats_t;
+
+// Forgets everything, so the next call of each kind is issued. Needed once the context is current & after deleting
+// anything that might be bound, a deleted name can come back from the next glCreate*
+void glStateReset();
+
+void glStateUseProgram(GLuint program);
+void glStateBindVertexArray(GLuint vao);
+void glStateBindTextureUnit(GLuint unit, GLuint texture);
+void glStateBindSampler(GLuint unit, GLuint sampler);
+// GL_FRAMEBUFFER sets both the draw & read binding
+void glStateBindFramebuffer(GLenum target, GLuint framebuffer);
+
+// Only GL_DEPTH_TEST, GL_BLEND & GL_CULL_FACE are shadowed, other caps are always issued
+void glStateSetEnabled(GLenum cap, bool enabled);
+void glStateDepthFunc(GLenum func);
+void glStateDepthMask(GLboolean mask);
+void glStateBlendFunc(GLenum source, GLenum destination);
+void glStateCullFace(GLenum mode);
+
+// Calls issued & elided since the last end of frame, then starts counting again
+glStateStats_t glStateEndFrame();
+
+#endif //GLSTATE_H
@@ -0,0 +1,781 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "gltf.h"
+#include "json.h"
+#include "util.h"
+
+#define GLTF_MODE_TRIANGLES 4
+
+typedef struct gltfFile_t
+{
+	char directory[MATERIAL_PATH_LENGTH]; // External images are relative to the glb
+	mappedFile_t file;
+	bool mapped;
+	json_t* json;
+	const unsigned char* bin;
+	uint64_t binSize;
+} gltfFile_t;
+
+// Where an accessor's elements are in the binary chunk
+typedef struct gltfAccessor_t
+{
+	const unsigned char* data; // First element
+	uint32_t count;
+	uint32_t components; // 1 for SCALAR to 4 for VEC4
+	uint32_t componentType; // glTF uses the GL enums, GL_FLOAT etc.
+	uint32_t stride; // In bytes, tightly packed unless the buffer view says otherwise
+	bool normalized;
+	int32_t bufferView; // Accessors sharing one & its stride are interleaved
+} gltfAccessor_t;
+
+static uint32_t readU32(const char* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static bool openGLB(gltfFile_t* gltf, const char* filename)
+{
+	memset(gltf, 0, sizeof(gltfFile_t));
+	const char* slash = strrchr(filename, '/');
+	const char* backslash = strrchr(filename, '\\');
+	if (backslash > slash)
+		slash = backslash;
+	if (slash && (size_t) (slash - filename + 1) < sizeof(gltf->directory))
+	{
+		memcpy(gltf->directory, filename, slash - filename + 1);
+		gltf->directory[slash - filename + 1] = '\0';
+	}
+
+	gltf->mapped = fileMap(filename, &gltf->file);
+	if (!gltf->mapped)
+		return false;
+	const char* data = gltf->file.data;
+	const size_t size = gltf->file.size;
+	if (size < 20 || readU32(data) != GLTF_MAGIC || readU32(data + 4) != GLTF_VERSION || readU32(data + 8) > size)
+	{
+		fprintf(stderr, "%s isn't a glTF 2.0 binary\n", filename);
+		return false;
+	}
+
+	// A json chunk then an optional binary one, each 4 byte aligned
+	const uint64_t jsonLength = readU32(data + 12);
+	if (readU32(data + 16) != GLTF_CHUNK_JSON || 20 + jsonLength > size)
+	{
+		fprintf(stderr, "%s has no json chunk\n", filename);
+		return false;
+	}
+	const uint64_t binChunk = 20 + ((jsonLength + 3) & ~3ull);
+	if (binChunk + 8 <= size && readU32(data + binChunk + 4) == GLTF_CHUNK_BIN)
+	{
+		gltf->binSize = readU32(data + binChunk);
+		gltf->bin = (const unsigned char*) data + binChunk + 8;
+		if (binChunk + 8 + gltf->binSize > size)
+		{
+			fprintf(stderr, "%s has a truncated binary chunk\n", filename);
+			return false;
+		}
+	}
+
+	gltf->json = jsonParse(data + 20, jsonLength);
+	if (gltf->json == NULL)
+		fprintf(stderr, "%s has invalid json\n", filename);
+	return gltf->json != NULL;
+}
+
+static void closeGLB(gltfFile_t* gltf)
+{
+	if (gltf->json)
+		jsonDestroy(gltf->json);
+	if (gltf->mapped)
+		fileUnmap(&gltf->file);
+}
+
+static int32_t getArray(const gltfFile_t* gltf, const char* name, const int32_t index)
+{
+	return jsonIndex(gltf->json, jsonGet(gltf->json, 0, name), (uint32_t) index);
+}
+
+static int32_t getInt(const gltfFile_t* gltf, const int32_t object, const char* key, const int32_t fallback)
+{
+	return (int32_t) jsonNumber(gltf->json, jsonGet(gltf->json, object, key), fallback);
+}
+
+static uint32_t componentSize(const uint32_t componentType)
+{
+	switch (componentType)
+	{
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+			return 2;
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return 4;
+		default:
+			return 0;
+	}
+}
+
+// Buffer view 'index' as a range of the binary chunk, only the glb's own buffer is supported
+static const unsigned char* getBufferView(const gltfFile_t* gltf, const int32_t index, uint64_t* length, uint32_t* stride)
+{
+	const int32_t view = getArray(gltf, "bufferViews", index);
+	const int32_t buffer = getArray(gltf, "buffers", getInt(gltf, view, "buffer", -1));
+	if (view < 0 || buffer < 0 || jsonGet(gltf->json, buffer, "uri") >= 0 || gltf->bin == NULL)
+		return NULL;
+	const double offset = jsonNumber(gltf->json, jsonGet(gltf->json, view, "byteOffset"), 0.);
+	*length = (uint64_t) jsonNumber(gltf->json, jsonGet(gltf->json, view, "byteLength"), 0.);
+	*stride = (uint32_t) getInt(gltf, view, "byteStride", 0);
+	if (offset < 0. || (uint64_t) offset + *length > gltf->binSize)
+		return NULL;
+	return gltf->bin + (uint64_t) offset;
+}
+
+static bool getAccessor(const gltfFile_t* gltf, const int32_t index, gltfAccessor_t* accessor)
+{
+	const int32_t object = getArray(gltf, "accessors", index);
+	if (object < 0 || jsonGet(gltf->json, object, "sparse") >= 0)
+		return false;
+
+	static const char* types[] = {"SCALAR", "VEC2", "VEC3", "VEC4"};
+	const int32_t type = jsonGet(gltf->json, object, "type");
+	accessor->components = 0;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		if (jsonStringEquals(gltf->json, type, types[i]))
+			accessor->components = i + 1;
+	}
+	accessor->componentType = (uint32_t) getInt(gltf, object, "componentType", 0);
+	accessor->count = (uint32_t) getInt(gltf, object, "count", 0);
+	accessor->normalized = jsonBool(gltf->json, jsonGet(gltf->json, object, "normalized"), false);
+	const uint32_t elementSize = accessor->components * componentSize(accessor->componentType);
+	if (elementSize == 0)
+		return false;
+
+	uint64_t length;
+	uint32_t stride;
+	accessor->bufferView = getInt(gltf, object, "bufferView", -1);
+	const unsigned char* view = getBufferView(gltf, accessor->bufferView, &length, &stride);
+	const uint64_t offset = (uint64_t) getInt(gltf, object, "byteOffset", 0);
+	accessor->stride = stride ? stride : elementSize;
+	// The last element only needs its own size, not a whole stride
+	if (view == NULL || (accessor->count > 0 && offset + (uint64_t) accessor->stride * (accessor->count - 1) + elementSize > length))
+		return false;
+	accessor->data = view + offset;
+	return true;
+}
+
+// Element 'i' as floats, normalized integers are mapped to [0, 1] or [-1, 1]
+static void readFloats(const gltfAccessor_t* accessor, const uint32_t i, float* values, const uint32_t count)
+{
+	const unsigned char* element = accessor->data + (size_t) i * accessor->stride;
+	for (uint32_t c = 0; c < count; c++)
+	{
+		if (c >= accessor->components)
+		{
+			values[c] = 0.f;
+			continue;
+		}
+		switch (accessor->componentType)
+		{
+			case GL_FLOAT:
+				memcpy(&values[c], element + c * 4, sizeof(float));
+				break;
+			case GL_UNSIGNED_BYTE:
+				values[c] = (float) element[c] / (accessor->normalized ? 255.f : 1.f);
+				break;
+			case GL_BYTE:
+				values[c] = accessor->normalized ? glm_max((float) (signed char) element[c] / 127.f, -1.f) : (float) (signed char) element[c];
+				break;
+			case GL_UNSIGNED_SHORT:
+			{
+				uint16_t value;
+				memcpy(&value, element + c * 2, sizeof(value));
+				values[c] = (float) value / (accessor->normalized ? 65535.f : 1.f);
+				break;
+			}
+			case GL_SHORT:
+			{
+				int16_t value;
+				memcpy(&value, element + c * 2, sizeof(value));
+				values[c] = accessor->normalized ? glm_max((float) value / 32767.f, -1.f) : (float) value;
+				break;
+			}
+			default:
+			{
+				uint32_t value;
+				memcpy(&value, element + c * 4, sizeof(value));
+				values[c] = (float) value;
+				break;
+			}
+		}
+	}
+}
+
+static uint32_t readIndex(const gltfAccessor_t* accessor, const uint32_t i)
+{
+	const unsigned char* element = accessor->data + (size_t) i * accessor->stride;
+	if (accessor->componentType == GL_UNSIGNED_BYTE)
+		return element[0];
+	if (accessor->componentType == GL_UNSIGNED_SHORT)
+	{
+		uint16_t index;
+		memcpy(&index, element, sizeof(index));
+		return index;
+	}
+	uint32_t index;
+	memcpy(&index, element, sizeof(index));
+	return index;
+}
+
+static void* allocArray(const size_t count, const size_t size)
+{
+	void* array = calloc(count ? count : 1, size);
+	if (array == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate glTF data!\n");
+		exit(EXIT_FAILURE);
+	}
+	return array;
+}
+
+// Area weighted, for primitives that come without normals
+static void computeNormals(float* vertices, const uint32_t* indices, const uint32_t numIndices)
+{
+	for (uint32_t i = 0; i + 2 < numIndices; i += 3)
+	{
+		float* v0 = &vertices[indices[i] * VERTEX_STRIDE];
+		float* v1 = &vertices[indices[i + 1] * VERTEX_STRIDE];
+		float* v2 = &vertices[indices[i + 2] * VERTEX_STRIDE];
+		vec3 e0, e1, normal;
+		glm_vec3_sub(v1, v0, e0);
+		glm_vec3_sub(v2, v0, e1);
+		glm_vec3_cross(e0, e1, normal);
+		glm_vec3_add(v0 + 3, normal, v0 + 3);
+		glm_vec3_add(v1 + 3, normal, v1 + 3);
+		glm_vec3_add(v2 + 3, normal, v2 + 3);
+	}
+	for (uint32_t i = 0; i < numIndices; i++)
+		glm_vec3_normalize(&vertices[indices[i] * VERTEX_STRIDE + 3]);
+}
+
+typedef struct gltfPrimitive_t
+{
+	gltfAccessor_t positions, normals, uvs, tangents, indices;
+	bool hasNormals, hasUvs, hasTangents, hasIndices;
+	int32_t material;
+} gltfPrimitive_t;
+
+static bool getPrimitive(const gltfFile_t* gltf, const int32_t object, gltfPrimitive_t* primitive)
+{
+	memset(primitive, 0, sizeof(gltfPrimitive_t));
+	if (getInt(gltf, object, "mode", GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES)
+		return false;
+	const int32_t attributes = jsonGet(gltf->json, object, "attributes");
+	if (!getAccessor(gltf, getInt(gltf, attributes, "POSITION", -1), &primitive->positions) ||
+		primitive->positions.components != 3 || primitive->positions.componentType != GL_FLOAT)
+		return false;
+
+	const uint32_t count = primitive->positions.count;
+	primitive->hasNormals = getAccessor(gltf, getInt(gltf, attributes, "NORMAL", -1), &primitive->normals) &&
+		primitive->normals.count == count && primitive->normals.components == 3;
+	primitive->hasUvs = getAccessor(gltf, getInt(gltf, attributes, "TEXCOORD_0", -1), &primitive->uvs) &&
+		primitive->uvs.count == count && primitive->uvs.components == 2;
+	primitive->hasTangents = getAccessor(gltf, getInt(gltf, attributes, "TANGENT", -1), &primitive->tangents) &&
+		primitive->tangents.count == count && primitive->tangents.components == 4;
+	primitive->hasIndices = jsonGet(gltf->json, object, "indices") >= 0;
+	if (primitive->hasIndices)
+	{
+		if (!getAccessor(gltf, getInt(gltf, object, "indices", -1), &primitive->indices) ||
+			primitive->indices.components != 1 || primitive->indices.componentType == GL_FLOAT ||
+			primitive->indices.componentType == GL_BYTE || primitive->indices.componentType == GL_SHORT)
+			return false;
+		for (uint32_t i = 0; i < primitive->indices.count; i++)
+		{
+			if (readIndex(&primitive->indices, i) >= count)
+				return false;
+		}
+	}
+	primitive->material = getInt(gltf, object, "material", -1);
+	return true;
+}
+
+// Where a primitive's interleaved vertices start, its first attribute in the buffer view
+static const unsigned char* firstAttribute(const gltfPrimitive_t* primitive)
+{
+	const unsigned char* first = primitive->positions.data;
+	first = primitive->normals.data < first ? primitive->normals.data : first;
+	first = primitive->uvs.data < first ? primitive->uvs.data : first;
+	return primitive->tangents.data < first ? primitive->tangents.data : first;
+}
+
+// glTF's own layout, if every primitive interleaves position, normal, uv & tangent in one buffer view & they all do it
+// the same way, so they share one arena & mesh. False if the mesh has to be converted instead
+static bool getDirectLayout(const gltfPrimitive_t* primitives, const uint32_t numPrimitives, meshLayout_t* layout)
+{
+	static const uint32_t locations[4] = {0, GLTF_NORMAL_LOCATION, 2, GLTF_TANGENT_LOCATION};
+	for (uint32_t p = 0; p < numPrimitives; p++)
+	{
+		// Missing normals & tangents are only generated on conversion
+		const gltfPrimitive_t* primitive = &primitives[p];
+		if (!primitive->hasNormals || !primitive->hasUvs || !primitive->hasTangents ||
+			primitive->normals.componentType != GL_FLOAT || primitive->tangents.componentType != GL_FLOAT ||
+			(primitive->uvs.componentType != GL_FLOAT && !primitive->uvs.normalized))
+			return false;
+
+		const gltfAccessor_t* accessors[4] = {&primitive->positions, &primitive->normals, &primitive->uvs, &primitive->tangents};
+		const unsigned char* first = firstAttribute(primitive);
+		meshLayout_t primitiveLayout;
+		memset(&primitiveLayout, 0, sizeof(meshLayout_t));
+		primitiveLayout.stride = primitive->positions.stride;
+		primitiveLayout.numAttributes = 4;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			const gltfAccessor_t* accessor = accessors[i];
+			const size_t offset = (size_t) (accessor->data - first);
+			if (accessor->bufferView != primitive->positions.bufferView || accessor->stride != primitiveLayout.stride ||
+				offset + accessor->components * componentSize(accessor->componentType) > primitiveLayout.stride)
+				return false;
+			primitiveLayout.attributes[i] = (meshAttribute_t) {locations[i], accessor->components, accessor->componentType,
+															   accessor->normalized, (uint32_t) offset, GL_FALSE};
+		}
+		if (p > 0 && memcmp(&primitiveLayout, layout, sizeof(meshLayout_t)) != 0)
+			return false;
+		*layout = primitiveLayout;
+	}
+	return true;
+}
+
+// Uploads the primitives' vertices as they are in the file, back to back. Only the indices are rewritten, each
+// primitive's are relative to its own vertices but the submeshes share the mesh's base vertex
+static mesh_t* createDirectMesh(const gltfFile_t* gltf, const gltfPrimitive_t* primitives, const uint32_t numPrimitives,
+								const meshLayout_t* layout, const uint32_t numVertices, const uint32_t numIndices)
+{
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+
+	// A lone primitive goes straight from the mapping, unless its last vertex's stride would run off the chunk
+	const unsigned char* vertices = firstAttribute(&primitives[0]);
+	if (numPrimitives > 1 || vertices + (size_t) numVertices * layout->stride > gltf->bin + gltf->binSize)
+	{
+		// The last vertex only has to reach the end of its last attribute, like getAccessor checks
+		uint32_t vertexEnd = 0;
+		for (uint32_t i = 0; i < layout->numAttributes; i++)
+		{
+			const meshAttribute_t* attribute = &layout->attributes[i];
+			const uint32_t end = attribute->offset + attribute->components * componentSize(attribute->type);
+			vertexEnd = end > vertexEnd ? end : vertexEnd;
+		}
+		unsigned char* staged = arenaAlloc(scratch, (size_t) numVertices * layout->stride);
+		size_t offset = 0;
+		for (uint32_t p = 0; p < numPrimitives; p++)
+		{
+			const uint32_t count = primitives[p].positions.count;
+			if (count > 0)
+				memcpy(staged + offset, firstAttribute(&primitives[p]), (size_t) (count - 1) * layout->stride + vertexEnd);
+			offset += (size_t) count * layout->stride;
+		}
+		vertices = staged;
+	}
+
+	const GLenum indexType = numVertices > 65536 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	uint16_t* indices16 = arenaAlloc(scratch, (size_t) numIndices * (indexType == GL_UNSIGNED_INT ? 4 : 2));
+	uint32_t* indices32 = (uint32_t*) indices16;
+	meshSubmesh_t* submeshes = arenaAllocZero(scratch, numPrimitives * sizeof(meshSubmesh_t));
+	vec3 boundsMin = {FLT_MAX, FLT_MAX, FLT_MAX}, boundsMax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	uint32_t baseVertex = 0, firstIndex = 0;
+	for (uint32_t p = 0; p < numPrimitives; p++)
+	{
+		const gltfPrimitive_t* primitive = &primitives[p];
+		const uint32_t count = primitive->positions.count;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			vec3 position;
+			readFloats(&primitive->positions, i, position, 3);
+			glm_vec3_minv(boundsMin, position, boundsMin);
+			glm_vec3_maxv(boundsMax, position, boundsMax);
+		}
+
+		const uint32_t indexCount = primitive->hasIndices ? primitive->indices.count : count;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			const uint32_t index = baseVertex + (primitive->hasIndices ? readIndex(&primitive->indices, i) : i);
+			if (indexType == GL_UNSIGNED_INT)
+				indices32[firstIndex + i] = index;
+			else
+				indices16[firstIndex + i] = (uint16_t) index;
+		}
+		submeshes[p].lods[0] = (meshLod_t) {firstIndex, indexCount, 0.f};
+
+		baseVertex += count;
+		firstIndex += indexCount;
+	}
+
+	mesh_t* mesh = meshCreateFromBuffers(layout, (GLsizei) numVertices, vertices, (GLsizei) numIndices, indexType, indices16,
+										 NULL, 0, boundsMin, boundsMax);
+	meshSetSubmeshes(mesh, submeshes, numPrimitives, NULL);
+	mesh->gltfVertices = true;
+	arenaRewind(scratchMark);
+	return mesh;
+}
+
+// Reads the primitives into the float layout, generating what's missing, for everything getDirectLayout can't take
+static mesh_t* convertMesh(const gltfPrimitive_t* primitives, const uint32_t numPrimitives, const uint32_t numVertices,
+						   const uint32_t numIndices, const char* name)
+{
+	bool allTangents = true;
+	for (uint32_t p = 0; p < numPrimitives; p++)
+		allTangents = allTangents && primitives[p].hasTangents;
+
+	meshData_t* data = allocArray(1, sizeof(meshData_t));
+	data->vertices = array_float_create(numVertices * VERTEX_STRIDE);
+	array_float_resize_uninitialized(&data->vertices, numVertices * VERTEX_STRIDE);
+	memset(data->vertices->array, 0, numVertices * VERTEX_STRIDE * sizeof(float));
+	data->indices = allocArray(numIndices, sizeof(uint32_t));
+	data->tangents = allTangents ? allocArray(numVertices, 4 * sizeof(float)) : NULL;
+	data->submeshes = allocArray(numPrimitives, sizeof(meshSubmesh_t));
+	data->numSubmeshes = numPrimitives;
+	data->numVertices = numVertices;
+	data->numIndices = numIndices;
+	data->numLods = 1;
+	data->lods[0] = (meshLod_t) {0, numIndices, 0.f};
+	glm_vec3_copy((vec3){FLT_MAX, FLT_MAX, FLT_MAX}, data->boundsMin);
+	glm_vec3_copy((vec3){-FLT_MAX, -FLT_MAX, -FLT_MAX}, data->boundsMax);
+
+	uint32_t baseVertex = 0, firstIndex = 0;
+	for (uint32_t p = 0; p < numPrimitives; p++)
+	{
+		const gltfPrimitive_t* primitive = &primitives[p];
+		const uint32_t count = primitive->positions.count;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float* vertex = &data->vertices->array[(baseVertex + i) * VERTEX_STRIDE];
+			readFloats(&primitive->positions, i, vertex, 3);
+			glm_vec3_minv(data->boundsMin, vertex, data->boundsMin);
+			glm_vec3_maxv(data->boundsMax, vertex, data->boundsMax);
+			if (primitive->hasNormals)
+				readFloats(&primitive->normals, i, vertex + 3, 3);
+			if (primitive->hasUvs)
+			{
+				// glTF's uvs start at the top left, textures are loaded flipped like everything else
+				readFloats(&primitive->uvs, i, vertex + 6, 2);
+				vertex[7] = 1.f - vertex[7];
+			}
+			if (data->tangents)
+			{
+				// The v flip mirrors the bitangent
+				float* tangent = &data->tangents[(baseVertex + i) * 4];
+				readFloats(&primitive->tangents, i, tangent, 4);
+				tangent[3] = tangent[3] < 0.f ? 1.f : -1.f;
+			}
+		}
+
+		uint32_t* indices = &data->indices[firstIndex];
+		const uint32_t indexCount = primitive->hasIndices ? primitive->indices.count : count;
+		for (uint32_t i = 0; i < indexCount; i++)
+			indices[i] = baseVertex + (primitive->hasIndices ? readIndex(&primitive->indices, i) : i);
+		if (!primitive->hasNormals)
+			computeNormals(data->vertices->array, indices, indexCount);
+		data->submeshes[p].lods[0] = (meshLod_t) {firstIndex, indexCount, 0.f};
+
+		baseVertex += count;
+		firstIndex += indexCount;
+	}
+
+	if (data->tangents)
+		meshDataBuildGpuVertices(data);
+	else
+		meshDataBuildTangents(data, name);
+	mesh_t* mesh = meshCreateFromData(data);
+	meshDataDestroy(data);
+	return mesh;
+}
+
+// Every triangle primitive of glTF mesh 'index' as one submesh each, NULL if none are usable. Uploaded in glTF's own
+// layout when it's interleaved, otherwise converted
+static mesh_t* loadMesh(const gltfFile_t* gltf, const int32_t index, const char* name, materialLibrary_t* materials,
+						bool* direct)
+{
+	const int32_t primitives = jsonGet(gltf->json, getArray(gltf, "meshes", index), "primitives");
+	const uint32_t numPrimitives = jsonSize(gltf->json, primitives);
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	gltfPrimitive_t* loaded = arenaAlloc(scratch, numPrimitives * sizeof(gltfPrimitive_t));
+
+	uint32_t numLoaded = 0, numVertices = 0, numIndices = 0;
+	for (uint32_t i = 0; i < numPrimitives; i++)
+	{
+		gltfPrimitive_t* primitive = &loaded[numLoaded];
+		if (!getPrimitive(gltf, jsonIndex(gltf->json, primitives, i), primitive))
+		{
+			fprintf(stderr, "Mesh %s primitive %u skipped, only valid triangle lists are supported\n", name, i);
+			continue;
+		}
+		numVertices += primitive->positions.count;
+		numIndices += primitive->hasIndices ? primitive->indices.count : primitive->positions.count;
+		numLoaded++;
+	}
+	if (numLoaded == 0 || numVertices == 0)
+	{
+		arenaRewind(scratchMark);
+		return NULL;
+	}
+
+	meshLayout_t layout;
+	// Files with more layouts than there are arenas left get the rest converted to the float layout
+	*direct = getDirectLayout(loaded, numLoaded, &layout) && geometryHasArena(&layout);
+	mesh_t* mesh = *direct ? createDirectMesh(gltf, loaded, numLoaded, &layout, numVertices, numIndices) :
+		convertMesh(loaded, numLoaded, numVertices, numIndices, name);
+
+	// Submeshes are the loaded primitives in order, their materials index the scene's library
+	mesh->materials = materials;
+	for (uint32_t s = 0; s < mesh->numSubmeshes; s++)
+	{
+		const int32_t material = loaded[s].material;
+		snprintf(mesh->submeshes[s].material, sizeof(mesh->submeshes[s].material), "%d", material);
+		mesh->submeshes[s].materialIndex = material >= 0 && (uint32_t) material < materials->numMaterials ? material : -1;
+	}
+	arenaRewind(scratchMark);
+	return mesh;
+}
+
+// Embedded images are decoded once & shared, external ones become map paths for materialLibraryLoadTextures
+static void loadImage(const gltfFile_t* gltf, const int32_t textureInfo, GLuint* images, GLuint* texture, char* path,
+					  unsigned int* flags, const unsigned int flag)
+{
+	if (textureInfo < 0)
+		return;
+	const int32_t textureObject = getArray(gltf, "textures", getInt(gltf, textureInfo, "index", -1));
+	const int32_t imageIndex = getInt(gltf, textureObject, "source", -1);
+	const int32_t image = getArray(gltf, "images", imageIndex);
+	if (image < 0)
+		return;
+
+	char uri[MATERIAL_PATH_LENGTH];
+	if (jsonString(gltf->json, jsonGet(gltf->json, image, "uri"), uri, sizeof(uri)))
+	{
+		if (strncmp(uri, "data:", 5) == 0)
+		{
+			fprintf(stderr, "glTF data uri images aren't supported\n");
+			return;
+		}
+		snprintf(path, MATERIAL_PATH_LENGTH, "%s%s", gltf->directory, uri);
+		*flags |= flag;
+		return;
+	}
+
+	if (images[imageIndex] == 0)
+	{
+		uint64_t length;
+		uint32_t stride;
+		const unsigned char* data = getBufferView(gltf, getInt(gltf, image, "bufferView", -1), &length, &stride);
+		if (data == NULL)
+			return;
+		char name[MATERIAL_NAME_LENGTH];
+		if (!jsonString(gltf->json, jsonGet(gltf->json, image, "name"), name, sizeof(name)) || name[0] == '\0')
+			snprintf(name, sizeof(name), "glb image %d", imageIndex);
+		images[imageIndex] = loadTextureFromMemory(data, (size_t) length, name, GL_REPEAT, GL_REPEAT);
+	}
+	*texture = images[imageIndex];
+	*flags |= flag;
+}
+
+// Metallic/roughness mapped onto what the phong shader takes, metallicRoughnessTexture is ignored
+static materialLibrary_t* loadMaterials(const gltfFile_t* gltf)
+{
+	materialLibrary_t* library = allocArray(1, sizeof(materialLibrary_t));
+	const int32_t materials = jsonGet(gltf->json, 0, "materials");
+	library->numMaterials = jsonSize(gltf->json, materials);
+	library->materials = allocArray(library->numMaterials, sizeof(material_t));
+	const uint32_t numImages = jsonSize(gltf->json, jsonGet(gltf->json, 0, "images"));
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	GLuint* images = arenaAllocZero(scratch, numImages * sizeof(GLuint));
+
+	for (uint32_t i = 0; i < library->numMaterials; i++)
+	{
+		const int32_t object = jsonIndex(gltf->json, materials, i);
+		material_t* material = &library->materials[i];
+		if (!jsonString(gltf->json, jsonGet(gltf->json, object, "name"), material->name, sizeof(material->name)) ||
+			material->name[0] == '\0')
+			snprintf(material->name, sizeof(material->name), "material %u", i);
+
+		const int32_t pbr = jsonGet(gltf->json, object, "pbrMetallicRoughness");
+		const int32_t baseColor = jsonGet(gltf->json, pbr, "baseColorFactor");
+		for (uint32_t c = 0; c < 3; c++)
+			material->diffuse[c] = (float) jsonNumber(gltf->json, jsonIndex(gltf->json, baseColor, c), 1.);
+		const float metallic = (float) jsonNumber(gltf->json, jsonGet(gltf->json, pbr, "metallicFactor"), 1.);
+		const float roughness = (float) jsonNumber(gltf->json, jsonGet(gltf->json, pbr, "roughnessFactor"), 1.);
+		// Dielectrics reflect ~4% untinted, metals reflect their base color, roughness dims & widens the highlight
+		glm_vec3_lerp((vec3){.04f, .04f, .04f}, material->diffuse, metallic, material->specular);
+		glm_vec3_scale(material->specular, 1.f - roughness, material->specular);
+		const float alpha = roughness * roughness;
+		material->shininess = glm_clamp(2.f / glm_max(alpha * alpha, 1e-4f) - 2.f, 1.f, 1000.f);
+
+		loadImage(gltf, jsonGet(gltf->json, pbr, "baseColorTexture"), images, &material->diffuseTex, material->diffuseMap,
+				  &material->flags, F_MAT_DIFFUSE);
+		loadImage(gltf, jsonGet(gltf->json, object, "normalTexture"), images, &material->normalTex, material->normalMap,
+				  &material->flags, F_MAT_NORMAL);
+	}
+	arenaRewind(scratchMark);
+
+	materialLibraryLoadTextures(library);
+	return library;
+}
+
+static void addModel(gltfScene_t* scene, const meshHandle_t mesh, const uint32_t transform)
+{
+	modelHandle_t* models = realloc(scene->models, (scene->numModels + 1) * sizeof(modelHandle_t));
+	if (models == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate glTF models!\n");
+		exit(EXIT_FAILURE);
+	}
+	scene->models = models;
+	scene->models[scene->numModels++] = resourcesAddModel(mesh, transform);
+}
+
+static void addNode(const gltfFile_t* gltf, gltfScene_t* scene, transforms_t* transforms, const int32_t index,
+					const uint32_t parent, const int depth)
+{
+	const int32_t node = getArray(gltf, "nodes", index);
+	if (node < 0 || depth >= JSON_MAX_DEPTH)
+		return;
+
+	vec3 t, s;
+	versor r;
+	const int32_t matrix = jsonGet(gltf->json, node, "matrix");
+	if (matrix >= 0)
+	{
+		// Column major, same as cglm, split back into TRS so the node can be moved later
+		mat4 local;
+		for (uint32_t i = 0; i < 16; i++)
+			local[i / 4][i % 4] = (float) jsonNumber(gltf->json, jsonIndex(gltf->json, matrix, i), i % 5 == 0 ? 1. : 0.);
+		vec4 translation;
+		mat4 rotation;
+		glm_decompose(local, translation, rotation, s);
+		glm_vec3_copy(translation, t);
+		glm_mat4_quat(rotation, r);
+	} else
+	{
+		const int32_t translation = jsonGet(gltf->json, node, "translation");
+		const int32_t rotation = jsonGet(gltf->json, node, "rotation");
+		const int32_t scale = jsonGet(gltf->json, node, "scale");
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			t[i] = (float) jsonNumber(gltf->json, jsonIndex(gltf->json, translation, i), 0.);
+			s[i] = (float) jsonNumber(gltf->json, jsonIndex(gltf->json, scale, i), 1.);
+		}
+		for (uint32_t i = 0; i < 4; i++)
+			r[i] = (float) jsonNumber(gltf->json, jsonIndex(gltf->json, rotation, i), i == 3 ? 1. : 0.); // x, y, z, w like cglm
+	}
+	// Added before the children are visited, which keeps the store sorted parent first
+	const uint32_t transform = transformAdd(transforms, parent, t, r, s);
+
+	const int32_t mesh = getInt(gltf, node, "mesh", -1);
+	if (mesh >= 0 && (uint32_t) mesh < scene->numMeshes && scene->meshes[mesh].id != POOL_NULL)
+		addModel(scene, scene->meshes[mesh], transform);
+
+	const int32_t children = jsonGet(gltf->json, node, "children");
+	for (uint32_t i = 0; i < jsonSize(gltf->json, children); i++)
+		addNode(gltf, scene, transforms, (int32_t) jsonNumber(gltf->json, jsonIndex(gltf->json, children, i), -1.),
+				transform, depth + 1);
+}
+
+gltfScene_t* gltfLoad(const char* filename, transforms_t* transforms)
+{
+	const double startTime = timeGetSeconds();
+	gltfFile_t gltf;
+	if (!openGLB(&gltf, filename))
+	{
+		closeGLB(&gltf);
+		return NULL;
+	}
+
+	gltfScene_t* scene = allocArray(1, sizeof(gltfScene_t));
+	scene->materials = loadMaterials(&gltf);
+
+	scene->numMeshes = jsonSize(gltf.json, jsonGet(gltf.json, 0, "meshes"));
+	scene->meshes = allocArray(scene->numMeshes, sizeof(meshHandle_t));
+	uint32_t triangles = 0, numDirect = 0;
+	for (uint32_t i = 0; i < scene->numMeshes; i++)
+	{
+		char name[MATERIAL_PATH_LENGTH + 16];
+		snprintf(name, sizeof(name), "%s#%u", filename, i);
+		bool direct;
+		mesh_t* mesh = loadMesh(&gltf, (int32_t) i, name, scene->materials, &direct);
+		if (mesh == NULL)
+			continue;
+		numDirect += direct;
+		triangles += (uint32_t) mesh->numIndices / 3;
+		scene->meshes[i] = resourcesAddMesh(mesh);
+	}
+
+	// The default scene's roots, or every node that isn't someone's child
+	const int32_t nodes = jsonGet(gltf.json, 0, "nodes");
+	const int32_t roots = jsonGet(gltf.json, getArray(&gltf, "scenes", getInt(&gltf, 0, "scene", 0)), "nodes");
+	if (roots >= 0)
+	{
+		for (uint32_t i = 0; i < jsonSize(gltf.json, roots); i++)
+			addNode(&gltf, scene, transforms, (int32_t) jsonNumber(gltf.json, jsonIndex(gltf.json, roots, i), -1.),
+					TRANSFORM_ROOT, 0);
+	} else
+	{
+		arena_t* scratch = arenaScratch();
+		const arenaMark_t scratchMark = arenaGetMark(scratch);
+		bool* isChild = arenaAllocZero(scratch, jsonSize(gltf.json, nodes) * sizeof(bool));
+		for (uint32_t i = 0; i < jsonSize(gltf.json, nodes); i++)
+		{
+			const int32_t children = jsonGet(gltf.json, jsonIndex(gltf.json, nodes, i), "children");
+			for (uint32_t c = 0; c < jsonSize(gltf.json, children); c++)
+			{
+				const int32_t child = (int32_t) jsonNumber(gltf.json, jsonIndex(gltf.json, children, c), -1.);
+				if (child >= 0 && (uint32_t) child < jsonSize(gltf.json, nodes))
+					isChild[child] = true;
+			}
+		}
+		for (uint32_t i = 0; i < jsonSize(gltf.json, nodes); i++)
+		{
+			if (!isChild[i])
+				addNode(&gltf, scene, transforms, (int32_t) i, TRANSFORM_ROOT, 0);
+		}
+		arenaRewind(scratchMark);
+	}
+	closeGLB(&gltf);
+
+	printf("glTF %s loaded (%u meshes, %u uploaded as is, %u triangles, %u materials, %u models in %.2f ms)\n", filename,
+		   scene->numMeshes, numDirect, triangles, scene->materials->numMaterials, scene->numModels,
+		   (timeGetSeconds() - startTime) * 1000.);
+	return scene;
+}
+
+void gltfSceneDestroy(gltfScene_t* scene)
+{
+	for (uint32_t i = 0; i < scene->numModels; i++)
+		resourcesReleaseModel(scene->models[i]);
+	for (uint32_t i = 0; i < scene->numMeshes; i++)
+	{
+		mesh_t* mesh = resourcesGetMesh(scene->meshes[i]);
+		if (mesh == NULL)
+			continue;
+		// The library is the scene's, anyone still sharing the mesh keeps it without materials
+		mesh->materials = NULL;
+		resourcesReleaseMesh(scene->meshes[i]);
+	}
+	materialLibraryDestroy(scene->materials);
+	free(scene->meshes);
+	free(scene->models);
+	free(scene);
+}
@@ -0,0 +1,43 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Binary glTF 2.0 (.glb) scenes, the binary chunk is mapped & read in place, only the json header is parsed
+ */
+
+#ifndef GLTF_H
+#define GLTF_H
+
+#include <stdint.h>
+
+#include "material.h"
+#include "model.h"
+#include "resources.h"
+#include "transform.h"
+
+#define GLTF_MAGIC 0x46546C67u // "glTF"
+#define GLTF_VERSION 2
+#define GLTF_CHUNK_JSON 0x4E4F534Au // "JSON"
+#define GLTF_CHUNK_BIN 0x004E4942u // "BIN\0"
+// Interleaved primitives are uploaded in glTF's own layout, position & uv where the other layouts have them plus float
+// normals & tangents, the lighting shader reads it with GLTF_VERTICES. The tangent goes after the instance matrix
+#define GLTF_NORMAL_LOCATION 1
+#define GLTF_TANGENT_LOCATION 7
+
+typedef struct gltfScene_t
+{
+	// One per glTF mesh, its triangle primitives become submeshes
+	uint32_t numMeshes;
+	meshHandle_t* meshes; // {POOL_NULL} where the mesh had nothing drawable, the scene holds a reference to the rest
+	// Every glTF material, shared by all the meshes (their submesh materialIndex is the glTF index)
+	materialLibrary_t* materials;
+	// One per node that has a mesh, their transform indices point into the store passed to gltfLoad
+	uint32_t numModels;
+	modelHandle_t* models;
+} gltfScene_t;
+
+// Loads the default scene (or every root node if there's none), NULL if the file isn't a valid glb, needs a GL context
+// Every node is added to 'transforms' (mesh or not) so the hierarchy is kept
+gltfScene_t* gltfLoad(const char* filename, transforms_t* transforms);
+// Releases the models & meshes, destroys the materials
+void gltfSceneDestroy(gltfScene_t* scene);
+
+#endif //GLTF_H
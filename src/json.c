@@ -0,0 +1,307 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+typedef struct jsonParser_t
+{
+	const char* text;
+	size_t length;
+	size_t position;
+	json_t* json;
+	uint32_t maxTokens;
+} jsonParser_t;
+
+static void skipWhitespace(jsonParser_t* parser)
+{
+	while (parser->position < parser->length)
+	{
+		const char c = parser->text[parser->position];
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+			break;
+		parser->position++;
+	}
+}
+
+static int32_t addToken(jsonParser_t* parser, const jsonType_t type, const size_t start)
+{
+	json_t* json = parser->json;
+	if (json->numTokens == parser->maxTokens)
+	{
+		parser->maxTokens = parser->maxTokens ? parser->maxTokens * 2 : 256;
+		jsonToken_t* tokens = realloc(json->tokens, parser->maxTokens * sizeof(jsonToken_t));
+		if (tokens == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate json tokens!\n");
+			exit(EXIT_FAILURE);
+		}
+		json->tokens = tokens;
+	}
+	jsonToken_t* token = &json->tokens[json->numTokens];
+	token->type = type;
+	token->start = token->end = (uint32_t) start;
+	token->size = 0;
+	token->next = json->numTokens + 1;
+	return (int32_t) json->numTokens++;
+}
+
+static bool matchLiteral(jsonParser_t* parser, const char* literal)
+{
+	const size_t length = strlen(literal);
+	if (parser->length - parser->position < length || memcmp(parser->text + parser->position, literal, length) != 0)
+		return false;
+	parser->position += length;
+	return true;
+}
+
+static int32_t parseString(jsonParser_t* parser)
+{
+	const size_t start = ++parser->position; // Opening quote
+	while (parser->position < parser->length)
+	{
+		const char c = parser->text[parser->position];
+		if (c == '"')
+		{
+			const int32_t token = addToken(parser, JSON_STRING, start);
+			parser->json->tokens[token].end = (uint32_t) parser->position++;
+			return token;
+		}
+		if ((unsigned char) c < 0x20)
+			return -1;
+		parser->position += c == '\\' ? 2 : 1;
+	}
+	return -1;
+}
+
+static int32_t parseNumber(jsonParser_t* parser)
+{
+	const size_t start = parser->position;
+	while (parser->position < parser->length && strchr("+-0123456789.eE", parser->text[parser->position]))
+		parser->position++;
+	if (parser->position == start)
+		return -1;
+	const int32_t token = addToken(parser, JSON_NUMBER, start);
+	parser->json->tokens[token].end = (uint32_t) parser->position;
+	return token;
+}
+
+static int32_t parseValue(jsonParser_t* parser, int depth);
+
+// Arrays & objects, 'close' is ']' or '}'
+static int32_t parseContainer(jsonParser_t* parser, const jsonType_t type, const char close, const int depth)
+{
+	if (depth >= JSON_MAX_DEPTH)
+		return -1;
+	const int32_t container = addToken(parser, type, parser->position++);
+	skipWhitespace(parser);
+	uint32_t size = 0;
+	if (parser->position < parser->length && parser->text[parser->position] == close)
+		parser->position++;
+	else
+	{
+		for (;;)
+		{
+			if (type == JSON_OBJECT)
+			{
+				skipWhitespace(parser);
+				if (parser->position >= parser->length || parser->text[parser->position] != '"' || parseString(parser) < 0)
+					return -1;
+				skipWhitespace(parser);
+				if (parser->position >= parser->length || parser->text[parser->position++] != ':')
+					return -1;
+			}
+			if (parseValue(parser, depth + 1) < 0)
+				return -1;
+			size++;
+
+			skipWhitespace(parser);
+			if (parser->position >= parser->length)
+				return -1;
+			const char c = parser->text[parser->position++];
+			if (c == close)
+				break;
+			if (c != ',')
+				return -1;
+		}
+	}
+
+	// Tokens may have moved while the children were added
+	jsonToken_t* token = &parser->json->tokens[container];
+	token->end = (uint32_t) parser->position;
+	token->size = size;
+	token->next = parser->json->numTokens;
+	return container;
+}
+
+static int32_t parseValue(jsonParser_t* parser, const int depth)
+{
+	skipWhitespace(parser);
+	if (parser->position >= parser->length)
+		return -1;
+
+	const size_t start = parser->position;
+	switch (parser->text[parser->position])
+	{
+		case '{':
+			return parseContainer(parser, JSON_OBJECT, '}', depth);
+		case '[':
+			return parseContainer(parser, JSON_ARRAY, ']', depth);
+		case '"':
+			return parseString(parser);
+		case 't':
+		case 'f':
+			if (!matchLiteral(parser, "true") && !matchLiteral(parser, "false"))
+				return -1;
+			break;
+		case 'n':
+			if (!matchLiteral(parser, "null"))
+				return -1;
+			break;
+		default:
+			return parseNumber(parser);
+	}
+
+	const int32_t token = addToken(parser, parser->text[start] == 'n' ? JSON_NULL : JSON_BOOL, start);
+	parser->json->tokens[token].end = (uint32_t) parser->position;
+	return token;
+}
+
+json_t* jsonParse(const char* text, const size_t length)
+{
+	if (length >= UINT32_MAX)
+		return NULL;
+	json_t* json = calloc(1, sizeof(json_t));
+	if (json == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate json!\n");
+		exit(EXIT_FAILURE);
+	}
+	json->text = text;
+
+	jsonParser_t parser = {text, length, 0, json, 0};
+	const bool ok = parseValue(&parser, 0) == 0;
+	skipWhitespace(&parser);
+	if (!ok || parser.position != length)
+	{
+		jsonDestroy(json);
+		return NULL;
+	}
+	return json;
+}
+
+void jsonDestroy(json_t* json)
+{
+	free(json->tokens);
+	free(json);
+}
+
+int32_t jsonGet(const json_t* json, const int32_t object, const char* key)
+{
+	if (object < 0 || json->tokens[object].type != JSON_OBJECT)
+		return -1;
+	uint32_t token = (uint32_t) object + 1;
+	for (uint32_t i = 0; i < json->tokens[object].size; i++)
+	{
+		const uint32_t value = token + 1;
+		if (jsonStringEquals(json, (int32_t) token, key))
+			return (int32_t) value;
+		token = json->tokens[value].next;
+	}
+	return -1;
+}
+
+int32_t jsonIndex(const json_t* json, const int32_t array, const uint32_t index)
+{
+	if (array < 0 || json->tokens[array].type != JSON_ARRAY || index >= json->tokens[array].size)
+		return -1;
+	uint32_t token = (uint32_t) array + 1;
+	for (uint32_t i = 0; i < index; i++)
+		token = json->tokens[token].next;
+	return (int32_t) token;
+}
+
+uint32_t jsonSize(const json_t* json, const int32_t token)
+{
+	return token < 0 ? 0 : json->tokens[token].size;
+}
+
+double jsonNumber(const json_t* json, const int32_t token, const double fallback)
+{
+	if (token < 0 || json->tokens[token].type != JSON_NUMBER)
+		return fallback;
+	// Numbers always end at a delimiter, so strtod stops in time without a copy
+	return strtod(json->text + json->tokens[token].start, NULL);
+}
+
+bool jsonBool(const json_t* json, const int32_t token, const bool fallback)
+{
+	if (token < 0 || json->tokens[token].type != JSON_BOOL)
+		return fallback;
+	return json->text[json->tokens[token].start] == 't';
+}
+
+bool jsonString(const json_t* json, const int32_t token, char* string, const size_t size)
+{
+	if (size > 0)
+		string[0] = '\0';
+	if (token < 0 || json->tokens[token].type != JSON_STRING || size == 0)
+		return false;
+
+	const jsonToken_t* t = &json->tokens[token];
+	size_t length = 0;
+	for (uint32_t i = t->start; i < t->end && length + 1 < size; i++)
+	{
+		char c = json->text[i];
+		if (c == '\\' && i + 1 < t->end)
+		{
+			c = json->text[++i];
+			switch (c)
+			{
+				case 'n':
+					c = '\n';
+					break;
+				case 't':
+					c = '\t';
+					break;
+				case 'r':
+					c = '\r';
+					break;
+				case 'b':
+					c = '\b';
+					break;
+				case 'f':
+					c = '\f';
+					break;
+				case 'u':
+					// Only ascii survives, the rest becomes '?'
+					if (i + 4 < t->end)
+					{
+						char hex[5] = {json->text[i + 1], json->text[i + 2], json->text[i + 3], json->text[i + 4], '\0'};
+						const long code = strtol(hex, NULL, 16);
+						c = code > 0 && code < 0x80 ? (char) code : '?';
+						i += 4;
+					}
+					break;
+				default: // '"', '\\' & '/' are themselves
+					break;
+			}
+		}
+		string[length++] = c;
+	}
+	string[length] = '\0';
+	return true;
+}
+
+bool jsonStringEquals(const json_t* json, const int32_t token, const char* string)
+{
+	if (token < 0 || json->tokens[token].type != JSON_STRING)
+		return false;
+	const jsonToken_t* t = &json->tokens[token];
+	const size_t length = strlen(string);
+	return t->end - t->start == length && memcmp(json->text + t->start, string, length) == 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Minimal json reader, parses into a flat token array that's walked by index (enough for glTF)
+ */
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_MAX_DEPTH 64
+
+typedef enum jsonType_t
+{
+	JSON_NULL = 0,
+	JSON_BOOL,
+	JSON_NUMBER,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT
+} jsonType_t;
+
+typedef struct jsonToken_t
+{
+	jsonType_t type;
+	uint32_t start; // Into the text, strings exclude their quotes
+	uint32_t end;
+	uint32_t size; // Elements of an array, key/value pairs of an object
+	uint32_t next; // First token after this one's children, so siblings can be skipped to
+} jsonToken_t;
+
+// Objects store every key as a string token followed by its value
+typedef struct json_t
+{
+	const char* text; // Not owned, has to outlive the json_t
+	uint32_t numTokens;
+	jsonToken_t* tokens;
+} json_t;
+
+// NULL if the text isn't valid json
+json_t* jsonParse(const char* text, size_t length);
+void jsonDestroy(json_t* json);
+
+// Every lookup takes & returns token indices, -1 for missing, so lookups can be chained without checks
+int32_t jsonGet(const json_t* json, int32_t object, const char* key);
+int32_t jsonIndex(const json_t* json, int32_t array, uint32_t index);
+uint32_t jsonSize(const json_t* json, int32_t token);
+double jsonNumber(const json_t* json, int32_t token, double fallback);
+bool jsonBool(const json_t* json, int32_t token, bool fallback);
+// Unescaped & truncated to fit, false (with an empty 'string') if the token isn't a string
+bool jsonString(const json_t* json, int32_t token, char* string, size_t size);
+bool jsonStringEquals(const json_t* json, int32_t token, const char* string);
+
+#endif //JSON_H
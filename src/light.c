@@ -0,0 +1,158 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "light.h"
+#include "util.h"
+
+// Total, direct, point & spot counts, which fill the Light array's 16 byte std430 alignment
+#define LIGHT_HEADER_SIZE 16
+#define LIGHT_ALL_REGIONS ((1u << LIGHT_BUFFER_REGIONS) - 1)
+
+_Static_assert(sizeof(lightGpu_t) == 80, "lightGpu_t has to match the std430 Light struct");
+
+static void lightPack(const light_t* light, lightGpu_t* packed)
+{
+	memcpy(packed->position, light->position, sizeof(vec3));
+	packed->mode = light->mode;
+	memcpy(packed->direction, light->direction, sizeof(vec3));
+	packed->cutOffInner = cosf(RAD(light->cutOffInner));
+	memcpy(packed->ambient, light->ambient, sizeof(vec3));
+	packed->cutOffOuter = cosf(RAD(light->cutOffOuter));
+	memcpy(packed->diffuse, light->diffuse, sizeof(vec3));
+	packed->linear = 4.5f / light->range;
+	memcpy(packed->specular, light->specular, sizeof(vec3));
+	packed->quadratic = 75.f / (light->range * light->range);
+}
+
+lightBuffer_t* lightBufferCreate()
+{
+	lightBuffer_t* buffer = calloc(1, sizeof(lightBuffer_t));
+	if (buffer == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate light buffer!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (uint32_t i = 0; i < MAX_LIGHTS; i++)
+		buffer->slots[i] = LIGHT_NONE;
+	buffer->countPending = LIGHT_ALL_REGIONS;
+	buffer->region = LIGHT_BUFFER_REGIONS - 1;
+
+	GLint alignment = 1;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	const GLsizeiptr size = LIGHT_HEADER_SIZE + MAX_LIGHTS * sizeof(lightGpu_t);
+	buffer->regionSize = (size + alignment - 1) / alignment * alignment;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &buffer->buffer);
+	glNamedBufferStorage(buffer->buffer, buffer->regionSize * LIGHT_BUFFER_REGIONS, NULL, flags);
+	buffer->mapped = glMapNamedBufferRange(buffer->buffer, 0, buffer->regionSize * LIGHT_BUFFER_REGIONS, flags);
+	if (buffer->mapped == NULL)
+	{
+		fprintf(stderr, "Failed to map light buffer!\n");
+		exit(EXIT_FAILURE);
+	}
+	return buffer;
+}
+
+void lightBufferDestroy(lightBuffer_t* buffer)
+{
+	for (uint32_t i = 0; i < LIGHT_BUFFER_REGIONS; i++)
+	{
+		if (buffer->fences[i])
+			glDeleteSync(buffer->fences[i]);
+	}
+	glUnmapNamedBuffer(buffer->buffer);
+	glDeleteBuffers(1, &buffer->buffer);
+	free(buffer);
+}
+
+void lightBufferUpdate(lightBuffer_t* buffer, light_t* lights, const uint32_t count)
+{
+	const uint32_t numLights = count < MAX_LIGHTS ? count : MAX_LIGHTS;
+
+	// Turning a light on or off (or changing its mode) moves everything after it, so the whole list is packed again
+	bool repack = false;
+	for (uint32_t i = 0; i < numLights; i++)
+		repack = repack || lights[i].enable != buffer->enabled[i] || (lights[i].enable && lights[i].mode != buffer->modes[i]);
+	if (repack)
+	{
+		// Grouped by mode so the shader can loop over each without branching on it
+		const int modes[] = {F_LHT_DIRECT, F_LHT_POINT, F_LHT_SPOT};
+		uint32_t* counts[] = {&buffer->numDirect, &buffer->numPoint, &buffer->numSpot};
+		buffer->numPacked = 0;
+		for (uint32_t i = 0; i < numLights; i++)
+		{
+			buffer->enabled[i] = lights[i].enable;
+			buffer->modes[i] = lights[i].mode;
+			buffer->slots[i] = LIGHT_NONE;
+			lights[i].dirty = lights[i].dirty || lights[i].enable;
+		}
+		for (int m = 0; m < 3; m++)
+		{
+			const uint32_t first = buffer->numPacked;
+			for (uint32_t i = 0; i < numLights; i++)
+			{
+				if (lights[i].enable && lights[i].mode == modes[m])
+					buffer->slots[i] = buffer->numPacked++;
+			}
+			*counts[m] = buffer->numPacked - first;
+		}
+		buffer->countPending = LIGHT_ALL_REGIONS;
+	}
+	for (uint32_t i = 0; i < numLights; i++)
+	{
+		if (!lights[i].dirty)
+			continue;
+		lights[i].dirty = false;
+		if (buffer->slots[i] == LIGHT_NONE)
+			continue;
+		lightPack(&lights[i], &buffer->packed[buffer->slots[i]]);
+		buffer->pending[i] = LIGHT_ALL_REGIONS;
+	}
+
+	buffer->region = (buffer->region + 1) % LIGHT_BUFFER_REGIONS;
+	GLsync* fence = &buffer->fences[buffer->region];
+	if (*fence)
+	{
+		// Normally signalled long ago, this only blocks if the GPU is more than LIGHT_BUFFER_REGIONS - 1 frames behind
+		while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(*fence);
+		*fence = NULL;
+	}
+
+	unsigned char* region = buffer->mapped + buffer->region * buffer->regionSize;
+	const uint8_t bit = 1u << buffer->region;
+	if (buffer->countPending & bit)
+	{
+		const uint32_t counts[4] = {buffer->numPacked, buffer->numDirect, buffer->numPoint, buffer->numSpot};
+		memcpy(region, counts, sizeof(counts));
+		buffer->countPending &= ~bit;
+	}
+	buffer->numWritten = 0;
+	for (uint32_t i = 0; i < numLights; i++)
+	{
+		if (!(buffer->pending[i] & bit))
+			continue;
+		buffer->pending[i] &= ~bit;
+		if (buffer->slots[i] == LIGHT_NONE)
+			continue;
+		memcpy(region + LIGHT_HEADER_SIZE + buffer->slots[i] * sizeof(lightGpu_t), &buffer->packed[buffer->slots[i]],
+			   sizeof(lightGpu_t));
+		buffer->numWritten++;
+	}
+
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, buffer->buffer, buffer->region * buffer->regionSize,
+					  buffer->regionSize);
+}
+
+void lightBufferFence(lightBuffer_t* buffer)
+{
+	if (buffer->fences[buffer->region])
+		glDeleteSync(buffer->fences[buffer->region]);
+	buffer->fences[buffer->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,89 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Lights & the persistently mapped shader storage buffer they're packed into, only enabled lights are uploaded
+ */
+
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glad/glad.h>
+#include <cglm/cglm.h>
+
+#define F_LHT_DIRECT 1
+#define F_LHT_POINT 2
+#define F_LHT_SPOT 3
+
+#define MAX_LIGHTS 8
+#define LIGHT_BUFFER_BINDING 0 // layout(binding) of the Lights block in light_multi.frag
+#define LIGHT_BUFFER_REGIONS 3 // Frames in flight, each writes its own copy so the GPU is never read from under
+#define LIGHT_NONE UINT32_MAX // Packed index of disabled lights
+
+typedef struct light_t
+{
+	bool enable;
+	char name[10];
+
+	int mode;
+	vec3 position;
+	vec3 direction;
+	float cutOffInner; // Degrees
+	float cutOffOuter;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+
+	float range;
+	bool dirty; // Set after changing anything above, cleared once it's been packed
+} light_t;
+
+// std430 Light in light_multi.frag, cut offs are cosines & attenuation is 1 / (1 + linear * d + quadratic * d^2)
+typedef struct lightGpu_t
+{
+	vec3 position;
+	int32_t mode;
+	vec3 direction;
+	float cutOffInner;
+	vec3 ambient;
+	float cutOffOuter;
+	vec3 diffuse;
+	float linear;
+	vec3 specular;
+	float quadratic;
+} lightGpu_t;
+
+typedef struct lightBuffer_t
+{
+	GLuint buffer;
+	unsigned char* mapped; // Coherent, stays mapped until destroyed
+	GLsizeiptr regionSize; // Counts header & MAX_LIGHTS lights, padded to the storage buffer offset alignment
+	uint32_t region; // Written & bound by the last update
+	GLsync fences[LIGHT_BUFFER_REGIONS];
+
+	lightGpu_t packed[MAX_LIGHTS]; // Enabled lights with their derived terms, direct then point then spot
+	uint32_t numPacked;
+	uint32_t numDirect; // Of each mode, the lighting shader is specialized on these rounded up to a power of two
+	uint32_t numPoint;
+	uint32_t numSpot;
+	uint32_t slots[MAX_LIGHTS]; // Light -> packed index, LIGHT_NONE if disabled
+	uint8_t pending[MAX_LIGHTS]; // Bit per region still holding an old copy of the packed light
+	uint8_t countPending;
+	bool enabled[MAX_LIGHTS]; // As of the last pack, any change to these or the modes repacks the list
+	int modes[MAX_LIGHTS];
+
+	uint32_t numWritten; // Lights copied by the last update
+} lightBuffer_t;
+
+lightBuffer_t* lightBufferCreate();
+void lightBufferDestroy(lightBuffer_t* buffer);
+
+// Packs dirty lights, waits for the GPU to finish with the next region, copies in what that region is missing & binds
+// it to LIGHT_BUFFER_BINDING
+void lightBufferUpdate(lightBuffer_t* buffer, light_t* lights, uint32_t count);
+// After the last draw reading the lights, so the region isn't rewritten before the GPU is done with it
+void lightBufferFence(lightBuffer_t* buffer);
+
+#endif //LIGHT_H
@@ -10,7 +10,6 @@
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 // #include <linmath.h>
@@ -21,37 +20,19 @@
 #include <cimgui_impl.h>
 
 #include "util.h"
+#include "arena.h"
 #include "shader.h"
 #include "camera.h"
 #include "model.h"
+#include "resources.h"
 #include "framebuffer.h"
-
-#define F_MAT_DIFFUSE 0x001
-#define F_MAT_SPECULAR 0x010
-#define F_MAT_EMISSION 0x100
-
-#define F_LHT_DIRECT 1
-#define F_LHT_POINT 2
-#define F_LHT_SPOT 3
-#define MAX_LIGHTS 8
-
-typedef struct light_t
-{
-	bool enable;
-	char name[10];
-
-	int mode;
-	vec3 position;
-	vec3 direction;
-	float cutOffInner;
-	float cutOffOuter;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-
-	float range;
-} light_t;
+#include "cull.h"
+#include "meshloader.h"
+#include "gltf.h"
+#include "transform.h"
+#include "light.h"
+#include "frameblock.h"
+#include "glstate.h"
 
 const unsigned int WIDTH = 1600;
 const unsigned int HEIGHT = 900;
@@ -65,6 +46,9 @@ float deltaTime = 0.f;
 float lastFrame = 0.f;
 bool vsync = false;
 
+// Reset at the top of every frame, nothing allocated from it outlives the frame
+arena_t frameArena;
+
 vec3 clearColor = {0.f, 0.f, 0.f};
 bool postProcessing = false;
 framebuffer_t* framebuffer;
@@ -74,11 +58,63 @@ bool mouseCaptured = false;
 float cameraSpeed = 10.f;
 float mouseSensitivity = .1f;
 
+float lodPixelError = MESH_LOD_PIXEL_ERROR;
+int lodInstanceCounts[MESH_MAX_LODS];
+size_t instanceTriangles = 0;
+size_t instanceTrianglesFull = 0;
+
+bool frustumCulling = true;
+size_t instancesVisible = 0;
+size_t instancesTotal = 0;
+double instanceCullMs = 0.;
+
+bool meshletCulling = true;
+GLsizei meshletDraws = 0;
+uint32_t meshletTriangles = 0;
+uint32_t meshletTrianglesTotal = 0;
+
+uint32_t meshesLoading = 0;
+uint32_t shadersCompiling = 0;
+double shaderCheckMs = 0.;
+uint32_t lightingVariantsBuilt = 0;
+uint32_t lightingVariantsPending = 0;
+uint32_t lightingVariantsEvicted = 0;
+double lightingVariantsMs = 0.;
+double meshLoadMs = 0.;
+
+uint32_t transformsUpdated = 0;
+uint32_t transformsTotal = 0;
+
+uint32_t glCallsIssued = 0;
+uint32_t glCallsElided = 0;
+
+uint32_t lightsPacked = 0;
+uint32_t lightsWritten = 0;
+bool blinn = true;
+
 ImGuiContext* imguiCtx;
 ImGuiIO* imguiIO;
 
 light_t lights[MAX_LIGHTS];
 
+// Everything the frame sets by name, hashed once at startup so drawing never touches a string
+typedef struct frameUniforms_t
+{
+	uniform_t model;
+	uniform_t normalMatrix;
+	uniform_t color;
+	uniform_t materialDiffuseColor;
+	uniform_t materialSpecularColor;
+	uniform_t materialShininess;
+	uniform_t materialDiffuseTex;
+	uniform_t materialSpecularTex;
+	uniform_t materialNormalTex;
+	uniform_t skybox;
+	uniform_t texture;
+} frameUniforms_t;
+
+frameUniforms_t uniforms;
+
 void errorCallback(int error, const char* description);
 void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 
@@ -93,6 +129,23 @@ void guiTerminate();
 void guiLightSettings(const char* label, light_t* light);
 void guiUpdate();
 
+// Lighting variant key, the light counts are packed above these
+#define LIGHTING_INSTANCED 0x1
+#define LIGHTING_BLINN 0x2
+#define LIGHTING_GLTF_VERTICES 0x4
+#define LIGHTING_HAS_NORMAL_MAP 0x8
+#define LIGHTING_DIRECT_SHIFT 8
+#define LIGHTING_POINT_SHIFT 16
+#define LIGHTING_SPOT_SHIFT 24
+
+void uniformsInit();
+void lightingDefines(uint64_t key, char* defines, size_t size);
+uint64_t lightingBucket(uint32_t count);
+uint64_t lightingKey(const lightBuffer_t* buffer, uint64_t features);
+void shaderDefaults(GLuint program, void* user);
+void shaderReady(GLuint program, void* user);
+void setModelUniforms(const GLuint* shader, const transforms_t* transforms, uint32_t transform);
+
 // float randf()
 // {
 // 	return (float) (rand() % 101) / 100.f * 2. - 1.f;
@@ -143,18 +196,21 @@ int main()
 	}
 
 	guiInit(window);
+	shaderInitParallelCompile((GLADloadproc) glfwGetProcAddress);
+	// Everything below binds through the state tracker, imgui's renderer puts back whatever it changes
+	glStateReset();
 
 	// glViewport(0, 0, WIDTH, HEIGHT);
 	glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 
-	glEnable(GL_DEPTH_TEST);
+	glStateSetEnabled(GL_DEPTH_TEST, true);
     // glDepthFunc(GL_ALWAYS); // always pass the depth test (same effect as glDisable(GL_DEPTH_TEST))
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glStateSetEnabled(GL_BLEND, true);
+	glStateBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	glStateSetEnabled(GL_CULL_FACE, true);
+	glStateCullFace(GL_BACK);
 	glFrontFace(GL_CCW);
 
 	// Uncomment this call to draw in wireframe polygons.
@@ -273,85 +329,109 @@ int main()
 	// }
 	// printf("%f %f %f\n", instancePositions[0][0], instancePositions[0][1], instancePositions[0][2]);
 
-	// Build & compile shaders
-	const GLuint shaderLighting = shaderCreate("resources/shaders/light.vert", "resources/shaders/light_multi.frag", NULL);
-	const GLuint shaderSingleColor = shaderCreate("resources/shaders/single_color.vert", "resources/shaders/single_color.frag", NULL);
-	const GLuint shaderQuadTexture = shaderCreate("resources/shaders/quad_texture.vert", "resources/shaders/quad_texture.frag", NULL);
-	const GLuint shaderSkybox = shaderCreate("resources/shaders/skybox.vert", "resources/shaders/skybox.frag", NULL);
-
-	const GLuint shaderGeomExplode = shaderCreate("resources/shaders/geom_explode.vert", "resources/shaders/geom_explode.frag", "resources/shaders/geom_explode.geom");
-	const GLuint shaderGeomNormals = shaderCreate("resources/shaders/geom_normal_visual.vert", "resources/shaders/geom_normal_visual.frag", "resources/shaders/geom_normal_visual.geom");
-
-	GLuint vaoPlaneCross, vboPlaneCross;
-	glCreateVertexArrays(1, &vaoPlaneCross);
-	glCreateBuffers(1, &vboPlaneCross);
-	glBindVertexArray(vaoPlaneCross);
-	glNamedBufferData(vboPlaneCross, sizeof(planeCrossVertices), planeCrossVertices, GL_STATIC_DRAW);
-
-	glVertexArrayVertexBuffer(vaoPlaneCross, 0, vboPlaneCross, 0, 8 * sizeof(float));
-
-	GLint positionLocation = glGetAttribLocation(shaderLighting, "i_position");
-	const GLint normalLocation = glGetAttribLocation(shaderLighting, "i_normal");
-	GLint uvLocation = glGetAttribLocation(shaderLighting, "i_uv");
-
-	glVertexArrayAttribFormat(vaoPlaneCross, positionLocation, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(vaoPlaneCross, positionLocation, 0);
-	glVertexArrayAttribFormat(vaoPlaneCross, normalLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
-	glVertexArrayAttribBinding(vaoPlaneCross, normalLocation, 0);
-	glVertexArrayAttribFormat(vaoPlaneCross, uvLocation, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float));
-	glVertexArrayAttribBinding(vaoPlaneCross, uvLocation, 0);
-
-	glEnableVertexArrayAttrib(vaoPlaneCross, positionLocation);
-	glEnableVertexArrayAttrib(vaoPlaneCross, normalLocation);
-	glEnableVertexArrayAttrib(vaoPlaneCross, uvLocation);
-
-	GLuint vaoQuad, vboQuad;
-	glCreateVertexArrays(1, &vaoQuad);
-	glCreateBuffers(1, &vboQuad);
-	glBindVertexArray(vaoQuad);
-	glNamedBufferData(vboQuad, sizeof(quadVerticies), quadVerticies, GL_STATIC_DRAW);
-
-	glVertexArrayVertexBuffer(vaoQuad, 0, vboQuad, 0, 4 * sizeof(float));
-
-	positionLocation = glGetAttribLocation(shaderQuadTexture, "i_position");
-	uvLocation = glGetAttribLocation(shaderQuadTexture, "i_uv");
-
-	glVertexArrayAttribFormat(vaoQuad, positionLocation, 2, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(vaoQuad, positionLocation, 0);
-	glVertexArrayAttribFormat(vaoQuad, uvLocation, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float));
-	glVertexArrayAttribBinding(vaoQuad, uvLocation, 0);
-
-	glEnableVertexArrayAttrib(vaoQuad, positionLocation);
-	glEnableVertexArrayAttrib(vaoQuad, uvLocation);
-
-	GLuint vaoSkybox, vboSkybox;
-	glCreateVertexArrays(1, &vaoSkybox);
-	glCreateBuffers(1, &vboSkybox);
-	glBindVertexArray(vaoSkybox);
-	glNamedBufferData(vaoSkybox, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
-
-	glVertexArrayVertexBuffer(vaoSkybox, 0, vboSkybox, 0, 3 * sizeof(float));
-
-	positionLocation = glGetAttribLocation(shaderSkybox, "i_position");
-
-	glVertexArrayAttribFormat(vaoSkybox, positionLocation, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(vaoSkybox, positionLocation, 0);
-
-	glEnableVertexArrayAttrib(vaoSkybox, positionLocation);
-
-	mesh_t* meshMonkey = meshCreate("resources/models/monkey.obj", false);
-	mesh_t* meshCube = meshCreate("resources/models/cube_fixed.obj", false);
-	mesh_t* meshInstance = meshCreate("resources/models/monkey.obj", false);
+	// Build & compile shaders, single color is built straight away as everything else draws with it until it's ready
+	const shaderHandle_t singleColorShader = resourcesAddShader(shaderCreate("resources/shaders/single_color.vert", "resources/shaders/single_color.frag", NULL));
+	const shaderHandle_t quadTextureShader = resourcesAddShaderPending(singleColorShader);
+	const shaderHandle_t skyboxShader = resourcesAddShaderPending(singleColorShader);
+	const shaderHandle_t geomExplodeShader = resourcesAddShaderPending(singleColorShader);
+	const shaderHandle_t geomNormalsShader = resourcesAddShaderPending(singleColorShader);
+
+	// The rest compile while the textures & meshes below load, they're swapped in by shaderReady
+	shaderBatch_t shaderBatch;
+	shaderBatchInit(&shaderBatch, shaderReady);
+	shaderBatchAdd(&shaderBatch, "resources/shaders/quad_texture.vert", "resources/shaders/quad_texture.frag", NULL, NULL, (void*) &quadTextureShader);
+	shaderBatchAdd(&shaderBatch, "resources/shaders/skybox.vert", "resources/shaders/skybox.frag", NULL, NULL, (void*) &skyboxShader);
+	shaderBatchAdd(&shaderBatch, "resources/shaders/geom_explode.vert", "resources/shaders/geom_explode.frag", "resources/shaders/geom_explode.geom", NULL, (void*) &geomExplodeShader);
+	shaderBatchAdd(&shaderBatch, "resources/shaders/geom_normal_visual.vert", "resources/shaders/geom_normal_visual.frag", "resources/shaders/geom_normal_visual.geom", NULL, (void*) &geomNormalsShader);
+	// Specialized on the lights & what each draw needs, variants compile the first time they're drawn with
+	shaderVariants_t lightingVariants;
+	shaderVariantsInit(&lightingVariants, "resources/shaders/light.vert", "resources/shaders/light_multi.frag", NULL,
+					   lightingDefines, shaderDefaults);
+	// Looked up again every frame, only the handles are kept
+	GLuint shaderLighting = 0;
+	GLuint shaderLightingNormal = 0;
+	GLuint shaderLightingInstanced = 0;
+	GLuint shaderLightingGltf = 0;
+	GLuint shaderLightingGltfNormal = 0;
+	GLuint shaderSingleColor = resourcesGetShader(singleColorShader);
+	GLuint shaderQuadTexture = resourcesGetShader(quadTextureShader);
+	GLuint shaderSkybox = resourcesGetShader(skyboxShader);
+	GLuint shaderGeomExplode = resourcesGetShader(geomExplodeShader);
+	GLuint shaderGeomNormals = resourcesGetShader(geomNormalsShader);
+
+	// Hand made meshes go through the same geometry arenas as the obj ones, lit ones need tangents so they go through meshData_t
+	meshData_t* planeCrossData = meshDataCreate(planeCrossVertices, sizeof(planeCrossVertices) / (VERTEX_STRIDE * sizeof(float)),
+												"plane cross");
+	const meshHandle_t planeCrossMesh = resourcesAddMesh(meshCreateFromData(planeCrossData));
+	meshDataDestroy(planeCrossData);
+
+	const meshLayout_t quadLayout = {
+		.stride = 4 * sizeof(float),
+		.numAttributes = 2,
+		.attributes = {
+			{0, 2, GL_FLOAT, GL_FALSE, 0}, // position
+			{1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float)} // uv
+		}
+	};
+	const meshHandle_t quadMesh = resourcesAddMesh(meshCreateFromBuffers(&quadLayout, sizeof(quadVerticies) / quadLayout.stride,
+																		 quadVerticies, sizeof(quadVerticies) / quadLayout.stride,
+																		 GL_UNSIGNED_SHORT, NULL, NULL, 0, (vec3){-1.f, -1.f, 0.f},
+																		 (vec3){1.f, 1.f, 0.f}));
+
+	const meshLayout_t skyboxLayout = {
+		.stride = 3 * sizeof(float),
+		.numAttributes = 1,
+		.attributes = {
+			{0, 3, GL_FLOAT, GL_FALSE, 0} // position
+		}
+	};
+	const meshHandle_t skyboxMesh = resourcesAddMesh(meshCreateFromBuffers(&skyboxLayout, sizeof(skyboxVertices) / skyboxLayout.stride,
+																		   skyboxVertices, sizeof(skyboxVertices) / skyboxLayout.stride,
+																		   GL_UNSIGNED_SHORT, NULL, NULL, 0, (vec3){-1.f, -1.f, -1.f},
+																		   (vec3){1.f, 1.f, 1.f}));
+
+	const meshHandle_t monkeyMesh = resourcesAddMesh(meshCreate("resources/models/monkey.obj", F_MESH_PACKED));
+	const meshHandle_t cubeMesh = resourcesAddMesh(meshCreate("resources/models/cube_fixed.obj", F_MESH_PACKED));
+	// Same monkey, drawn through its arena's instanced vao
+	const meshHandle_t instanceMesh = resourcesRetainMesh(monkeyMesh);
+
+	// Everything set up here lives until shutdown, so it's bumped out of one arena instead of malloc'd piece by piece
+	arena_t sceneArena;
+	arenaInit(&sceneArena, "scene", 64 * 1024);
+	arenaInit(&frameArena, "frame", ARENA_FRAME_SIZE);
+	uniformsInit();
+
+	const uint32_t numMonkeyMeshlets = resourcesGetMesh(monkeyMesh)->numMeshlets;
+	GLsizei* meshletCounts = arenaAlloc(&sceneArena, (numMonkeyMeshlets + 1) * sizeof(GLsizei));
+	const void** meshletOffsets = arenaAlloc(&sceneArena, (numMonkeyMeshlets + 1) * sizeof(void*));
+
+	// Everything drawn one at a time, world & normal matrices are only rebuilt when something moves
+	transforms_t* transforms = transformsCreate(64);
+	const versor noRotation = GLM_QUAT_IDENTITY_INIT;
+	const uint32_t floorTransform = transformAdd(transforms, TRANSFORM_ROOT, (vec3){0.f, -8.f, 0.f}, noRotation,
+												 (vec3){20.f, .5f, 20.f});
+	// Between & behind the monkeys, clear of both
+	const uint32_t backpackTransform = transformAdd(transforms, TRANSFORM_ROOT, (vec3){0.f, 10.f, -8.f}, noRotation,
+													(vec3){1.f, 1.f, 1.f});
+	const uint32_t explodeTransform = transformAdd(transforms, TRANSFORM_ROOT, (vec3){-5.f, 10.f, 0.f}, noRotation,
+												   (vec3){1.f, 1.f, 1.f});
+	const uint32_t spikyTransform = transformAdd(transforms, TRANSFORM_ROOT, (vec3){5.f, 10.f, 0.f}, noRotation,
+												 (vec3){1.f, 1.f, 1.f});
+	const uint32_t lampTransform = transformAdd(transforms, TRANSFORM_ROOT, (vec3){0.f, 15.f, 0.f}, noRotation,
+												(vec3){.2f, .2f, .2f});
+	const uint32_t grassTransform = transformAdd(transforms, TRANSFORM_ROOT, (vec3){0.f, -6.f, 0.f}, noRotation,
+												 (vec3){2.f, 2.f, 2.f});
 
 	// Load image, create texture & generate mipmaps
 	stbi_set_flip_vertically_on_load(1);
 
 	// load textures
-	const GLuint diffuseTexture = loadTextureFromFile("resources/textures/brickwall.jpg", GL_REPEAT, GL_REPEAT);
-	const GLuint specularTexture = loadTextureFromFile("resources/textures/brickwall_specular.jpg", GL_REPEAT, GL_REPEAT);
+	const textureHandle_t diffuseTexture = resourcesAddTexture(loadTextureFromFile("resources/textures/brickwall.jpg", GL_REPEAT, GL_REPEAT));
+	const textureHandle_t specularTexture = resourcesAddTexture(loadTextureFromFile("resources/textures/brickwall_specular.jpg", GL_REPEAT, GL_REPEAT));
+	const textureHandle_t normalTexture = resourcesAddTexture(loadTextureFromFile("resources/textures/brickwall_normal.jpg", GL_REPEAT, GL_REPEAT));
 	// GLuint emissionMap = loadTextureFromFile("resources/textures/container2_emission.png");
-	const GLuint grassTexture = loadTextureFromFile("resources/textures/grass.png", GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
-	const GLuint grassSpecularTexture = loadTextureFromFile("resources/textures/grass_specular.png", GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	const textureHandle_t grassTexture = resourcesAddTexture(loadTextureFromFile("resources/textures/grass.png", GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE));
+	const textureHandle_t grassSpecularTexture = resourcesAddTexture(loadTextureFromFile("resources/textures/grass_specular.png", GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE));
 
 	stbi_set_flip_vertically_on_load(0);
 	const char* faces[] = {
@@ -362,34 +442,24 @@ int main()
 		"resources/textures/skybox/front.jpg",
 		"resources/textures/skybox/back.jpg",
 	};
-	const GLuint skyboxTexture = loadCubeMapTextureFromFiles(faces, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+	const textureHandle_t skyboxTexture = resourcesAddTexture(loadCubeMapTextureFromFiles(faces, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE,
+																						  GL_CLAMP_TO_EDGE));
 	stbi_set_flip_vertically_on_load(1);
 
-	// Set shader uniforms
-	glUseProgram(shaderLighting);
-	// setUniform1i(&shaderLighting, "u_material.flags", F_MAT_DIFFUSE | F_MAT_SPECULAR);
-	setUniform1i(&shaderLighting, "u_material.diffuseTex", 0);
-	setUniform1i(&shaderLighting, "u_material.specularTex", 1);
-	setUniform1f(&shaderLighting, "u_material.shininess", 32.f);
-	setUniform1i(&shaderLighting, "u_skybox", 2);
-
-	glUseProgram(shaderQuadTexture);
-	setUniform1i(&shaderQuadTexture, "u_texture", 0);
-
-	glUseProgram(shaderSkybox);
-	setUniform1i(&shaderSkybox, "u_texture", 0);
-
-	glUseProgram(shaderGeomExplode);
-	setUniform1i(&shaderGeomExplode, "u_texture", 0);
+	// Loaded in the background, the cube stands in until they're uploaded
+	// The backpack's mtl textures load on upload, after the flip so they match, & only if it has been downloaded
+	meshLoader_t* meshLoader = meshLoaderCreate(NULL, NULL);
+	meshLoadHandle_t* lampLoad = meshLoadAsync(meshLoader, "resources/models/ico_sphere.obj", F_MESH_PACKED);
+	uint64_t backpackSize, backpackMtime;
+	meshLoadHandle_t* backpackLoad = fileStat("resources/models/backpack/backpack.obj", &backpackSize, &backpackMtime) ?
+		meshLoadAsync(meshLoader, "resources/models/backpack/backpack.obj", F_MESH_PACKED) : NULL;
+	// Exported scenes, nothing to parse but the json header so it loads up front
+	uint64_t sceneSize, sceneMtime;
+	gltfScene_t* scene = fileStat("resources/models/scene.glb", &sceneSize, &sceneMtime) ?
+		gltfLoad("resources/models/scene.glb", transforms) : NULL;
 
 	// generate list of transforms
-	mat4* modelMatrices = malloc(sizeof(mat4) * instanceAmount);
-	if (modelMatrices == NULL)
-	{
-		fprintf(stderr, "Out of memory! Failed to allocate model matrices!\n");
-		free(modelMatrices);
-		exit(EXIT_FAILURE);
-	}
+	mat4* modelMatrices = arenaAlloc(&sceneArena, sizeof(mat4) * instanceAmount);
 	const float radius = 10.f;
 	const float offset = 10.f;
 	for (int i = 0; i < instanceAmount; i++)
@@ -420,39 +490,27 @@ int main()
 	}
 	printf("Generate model matrices\n");
 
+	// Instances never move so their world bounds are only computed once
+	cullSpheres_t* instanceSpheres = cullSpheresCreate(instanceAmount);
+	instancesTotal = (size_t) instanceAmount;
+	for (int i = 0; i < instanceAmount; i++)
+	{
+		vec3 center;
+		float sphereRadius;
+		meshGetWorldSphere(resourcesGetMesh(instanceMesh), modelMatrices[i], center, &sphereRadius);
+		cullSpheresSet(instanceSpheres, i, center, sphereRadius);
+	}
+	printf("Instance culling uses the %s path\n", cullPathName(cullGetPath()));
+
 	// configure instanced array
+	// The mesh's geometry arena has an instanced vao with the mat4 attributes already set up, it only needs the buffer
 	GLuint instanceBuffer;
-	glBindVertexArray(meshInstance->vao);
 	glCreateBuffers(1, &instanceBuffer);
-	glNamedBufferData(instanceBuffer, instanceAmount * sizeof(mat4), &modelMatrices[0], GL_STATIC_DRAW);
-	// glNamedBufferData(instanceBuffer, sizeof(modelMatrices), modelMatrices, GL_STATIC_DRAW);
-
-	glVertexArrayVertexBuffer(meshInstance->vao, 1, instanceBuffer, 0, sizeof(mat4));
-
-	// set transformation matrices as an instance vertex attribute (with divisor 1)
-	// note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
-	// normally you'd want to do this in a more organized fashion, but for learning purposes this will do.
-	// -----------------------------------------------------------------------------------------------------------------------------------
-	// ^^ This comment was copied from learnopengl.com ^^
-	glVertexArrayAttribFormat(meshInstance->vao, 3, 4, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(meshInstance->vao, 3, 1);
-	glVertexArrayAttribFormat(meshInstance->vao, 4, 4, GL_FLOAT, GL_FALSE, sizeof(vec4));
-	glVertexArrayAttribBinding(meshInstance->vao, 4, 1);
-	glVertexArrayAttribFormat(meshInstance->vao, 5, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(vec4));
-	glVertexArrayAttribBinding(meshInstance->vao, 5, 1);
-	glVertexArrayAttribFormat(meshInstance->vao, 6, 4, GL_FLOAT, GL_FALSE, 3 * sizeof(vec4));
-	glVertexArrayAttribBinding(meshInstance->vao, 6, 1);
-
-	glVertexArrayBindingDivisor(meshInstance->vao, 1, 1);
-
-	glEnableVertexArrayAttrib(meshInstance->vao, 3);
-	glEnableVertexArrayAttrib(meshInstance->vao, 4);
-	glEnableVertexArrayAttrib(meshInstance->vao, 5);
-	glEnableVertexArrayAttrib(meshInstance->vao, 6);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	glNamedBufferData(instanceBuffer, instanceAmount * sizeof(mat4), &modelMatrices[0], GL_DYNAMIC_DRAW);
+	glVertexArrayVertexBuffer(resourcesGetMesh(instanceMesh)->instancedVao, GEOMETRY_INSTANCE_BINDING, instanceBuffer, 0,
+							  sizeof(mat4));
 	printf("Model instance vbo\n");
+	geometryPrintStats();
 
 	// Framebuffer
 	framebuffer = framebufferCreate(WIDTH, HEIGHT);
@@ -532,6 +590,9 @@ int main()
 	lights[2].specular[2] = 1.f;
 	lights[2].range = 200.f;
 
+	lightBuffer_t* lightBuffer = lightBufferCreate();
+	const GLuint frameBlock = frameBlockCreate();
+
 	mat4 view, projection, identity;
 
 	glm_mat4_identity(identity);
@@ -539,13 +600,37 @@ int main()
 	glm_mat4_identity(projection);
 	printf("Starting main loop\n");
 
+#ifdef ARENA_CHECK_HEAP
+	uint64_t frameCount = 0;
+#endif
 	while (!glfwWindowShouldClose(window))
 	{
+		arenaReset(&frameArena);
+
 		// Update/Input
 		const float currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
+		meshLoaderUpdate(meshLoader, MESH_LOADER_BUDGET_MS);
+		meshesLoading = meshLoaderInFlight(meshLoader);
+		meshLoadMs = meshLoader->lastUpdateMs;
+		shadersCompiling = shaderBatch.numPending > 0 ? shaderBatchUpdate(&shaderBatch, false) : 0;
+		shaderCheckMs = shaderBatch.lastUpdateMs;
+
+		// Uploads add to the mesh pool, so pointers are only taken after them & dropped at the end of the frame
+		mesh_t* meshMonkey = resourcesGetMesh(monkeyMesh);
+		mesh_t* meshCube = resourcesGetMesh(cubeMesh);
+		mesh_t* meshInstance = resourcesGetMesh(instanceMesh);
+		mesh_t* meshPlaneCross = resourcesGetMesh(planeCrossMesh);
+		mesh_t* meshQuad = resourcesGetMesh(quadMesh);
+		mesh_t* meshSkybox = resourcesGetMesh(skyboxMesh);
+		shaderSingleColor = resourcesGetShader(singleColorShader);
+		shaderQuadTexture = resourcesGetShader(quadTextureShader);
+		shaderSkybox = resourcesGetShader(skyboxShader);
+		shaderGeomExplode = resourcesGetShader(geomExplodeShader);
+		shaderGeomNormals = resourcesGetShader(geomNormalsShader);
+
 		memcpy(&lights[1].position, &camera->position, sizeof(vec3));
 		memcpy(&lights[1].direction, &camera->front, sizeof(vec3));
 
@@ -562,21 +647,35 @@ int main()
 		//lights[2].position[0] = 1.2f * cosf(currentFrame);
 		lights[2].position[0] = sinf(currentFrame) * 4.f;
 		lights[2].position[2] = cosf(currentFrame) * 4.f;
+		lights[1].dirty = true;
+		lights[2].dirty = true;
+
+		versor spin;
+		glm_quatv(spin, currentFrame, (vec3){0.f, 1.f, 0.f});
+		transformSetRotation(transforms, spikyTransform, spin);
+		transformSetTranslation(transforms, lampTransform, lights[2].position);
+		transformsUpdate(transforms);
+		transformsUpdated = transforms->numUpdated;
+		transformsTotal = transforms->count;
 
 		guiUpdate();
 
 		processInput(window);
+#ifdef ARENA_CHECK_HEAP
+		// Checked up to the gui render, imgui & the mesh loader grow their own pools as things appear
+		const uint64_t frameHeapStart = arenaHeapAllocations();
+#endif
 
 		// Render
 		if (postProcessing)
 		{
 			framebufferClear(framebuffer);
 			framebufferBindToDraw(framebuffer);
-			glEnable(GL_DEPTH_TEST);
+			glStateSetEnabled(GL_DEPTH_TEST, true);
 		} else
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			glEnable(GL_DEPTH_TEST);
+			glStateBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glStateSetEnabled(GL_DEPTH_TEST, true);
 		}
 
 		glClearColor(clearColor[0], clearColor[1], clearColor[2], 1.f);
@@ -584,64 +683,99 @@ int main()
 
 		glm_perspective(RAD(camera->fov), (float) framebuffer->width / (float) framebuffer->height, camera->near, camera->far, projection);
 		cameraGetViewMatrix(camera, &view);
+		mat4 viewProjection;
+		glm_mat4_mul(projection, view, viewProjection);
+		cameraUpdateFrustum(camera, viewProjection);
+		frameBlockUpdate(frameBlock, camera, view, projection, currentFrame, framebuffer->width, framebuffer->height);
 
 		// lights & models affected by lights
-		glUseProgram(shaderLighting);
-		setUniform1i(&shaderLighting, "u_isInstance", 0);
-		for (int i = 0; i < MAX_LIGHTS; i++)
-		{
-			char lightParam[23];
-			sprintf(lightParam, "u_lights[%d].enable", i);
-			setUniform1i(&shaderLighting, lightParam, lights[i].enable);
-			if (!lights[i].enable)
-				continue;
-
-			sprintf(lightParam, "u_lights[%d].mode", i);
-			setUniform1i(&shaderLighting, lightParam, lights[i].mode);
-			sprintf(lightParam, "u_lights[%d].position", i);
-			setUniform3fv(&shaderLighting, lightParam, lights[i].position);
-			sprintf(lightParam, "u_lights[%d].direction", i);
-			setUniform3fv(&shaderLighting, lightParam, lights[i].direction);
-			sprintf(lightParam, "u_lights[%d].cutOffInner", i);
-			setUniform1f(&shaderLighting, lightParam, cosf(RAD(lights[i].cutOffInner)));
-			sprintf(lightParam, "u_lights[%d].cutOffOuter", i);
-			setUniform1f(&shaderLighting, lightParam, cosf(RAD(lights[i].cutOffOuter)));
-
-			sprintf(lightParam, "u_lights[%d].ambient", i);
-			setUniform3fv(&shaderLighting, lightParam, lights[i].ambient);
-			sprintf(lightParam, "u_lights[%d].diffuse", i);
-			setUniform3fv(&shaderLighting, lightParam, lights[i].diffuse);
-			sprintf(lightParam, "u_lights[%d].specular", i);
-			setUniform3fv(&shaderLighting, lightParam, lights[i].specular);
-
-			sprintf(lightParam, "u_lights[%d].constant", i);
-			setUniform1f(&shaderLighting, lightParam, 1.f);
-			sprintf(lightParam, "u_lights[%d].linear", i);
-			setUniform1f(&shaderLighting, lightParam, 4.5f / lights[i].range);
-			sprintf(lightParam, "u_lights[%d].quadratic", i);
-			setUniform1f(&shaderLighting, lightParam, 75.f / (lights[i].range * lights[i].range));
-		}
+		lightBufferUpdate(lightBuffer, lights, MAX_LIGHTS);
+		lightsPacked = lightBuffer->numPacked;
+		lightsWritten = lightBuffer->numWritten;
+
+		shaderVariantsNextFrame(&lightingVariants);
+		shaderLighting = shaderVariantGet(&lightingVariants, lightingKey(lightBuffer, 0), shaderSingleColor);
+		shaderLightingNormal = shaderVariantGet(&lightingVariants, lightingKey(lightBuffer, LIGHTING_HAS_NORMAL_MAP),
+												shaderSingleColor);
+		// Instances don't normal map
+		shaderLightingInstanced = shaderVariantGet(&lightingVariants, lightingKey(lightBuffer, LIGHTING_INSTANCED),
+												   shaderSingleColor);
+		shaderLightingGltf = shaderVariantGet(&lightingVariants, lightingKey(lightBuffer, LIGHTING_GLTF_VERTICES),
+											  shaderSingleColor);
+		shaderLightingGltfNormal = shaderVariantGet(&lightingVariants,
+													lightingKey(lightBuffer, LIGHTING_GLTF_VERTICES | LIGHTING_HAS_NORMAL_MAP),
+													shaderSingleColor);
+		lightingVariantsBuilt = lightingVariants.batch.numBuilds;
+		lightingVariantsPending = lightingVariants.batch.numPending;
+		lightingVariantsEvicted = lightingVariants.numEvicted;
+		lightingVariantsMs = lightingVariants.batch.buildMs;
+
+		glStateUseProgram(shaderLightingNormal);
 
-		setUniform3fv(&shaderLighting, "u_viewPos", camera->position);
+		// Cube
+		glStateBindTextureUnit(0, resourcesGetTexture(diffuseTexture));
+		glStateBindTextureUnit(1, resourcesGetTexture(specularTexture));
+		// glBindTextureUnit(2, emissionMap);
+		glStateBindTextureUnit(2, resourcesGetTexture(skyboxTexture));
+		glStateBindTextureUnit(MATERIAL_UNIT_NORMAL, resourcesGetTexture(normalTexture));
 
-		// setUniform1f(&shaderLighting, "u_time", currentFrame);
+		setModelUniforms(&shaderLightingNormal, transforms, floorTransform);
+		meshSetUniforms(meshCube, shaderLightingNormal);
+		meshDraw(meshCube);
 
-		setUniformMatrix4fv(&shaderLighting, "u_view", (GLfloat*) view);
-		setUniformMatrix4fv(&shaderLighting, "u_projection", (GLfloat*) projection);
+		if (scene)
+		{
+			for (uint32_t i = 0; i < scene->numModels; i++)
+			{
+				const model_t* sceneModel = resourcesGetModel(scene->models[i]);
+				const mesh_t* sceneMesh = resourcesGetMesh(sceneModel->mesh);
+				vec4* model = transforms->worlds[sceneModel->transform];
+				if (frustumCulling && !meshInFrustum(sceneMesh, model, camera))
+					continue;
+				// Meshes uploaded in glTF's own layout need the variants that read it
+				GLuint program = sceneMesh->gltfVertices ? shaderLightingGltf : shaderLighting;
+				GLuint normalProgram = sceneMesh->gltfVertices ? shaderLightingGltfNormal : shaderLightingNormal;
+				setModelUniforms(&program, transforms, sceneModel->transform);
+				setModelUniforms(&normalProgram, transforms, sceneModel->transform);
+				meshSetUniforms(sceneMesh, program);
+				meshSetUniforms(sceneMesh, normalProgram);
+				meshDrawMaterials(sceneMesh, meshSelectLod(sceneMesh, model, camera, (float) framebuffer->height, lodPixelError),
+								  program, normalProgram);
+			}
+		}
 
-		// Cube
-		glBindTextureUnit(0, diffuseTexture);
-		glBindTextureUnit(1, specularTexture);
-		// glBindTextureUnit(2, emissionMap);
-		glBindTextureUnit(2, skyboxTexture);
+		if (backpackLoad)
+		{
+			const mesh_t* meshBackpack = resourcesGetMesh(meshLoadGet(backpackLoad, cubeMesh));
+			vec4* model = transforms->worlds[backpackTransform];
+			if (!frustumCulling || meshInFrustum(meshBackpack, model, camera))
+			{
+				setModelUniforms(&shaderLighting, transforms, backpackTransform);
+				setModelUniforms(&shaderLightingNormal, transforms, backpackTransform);
+				meshSetUniforms(meshBackpack, shaderLighting);
+				meshSetUniforms(meshBackpack, shaderLightingNormal);
+				meshDrawMaterials(meshBackpack, meshSelectLod(meshBackpack, model, camera, (float) framebuffer->height, lodPixelError),
+								  shaderLighting, shaderLightingNormal);
+			}
+		}
 
-		mat4 model;
-		glm_mat4_identity(model);
-		glm_translate(model, (vec3){0.f, -8.f, 0.f});
-		glm_scale(model, (vec3){20.f, .5f, 20.f});
-		setUniformMatrix4fv(&shaderLighting, "u_model", (GLfloat*) model);
-		glBindVertexArray(meshCube->vao);
-		glDrawArrays(GL_TRIANGLES, 0, meshCube->numVertices);
+		if (scene || backpackLoad)
+		{
+			// Back to the brickwall for everything else
+			glStateBindTextureUnit(0, resourcesGetTexture(diffuseTexture));
+			glStateBindTextureUnit(1, resourcesGetTexture(specularTexture));
+			glStateBindTextureUnit(MATERIAL_UNIT_NORMAL, resourcesGetTexture(normalTexture));
+			const GLuint materialPrograms[2] = {shaderLighting, shaderLightingNormal};
+			for (int i = 0; i < 2; i++)
+			{
+				const GLuint* program = &materialPrograms[i];
+				setUniformLocation3fv(program, shaderGetLocation(*program, uniforms.materialDiffuseColor),
+									  (vec3){1.f, 1.f, 1.f});
+				setUniformLocation3fv(program, shaderGetLocation(*program, uniforms.materialSpecularColor),
+									  (vec3){1.f, 1.f, 1.f});
+				setUniformLocation1f(program, shaderGetLocation(*program, uniforms.materialShininess), 32.f);
+			}
+		}
 
 		// glBindVertexArray(meshMonkey->vao);
 		// for (int i = 0; i < instanceAmount; i++)
@@ -655,108 +789,155 @@ int main()
 		// 	// glm_mat4_scale(model, .5f);
 		// 	glm_scale(model, (vec3){.5f, .5f, .5f});
 		// 	setUniformMatrix4fv(&shaderLighting, "u_model", (GLfloat*) model);
-		// glDrawArrays(GL_TRIANGLES, 0, meshMonkey->numVertices);
+		// meshDraw(meshMonkey);
 		// }
 
-		setUniform1i(&shaderLighting, "u_isInstance", 1);
-		glBindVertexArray(meshInstance->vao);
-		glDrawArraysInstanced(GL_TRIANGLES, 0, meshInstance->numVertices, instanceAmount);
-		setUniform1i(&shaderLighting, "u_isInstance", 0);
-
-		// Exploding monkey
-		glUseProgram(shaderGeomExplode);
-		glBindTextureUnit(0, diffuseTexture);
-		setUniform1f(&shaderGeomExplode, "u_time", currentFrame);
-
-		setUniformMatrix4fv(&shaderGeomExplode, "u_projection", (GLfloat*) projection);
-		setUniformMatrix4fv(&shaderGeomExplode, "u_view", (GLfloat*) view);
+		// Cull, then bucket the survivors by lod so only visible matrices get uploaded & every lod is one draw
+		uint32_t* visibleInstances = arenaAlloc(&frameArena, sizeof(uint32_t) * instanceAmount);
+		uint8_t* instanceLods = arenaAlloc(&frameArena, instanceAmount);
+		mat4* lodMatrices = arenaAlloc(&frameArena, sizeof(mat4) * instanceAmount);
+		const double cullStart = timeGetSeconds();
+		if (frustumCulling)
+			instancesVisible = cullFrustumSpheres(&camera->frustum, instanceSpheres, visibleInstances);
+		else
+		{
+			for (int i = 0; i < instanceAmount; i++)
+				visibleInstances[i] = (uint32_t) i;
+			instancesVisible = (size_t) instanceAmount;
+		}
+		instanceCullMs = (timeGetSeconds() - cullStart) * 1000.;
 
-		glBindVertexArray(meshMonkey->vao);
-		glm_mat4_identity(model);
-		glm_translate(model, (vec3){-5.f, 10.f, 0.f});
-		setUniformMatrix4fv(&shaderGeomExplode, "u_model", (GLfloat*) model);
-		glDrawArrays(GL_TRIANGLES, 0, meshMonkey->numVertices);
+		memset(lodInstanceCounts, 0, sizeof(lodInstanceCounts));
+		for (size_t i = 0; i < instancesVisible; i++)
+		{
+			const uint32_t instance = visibleInstances[i];
+			instanceLods[i] = (uint8_t) meshSelectLod(meshInstance, modelMatrices[instance], camera,
+													  (float) framebuffer->height, lodPixelError);
+			lodInstanceCounts[instanceLods[i]]++;
+		}
+		int lodOffsets[MESH_MAX_LODS];
+		int lodOffset = 0;
+		for (uint32_t lod = 0; lod < MESH_MAX_LODS; lod++)
+		{
+			lodOffsets[lod] = lodOffset;
+			lodOffset += lodInstanceCounts[lod];
+		}
+		for (size_t i = 0; i < instancesVisible; i++)
+			glm_mat4_copy(modelMatrices[visibleInstances[i]], lodMatrices[lodOffsets[instanceLods[i]]++]);
+		if (instancesVisible > 0)
+			glNamedBufferSubData(instanceBuffer, 0, (GLsizeiptr) (instancesVisible * sizeof(mat4)), lodMatrices);
+
+		glStateUseProgram(shaderLightingInstanced);
+		meshSetUniforms(meshInstance, shaderLightingInstanced);
+		instanceTriangles = 0;
+		instanceTrianglesFull = (size_t) instanceAmount * (meshInstance->lods[0].numIndices / 3); // Nothing culled, all lod 0
+		lodOffset = 0;
+		for (uint32_t lod = 0; lod < meshInstance->numLods; lod++)
+		{
+			if (lodInstanceCounts[lod] > 0)
+				meshDrawInstancedLod(meshInstance, lod, lodInstanceCounts[lod], (GLuint) lodOffset);
+			lodOffset += lodInstanceCounts[lod];
+			instanceTriangles += (size_t) lodInstanceCounts[lod] * (meshInstance->lods[lod].numIndices / 3);
+		}
 
-		// Spiky monkey
-		glUseProgram(shaderLighting);
-		glBindVertexArray(meshMonkey->vao);
-		glm_mat4_identity(model);
-		glm_translate(model, (vec3){5.f, 10.f, 0.f});
-		glm_rotate(model, currentFrame, (vec3){0.f, 1.f, 0.f});
-		setUniformMatrix4fv(&shaderLighting, "u_model", (GLfloat*) model);
-		glDrawArrays(GL_TRIANGLES, 0, meshMonkey->numVertices);
+		// Exploding monkey
+		glStateUseProgram(shaderGeomExplode);
+		glStateBindTextureUnit(0, resourcesGetTexture(diffuseTexture));
+		setUniformLocationMatrix4fv(&shaderGeomExplode, shaderGetLocation(shaderGeomExplode, uniforms.model),
+									(GLfloat*) transforms->worlds[explodeTransform]);
+		meshSetUniforms(meshMonkey, shaderGeomExplode);
+		meshDrawLod(meshMonkey, meshSelectLod(meshMonkey, transforms->worlds[explodeTransform], camera, (float) framebuffer->height, lodPixelError));
+
+		// Spiky monkey, still wearing the brickwall's normal map
+		glStateUseProgram(shaderLightingNormal);
+		vec4* model = transforms->worlds[spikyTransform];
+		const bool spikyVisible = !frustumCulling || meshInFrustum(meshMonkey, model, camera);
+		setModelUniforms(&shaderLightingNormal, transforms, spikyTransform);
+		meshSetUniforms(meshMonkey, shaderLightingNormal);
+		const uint32_t spikyLod = meshSelectLod(meshMonkey, model, camera, (float) framebuffer->height, lodPixelError);
+		// Meshlets only cover lod 0, coarser lods are small enough to draw whole
+		meshletDraws = 0;
+		meshletTriangles = meshletTrianglesTotal = meshMonkey->lods[spikyLod].numIndices / 3;
+		if (!spikyVisible)
+			meshletTriangles = 0;
+		else if (meshletCulling && spikyLod == 0 && meshMonkey->numMeshlets > 0)
+		{
+			meshletDraws = meshCullMeshlets(meshMonkey->meshlets, meshMonkey->numMeshlets, meshMonkey->indexType, model, camera,
+											meshletCounts, meshletOffsets);
+			meshletTriangles = 0;
+			for (GLsizei i = 0; i < meshletDraws; i++)
+				meshletTriangles += (uint32_t) meshletCounts[i] / 3;
+			meshDrawMeshlets(meshMonkey, meshletCounts, meshletOffsets, meshletDraws, &frameArena);
+		} else
+			meshDrawLod(meshMonkey, spikyLod);
 
-		glUseProgram(shaderGeomNormals);
-		setUniformMatrix4fv(&shaderGeomNormals, "u_projection", (GLfloat*) projection);
-		setUniformMatrix4fv(&shaderGeomNormals, "u_view", (GLfloat*) view);
-		setUniformMatrix4fv(&shaderGeomNormals, "u_model", (GLfloat*) model);
-		glDrawArrays(GL_TRIANGLES, 0, meshMonkey->numVertices);
+		glStateUseProgram(shaderGeomNormals);
+		setUniformLocationMatrix4fv(&shaderGeomNormals, shaderGetLocation(shaderGeomNormals, uniforms.model),
+									(GLfloat*) model);
+		meshSetUniforms(meshMonkey, shaderGeomNormals);
+		if (spikyVisible)
+			meshDrawLod(meshMonkey, spikyLod);
 
 		// Lamp
-		glUseProgram(shaderSingleColor);
-		setUniform3fv(&shaderSingleColor, "u_color", lightColor);
+		glStateUseProgram(shaderSingleColor);
+		setUniformLocation3fv(&shaderSingleColor, shaderGetLocation(shaderSingleColor, uniforms.color), lightColor);
 
-		setUniformMatrix4fv(&shaderSingleColor, "u_view", (GLfloat*) view);
-		setUniformMatrix4fv(&shaderSingleColor, "u_projection", (GLfloat*) projection);
-
-		glm_mat4_identity(model);
-		glm_translate(model, lights[2].position);
-		// glm_mat4_scale(model, .2f);
-		glm_scale(model, (vec3){.2f, .2f, .2f});
-		setUniformMatrix4fv(&shaderSingleColor, "u_model", (GLfloat*) model);
-		glBindVertexArray(meshCube->vao);
-		glDrawArrays(GL_TRIANGLES, 0, meshCube->numVertices);
+		setUniformLocationMatrix4fv(&shaderSingleColor, shaderGetLocation(shaderSingleColor, uniforms.model),
+									(GLfloat*) transforms->worlds[lampTransform]);
+		const mesh_t* meshLamp = resourcesGetMesh(meshLoadGet(lampLoad, cubeMesh));
+		meshSetUniforms(meshLamp, shaderSingleColor);
+		meshDraw(meshLamp);
 
 		// skybox
-		glDepthFunc(GL_LEQUAL);
-		glUseProgram(shaderSkybox);
-		mat4 skyboxView;
-		glm_mat4_copy(view, skyboxView);
-		mat3 viewMat3;
-		glm_mat4_pick3(skyboxView, viewMat3);
-		glm_mat4_identity(skyboxView);
-		glm_mat4_ins3(viewMat3, skyboxView);
-		setUniformMatrix4fv(&shaderSkybox, "u_view", (GLfloat*) skyboxView);
-		setUniformMatrix4fv(&shaderSkybox, "u_projection", (GLfloat*) projection);
-
-		glBindTextureUnit(0, skyboxTexture);
-		glBindVertexArray(vaoSkybox);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-		glDepthFunc(GL_LESS);
-
-		glBindVertexArray(meshCube->vao);
-		glDrawArrays(GL_TRIANGLES, 0, meshCube->numVertices);
+		glStateDepthFunc(GL_LEQUAL);
+		glStateUseProgram(shaderSkybox);
+		glStateBindTextureUnit(0, resourcesGetTexture(skyboxTexture));
+		meshSetUniforms(meshSkybox, shaderSkybox);
+		meshDraw(meshSkybox);
+		glStateBindVertexArray(0);
+		glStateDepthFunc(GL_LESS);
+
+		meshSetUniforms(meshCube, shaderSkybox);
+		meshDraw(meshCube);
 
 		// grass
-		glUseProgram(shaderLighting);
-		glBindTextureUnit(0, grassTexture);
-		glBindTextureUnit(1, grassSpecularTexture);
+		glStateUseProgram(shaderLighting);
+		glStateBindTextureUnit(0, resourcesGetTexture(grassTexture));
+		glStateBindTextureUnit(1, resourcesGetTexture(grassSpecularTexture));
 
-		glm_mat4_identity(model);
-		glm_translate(model, (vec3){0.f, -6.f, 0.f});
-		// glm_mat4_scale(model, 2.f);
-		glm_scale(model, (vec3){2.f, 2.f, 2.f});
-		setUniformMatrix4fv(&shaderLighting, "u_model", (GLfloat*) model);
-		glBindVertexArray(vaoPlaneCross);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		setModelUniforms(&shaderLighting, transforms, grassTransform);
+		meshSetUniforms(meshPlaneCross, shaderLighting);
+		meshDraw(meshPlaneCross);
 
 		if (postProcessing)
 		{
 			framebufferCopyToDefault(framebuffer);
 
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-			glDisable(GL_DEPTH_TEST);
+			glStateBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glStateSetEnabled(GL_DEPTH_TEST, false);
 
 			glClearColor(1.f, 1.f, 1.f, 1.f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			glUseProgram(shaderQuadTexture);
-			glBindVertexArray(vaoQuad);
-			glBindTextureUnit(0, framebuffer->colorTex);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
+			glStateUseProgram(shaderQuadTexture);
+			glStateBindTextureUnit(0, framebuffer->colorTex);
+			meshDraw(meshQuad);
 		}
 
+#ifdef ARENA_CHECK_HEAP
+		const uint64_t frameHeapAllocations = arenaHeapAllocations() - frameHeapStart;
+		if (++frameCount > ARENA_WARMUP_FRAMES && frameHeapAllocations > 0)
+		{
+			fprintf(stderr, "Frame %llu made %llu heap allocations after warm up!\n", (unsigned long long) frameCount,
+					(unsigned long long) frameHeapAllocations);
+			abort();
+		}
+#endif
+
+		lightBufferFence(lightBuffer);
+		const glStateStats_t glStats = glStateEndFrame();
+		glCallsIssued = glStats.issued;
+		glCallsElided = glStats.elided;
 		guiRender();
 
 		// Swap buffers & poll IO
@@ -768,37 +949,51 @@ int main()
 	guiTerminate();
 	cameraDelete(camera);
 
-	glDeleteVertexArrays(1, &vaoPlaneCross);
-	glDeleteBuffers(1, &vboPlaneCross);
-
-	glDeleteVertexArrays(1, &vaoQuad);
-	glDeleteBuffers(1, &vboQuad);
-
-	glDeleteVertexArrays(1, &vaoSkybox);
-	glDeleteBuffers(1, &vboSkybox);
-
 	glDeleteBuffers(1, &instanceBuffer);
-	free(modelMatrices);
-
-	meshDestroy(meshMonkey);
-	meshDestroy(meshCube);
-	meshDestroy(meshInstance);
-
-	glDeleteProgram(shaderLighting);
-	glDeleteProgram(shaderSingleColor);
-	glDeleteProgram(shaderQuadTexture);
-	glDeleteProgram(shaderSkybox);
-
-	glDeleteProgram(shaderGeomExplode);
-	glDeleteProgram(shaderGeomNormals);
-
-	glDeleteTextures(1, &diffuseTexture);
-	glDeleteTextures(1, &specularTexture);
-
-	glDeleteTextures(1, &grassTexture);
-	glDeleteTextures(1, &grassSpecularTexture);
-
-	glDeleteTextures(1, &skyboxTexture);
+	cullSpheresDestroy(instanceSpheres);
+	lightBufferDestroy(lightBuffer);
+	frameBlockDestroy(frameBlock);
+	transformsDestroy(transforms);
+	arenaDestroy(&sceneArena);
+	arenaDestroy(&frameArena);
+	arenaScratchRelease();
+
+	resourcesReleaseMesh(monkeyMesh);
+	resourcesReleaseMesh(cubeMesh);
+	resourcesReleaseMesh(instanceMesh);
+	if (meshLoadGetState(lampLoad) == MESH_LOAD_READY)
+		resourcesReleaseMesh(lampLoad->mesh);
+	if (backpackLoad && meshLoadGetState(backpackLoad) == MESH_LOAD_READY)
+		resourcesReleaseMesh(backpackLoad->mesh);
+	if (scene)
+		gltfSceneDestroy(scene);
+	meshLoaderDestroy(meshLoader);
+	resourcesReleaseMesh(planeCrossMesh);
+	resourcesReleaseMesh(quadMesh);
+	resourcesReleaseMesh(skyboxMesh);
+
+	// Anything still compiling is finished so its program is released with the handle
+	shaderBatchUpdate(&shaderBatch, true);
+	shaderVariantsDestroy(&lightingVariants);
+	resourcesReleaseShader(singleColorShader);
+	resourcesReleaseShader(quadTextureShader);
+	resourcesReleaseShader(skyboxShader);
+
+	resourcesReleaseShader(geomExplodeShader);
+	resourcesReleaseShader(geomNormalsShader);
+
+	resourcesReleaseTexture(diffuseTexture);
+	resourcesReleaseTexture(specularTexture);
+	resourcesReleaseTexture(normalTexture);
+
+	resourcesReleaseTexture(grassTexture);
+	resourcesReleaseTexture(grassSpecularTexture);
+
+	resourcesReleaseTexture(skyboxTexture);
+	// Anything left over is a leak, it's reported & destroyed before the arenas go
+	resourcesDestroyPools();
+	materialShutdown();
+	geometryDestroyArenas();
 
 	framebufferDestroy(framebuffer);
 
@@ -924,27 +1119,30 @@ void guiLightSettings(const char* label, light_t* light)
 		igCheckbox("Enable", &light->enable);
 		if (light->enable)
 		{
-			igInputText("Name", light->name, sizeof(light->name), 0, NULL, NULL);
+			light->dirty |= igInputText("Name", light->name, sizeof(light->name), 0, NULL, NULL);
 
 			const char* lightModes[] = {"Direct", "Point", "Spot"};
 			int lightCurrent = light->mode - 1;
 			if (igListBox_Str_arr("Mode", &lightCurrent, lightModes, 3, 3))
+			{
 				light->mode = lightCurrent + 1;
+				light->dirty = true;
+			}
 
 			igSeparator();
-			igInputFloat3("Position", light->position, "%.3f", 0);
-			igSliderFloat3("Direction", light->direction, -1.f, 1.f, "%.2f", 0);
+			light->dirty |= igInputFloat3("Position", light->position, "%.3f", 0);
+			light->dirty |= igSliderFloat3("Direction", light->direction, -1.f, 1.f, "%.2f", 0);
 
-			igSliderFloat("Cut Off Inner", &light->cutOffInner, 0.f, 180.f, "%.2f", 0);
-			igSliderFloat("Cut Off Outer", &light->cutOffOuter, 0.f, 180.f, "%.2f", 0);
+			light->dirty |= igSliderFloat("Cut Off Inner", &light->cutOffInner, 0.f, 180.f, "%.2f", 0);
+			light->dirty |= igSliderFloat("Cut Off Outer", &light->cutOffOuter, 0.f, 180.f, "%.2f", 0);
 
 			igSeparator();
-			igColorEdit3("Ambient", light->ambient, 0);
-			igColorEdit3("Diffuse", light->diffuse, 0);
-			igColorEdit3("Specular", light->specular, 0);
+			light->dirty |= igColorEdit3("Ambient", light->ambient, 0);
+			light->dirty |= igColorEdit3("Diffuse", light->diffuse, 0);
+			light->dirty |= igColorEdit3("Specular", light->specular, 0);
 
 			igSeparator();
-			igInputFloat("Range", &light->range, 10.f, 100.f, "%.2f", 0);
+			light->dirty |= igInputFloat("Range", &light->range, 10.f, 100.f, "%.2f", 0);
 		}
 	}
 }
@@ -981,9 +1179,52 @@ void guiUpdate()
 		igDragFloatRange2("Near/Far", &camera->near, &camera->far, 1.f, .1f, 1000.f, "%.1f", "%.1f", 0);
 	}
 
+	if (igCollapsingHeader_BoolPtr("Culling", NULL, 0))
+	{
+		igCheckbox("Frustum Culling", &frustumCulling);
+		igText("Instances: %zu / %zu visible", instancesVisible, instancesTotal);
+		igText("Cull time: %.3f ms (%s)", instanceCullMs, cullPathName(cullGetPath()));
+	}
+
+	if (igCollapsingHeader_BoolPtr("Level Of Detail", NULL, 0))
+	{
+		igDragFloat("Pixel Error", &lodPixelError, .05f, 0.f, 32.f, "%.2f", 0);
+		for (int i = 0; i < MESH_MAX_LODS; i++)
+			igText("Lod %d: %d instances", i, lodInstanceCounts[i]);
+		igText("Instance triangles: %zu / %zu", instanceTriangles, instanceTrianglesFull);
+
+		igSeparator();
+		igCheckbox("Meshlet Culling", &meshletCulling);
+		igText("Spiky monkey: %u / %u triangles in %d draws", meshletTriangles, meshletTrianglesTotal, meshletDraws);
+	}
+
+	if (igCollapsingHeader_BoolPtr("Geometry", NULL, 0))
+	{
+		igText("Compiling: %u shaders, %.3f ms checking this frame", shadersCompiling, shaderCheckMs);
+		igText("Lighting variants: %u built, %u compiling, %u evicted, %.1f ms compiling in total", lightingVariantsBuilt,
+			   lightingVariantsPending, lightingVariantsEvicted, lightingVariantsMs);
+		igText("Loading: %u meshes, %.3f ms uploading this frame (%.1f ms budget)", meshesLoading, meshLoadMs,
+			   MESH_LOADER_BUDGET_MS);
+		igText("Transforms: %u / %u updated this frame", transformsUpdated, transformsTotal);
+		igText("GL state: %u calls issued, %u redundant ones skipped last frame", glCallsIssued, glCallsElided);
+		for (uint32_t i = 0; i < geometryNumArenas(); i++)
+		{
+			const geometryArena_t* arena = geometryGetArena(i);
+			const gpuAllocatorStats_t vertices = gpuAllocatorGetStats(&arena->vertices);
+			const gpuAllocatorStats_t indices = gpuAllocatorGetStats(&arena->indices);
+			igText("Arena %u (stride %u): %u meshes, grown %u times", i, arena->stride, vertices.numAllocations, arena->numGrows);
+			igText("  Vertices: %u / %u, %.1f%% used, %.1f%% fragmented (%u free blocks)", vertices.used, vertices.capacity,
+				   vertices.occupancy * 100.f, vertices.fragmentation * 100.f, vertices.numFreeBlocks);
+			igText("  Indices: %u / %u bytes, %.1f%% used, %.1f%% fragmented (%u free blocks)", indices.used, indices.capacity,
+				   indices.occupancy * 100.f, indices.fragmentation * 100.f, indices.numFreeBlocks);
+		}
+	}
+
 	if (igCollapsingHeader_BoolPtr("Lights", NULL, 0))
 	{
 		igText("Settings for lights in scene");
+		igText("%u enabled, %u copied into the light buffer this frame", lightsPacked, lightsWritten);
+		igCheckbox("Blinn-Phong", &blinn);
 		igSeparator();
 		// guiLightSettings("Sun", &lightSun);
 		for (int i = 0; i < MAX_LIGHTS; i++)
@@ -991,9 +1232,7 @@ void guiUpdate()
 			// if (!lights[i].enable)
 			// 	continue;
 			igPushID_Int(i);
-			char label[7];
-			sprintf(label, "Light%d", i);
-			guiLightSettings(label, &lights[i]);
+			guiLightSettings(arenaPrintf(&frameArena, "Light%d", i), &lights[i]);
 			igPopID();
 		}
 	}
@@ -1008,4 +1247,74 @@ void guiUpdate()
 	// igBulletText("Position (%f, %f, %f)", camera->position[0], camera->position[1], camera->position[2]);
 
 	igEnd();
+}
+
+void setModelUniforms(const GLuint* shader, const transforms_t* transforms, const uint32_t transform)
+{
+	setUniformLocationMatrix4fv(shader, shaderGetLocation(*shader, uniforms.model),
+								(GLfloat*) transforms->worlds[transform]);
+	setUniformLocationMatrix3fv(shader, shaderGetLocation(*shader, uniforms.normalMatrix),
+								(GLfloat*) transforms->normals[transform]);
+}
+
+void uniformsInit()
+{
+	uniforms.model = uniformName("u_model");
+	uniforms.normalMatrix = uniformName("u_normalMatrix");
+	uniforms.color = uniformName("u_color");
+	uniforms.materialDiffuseColor = uniformName("u_material.diffuseColor");
+	uniforms.materialSpecularColor = uniformName("u_material.specularColor");
+	uniforms.materialShininess = uniformName("u_material.shininess");
+	uniforms.materialDiffuseTex = uniformName("u_material.diffuseTex");
+	uniforms.materialSpecularTex = uniformName("u_material.specularTex");
+	uniforms.materialNormalTex = uniformName("u_material.normalTex");
+	uniforms.skybox = uniformName("u_skybox");
+	uniforms.texture = uniformName("u_texture");
+}
+
+void lightingDefines(const uint64_t key, char* defines, const size_t size)
+{
+	snprintf(defines, size, "%s%s%s%s#define NUM_DIRECT %u\n#define NUM_POINT %u\n#define NUM_SPOT %u\n",
+			 key & LIGHTING_INSTANCED ? "#define INSTANCED\n" : "", key & LIGHTING_BLINN ? "#define BLINN\n" : "",
+			 key & LIGHTING_GLTF_VERTICES ? "#define GLTF_VERTICES\n" : "",
+			 key & LIGHTING_HAS_NORMAL_MAP ? "#define HAS_NORMAL_MAP\n" : "",
+			 (uint32_t) (key >> LIGHTING_DIRECT_SHIFT) & 0xff, (uint32_t) (key >> LIGHTING_POINT_SHIFT) & 0xff,
+			 (uint32_t) (key >> LIGHTING_SPOT_SHIFT) & 0xff);
+}
+
+// 0 stays 0 so unused modes drop out, anything else rounds up to a power of two & the shader stops at the real count.
+// Keeps toggling lights from building a variant per combination
+uint64_t lightingBucket(const uint32_t count)
+{
+	uint64_t bucket = 1;
+	while (bucket < count)
+		bucket <<= 1;
+	return count ? bucket : 0;
+}
+
+uint64_t lightingKey(const lightBuffer_t* buffer, const uint64_t features)
+{
+	return features | (blinn ? LIGHTING_BLINN : 0) | lightingBucket(buffer->numDirect) << LIGHTING_DIRECT_SHIFT |
+		   lightingBucket(buffer->numPoint) << LIGHTING_POINT_SHIFT | lightingBucket(buffer->numSpot) << LIGHTING_SPOT_SHIFT;
+}
+
+void shaderDefaults(const GLuint program, void* user)
+{
+	(void) user;
+	// Samplers & material defaults, programs without one of these just ignore it
+	glStateUseProgram(program);
+	setUniformLocation1i(&program, shaderGetLocation(program, uniforms.materialDiffuseTex), MATERIAL_UNIT_DIFFUSE);
+	setUniformLocation1i(&program, shaderGetLocation(program, uniforms.materialSpecularTex), MATERIAL_UNIT_SPECULAR);
+	setUniformLocation1i(&program, shaderGetLocation(program, uniforms.materialNormalTex), MATERIAL_UNIT_NORMAL);
+	setUniformLocation1f(&program, shaderGetLocation(program, uniforms.materialShininess), 32.f);
+	setUniformLocation3fv(&program, shaderGetLocation(program, uniforms.materialDiffuseColor), (vec3){1.f, 1.f, 1.f});
+	setUniformLocation3fv(&program, shaderGetLocation(program, uniforms.materialSpecularColor), (vec3){1.f, 1.f, 1.f});
+	setUniformLocation1i(&program, shaderGetLocation(program, uniforms.skybox), 2);
+	setUniformLocation1i(&program, shaderGetLocation(program, uniforms.texture), 0);
+}
+
+void shaderReady(const GLuint program, void* user)
+{
+	resourcesSetShaderProgram(*(const shaderHandle_t*) user, program);
+	shaderDefaults(program, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,278 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "material.h"
+#include "glstate.h"
+#include "shader.h"
+#include "util.h"
+
+static GLuint whiteTexture = 0;
+
+static const char* skipBlank(const char* p)
+{
+	while (*p == ' ' || *p == '\t')
+		p++;
+	return p;
+}
+
+static void trimEnd(char* line)
+{
+	size_t length = strlen(line);
+	while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r' || line[length - 1] == ' ' || line[length - 1] == '\t'))
+		line[--length] = '\0';
+}
+
+// The file name is the last token, anything before it is options like '-bm 1.0'
+static void parseMap(const char* p, const char* directory, char* path)
+{
+	const char* name = strrchr(p, ' ');
+	const char* tab = strrchr(p, '\t');
+	if (tab > name)
+		name = tab;
+	name = name ? name + 1 : p;
+	snprintf(path, MATERIAL_PATH_LENGTH, "%s%s", directory, name);
+}
+
+static void parseColor(const char* p, vec3 color)
+{
+	if (sscanf(p, "%f %f %f", &color[0], &color[1], &color[2]) == 1)
+		color[1] = color[2] = color[0];
+}
+
+materialLibrary_t* materialLibraryLoad(const char* filename)
+{
+	FILE* file = fopen(filename, "r");
+	if (file == NULL)
+		return NULL;
+
+	// Maps are relative to the mtl
+	char directory[MATERIAL_PATH_LENGTH] = "";
+	const char* slash = strrchr(filename, '/');
+	const char* backslash = strrchr(filename, '\\');
+	if (backslash > slash)
+		slash = backslash;
+	if (slash && (size_t) (slash - filename + 1) < sizeof(directory))
+	{
+		memcpy(directory, filename, slash - filename + 1);
+		directory[slash - filename + 1] = '\0';
+	}
+
+	materialLibrary_t* library = calloc(1, sizeof(materialLibrary_t));
+	if (library == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate material library!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	material_t* material = NULL;
+	char line[512];
+	while (fgets(line, sizeof(line), file))
+	{
+		trimEnd(line);
+		const char* p = skipBlank(line);
+
+		if (strncmp(p, "newmtl ", 7) == 0)
+		{
+			material_t* materials = realloc(library->materials, (library->numMaterials + 1) * sizeof(material_t));
+			if (materials == NULL)
+			{
+				fprintf(stderr, "Out of memory! Failed to allocate materials!\n");
+				exit(EXIT_FAILURE);
+			}
+			library->materials = materials;
+			material = &library->materials[library->numMaterials++];
+			memset(material, 0, sizeof(material_t));
+			snprintf(material->name, sizeof(material->name), "%s", skipBlank(p + 7));
+			glm_vec3_copy((vec3){1.f, 1.f, 1.f}, material->diffuse);
+			glm_vec3_copy((vec3){1.f, 1.f, 1.f}, material->specular);
+			material->shininess = 32.f;
+			continue;
+		}
+		if (material == NULL)
+			continue;
+
+		if (strncmp(p, "Kd ", 3) == 0)
+			parseColor(p + 3, material->diffuse);
+		else if (strncmp(p, "Ks ", 3) == 0)
+			parseColor(p + 3, material->specular);
+		else if (strncmp(p, "Ns ", 3) == 0)
+			material->shininess = strtof(p + 3, NULL);
+		else if (strncmp(p, "map_Kd ", 7) == 0)
+		{
+			parseMap(p + 7, directory, material->diffuseMap);
+			material->flags |= F_MAT_DIFFUSE;
+		} else if (strncmp(p, "map_Ks ", 7) == 0)
+		{
+			parseMap(p + 7, directory, material->specularMap);
+			material->flags |= F_MAT_SPECULAR;
+		} else if (strncmp(p, "map_Bump ", 9) == 0 || strncmp(p, "map_bump ", 9) == 0 || strncmp(p, "bump ", 5) == 0 ||
+				   strncmp(p, "norm ", 5) == 0)
+		{
+			parseMap(strchr(p, ' ') + 1, directory, material->normalMap);
+			material->flags |= F_MAT_NORMAL;
+		}
+		// Everything else (Ka, Ke, Ni, d, illum...) isn't used by the shaders
+	}
+	fclose(file);
+
+	// Ns is [0, 1000], an exponent of 0 would light the back of every surface
+	for (uint32_t i = 0; i < library->numMaterials; i++)
+		library->materials[i].shininess = glm_clamp(library->materials[i].shininess, 1.f, 1000.f);
+	printf("Material library %s loaded (%u materials)\n", filename, library->numMaterials);
+	return library;
+}
+
+static GLuint getWhiteTexture()
+{
+	if (whiteTexture == 0)
+	{
+		const unsigned char white[4] = {255, 255, 255, 255};
+		glCreateTextures(GL_TEXTURE_2D, 1, &whiteTexture);
+		glTextureStorage2D(whiteTexture, 1, GL_RGBA8, 1, 1);
+		glTextureSubImage2D(whiteTexture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	}
+	return whiteTexture;
+}
+
+static bool mapExists(const char* path)
+{
+	uint64_t size, mtime;
+	if (fileStat(path, &size, &mtime))
+		return true;
+	fprintf(stderr, "Material map %s is missing, using white\n", path);
+	return false;
+}
+
+// Decoded maps are only uploaded, the rest are read here unless decoding already tried them
+static GLuint loadMap(const materialLibrary_t* library, materialImage_t* image, const char* path, const bool given)
+{
+	if (image->pixels)
+	{
+		const GLuint texture = loadTextureFromImageData(image->pixels, image->width, image->height, image->format,
+														GL_REPEAT, GL_REPEAT);
+		printf("Texture '%s' loaded\n", path);
+		freeImageData(image->pixels);
+		image->pixels = NULL;
+		return texture;
+	}
+	if (given && !library->decoded && mapExists(path))
+		return loadTextureFromFile(path, GL_REPEAT, GL_REPEAT);
+	return getWhiteTexture();
+}
+
+void materialLibraryDecodeTextures(materialLibrary_t* library)
+{
+	const unsigned int flags[MATERIAL_MAPS] = {F_MAT_DIFFUSE, F_MAT_SPECULAR, F_MAT_NORMAL};
+	for (uint32_t i = 0; i < library->numMaterials; i++)
+	{
+		material_t* material = &library->materials[i];
+		const char* paths[MATERIAL_MAPS] = {material->diffuseMap, material->specularMap, material->normalMap};
+		for (int map = 0; map < MATERIAL_MAPS; map++)
+		{
+			materialImage_t* image = &material->images[map];
+			if ((material->flags & flags[map]) && image->pixels == NULL && mapExists(paths[map]))
+				image->pixels = loadImageDataFromFile(paths[map], &image->width, &image->height, &image->format);
+		}
+	}
+	library->decoded = true;
+}
+
+void materialLibraryLoadTextures(materialLibrary_t* library)
+{
+	for (uint32_t i = 0; i < library->numMaterials; i++)
+	{
+		material_t* material = &library->materials[i];
+		// Maps that already have a texture (embedded in a glb) are kept
+		if (material->diffuseTex == 0)
+			material->diffuseTex = loadMap(library, &material->images[0], material->diffuseMap,
+										   material->flags & F_MAT_DIFFUSE);
+		if (material->specularTex == 0)
+			material->specularTex = loadMap(library, &material->images[1], material->specularMap,
+											material->flags & F_MAT_SPECULAR);
+		if (material->normalTex == 0)
+			material->normalTex = loadMap(library, &material->images[2], material->normalMap,
+										  material->flags & F_MAT_NORMAL);
+		// White isn't a valid normal map, these draw with the vertex normal instead (see meshDrawMaterials)
+		if (material->normalTex == whiteTexture)
+			material->flags &= ~F_MAT_NORMAL;
+	}
+}
+
+// Whether an earlier map (in material order) already holds 'texture', so it's only deleted once
+static bool textureUsedBefore(const materialLibrary_t* library, const uint32_t material, const int map, const GLuint texture)
+{
+	for (uint32_t i = 0; i <= material; i++)
+	{
+		const material_t* other = &library->materials[i];
+		const GLuint textures[3] = {other->diffuseTex, other->specularTex, other->normalTex};
+		for (int t = 0; t < (i == material ? map : 3); t++)
+		{
+			if (textures[t] == texture)
+				return true;
+		}
+	}
+	return false;
+}
+
+void materialLibraryDestroy(materialLibrary_t* library)
+{
+	for (uint32_t i = 0; i < library->numMaterials; i++)
+	{
+		const material_t* material = &library->materials[i];
+		const GLuint textures[3] = {material->diffuseTex, material->specularTex, material->normalTex};
+		for (int t = 0; t < 3; t++)
+		{
+			// The white fallback is shared, so are glb images used by several materials
+			if (textures[t] && textures[t] != whiteTexture && !textureUsedBefore(library, i, t, textures[t]))
+				glDeleteTextures(1, &textures[t]);
+			// Decoded but never uploaded
+			freeImageData(material->images[t].pixels);
+		}
+	}
+	glStateReset();
+	free(library->materials);
+	free(library);
+}
+
+void materialShutdown()
+{
+	if (whiteTexture == 0)
+		return;
+	glDeleteTextures(1, &whiteTexture);
+	whiteTexture = 0;
+	glStateReset();
+}
+
+int32_t materialLibraryFind(const materialLibrary_t* library, const char* name)
+{
+	for (uint32_t i = 0; i < library->numMaterials; i++)
+	{
+		if (strcmp(library->materials[i].name, name) == 0)
+			return (int32_t) i;
+	}
+	return -1;
+}
+
+void materialBind(const material_t* material, const GLuint shader)
+{
+	// Hashed on the first bind, every bind after only looks the locations up
+	static uniform_t diffuseColor, specularColor, shininess;
+	if (diffuseColor.hash == 0)
+	{
+		diffuseColor = uniformName("u_material.diffuseColor");
+		specularColor = uniformName("u_material.specularColor");
+		shininess = uniformName("u_material.shininess");
+	}
+
+	glStateBindTextureUnit(MATERIAL_UNIT_DIFFUSE, material->diffuseTex);
+	glStateBindTextureUnit(MATERIAL_UNIT_SPECULAR, material->specularTex);
+	glStateBindTextureUnit(MATERIAL_UNIT_NORMAL, material->normalTex);
+	setUniformLocation3fv(&shader, shaderGetLocation(shader, diffuseColor), (float*) material->diffuse);
+	setUniformLocation3fv(&shader, shaderGetLocation(shader, specularColor), (float*) material->specular);
+	setUniformLocation1f(&shader, shaderGetLocation(shader, shininess), material->shininess);
+}
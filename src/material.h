@@ -0,0 +1,84 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Wavefront mtl materials, parsing needs no GL context so the baker can use it too
+ */
+
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glad/glad.h>
+
+#include <cglm/cglm.h>
+
+#define MATERIAL_NAME_LENGTH 64
+#define MATERIAL_PATH_LENGTH 256
+
+#define F_MAT_DIFFUSE 0x001
+#define F_MAT_SPECULAR 0x010
+#define F_MAT_EMISSION 0x100
+#define F_MAT_NORMAL 0x1000
+
+// Texture units materialBind uses, unit 2 stays free for the skybox
+#define MATERIAL_UNIT_DIFFUSE 0
+#define MATERIAL_UNIT_SPECULAR 1
+#define MATERIAL_UNIT_NORMAL 3
+
+#define MATERIAL_MAPS 3 // Diffuse, specular & normal, in that order
+
+// A map decoded off the GL thread, waiting to be uploaded
+typedef struct materialImage_t
+{
+	unsigned char* pixels; // NULL if the map wasn't given or failed to decode
+	int width;
+	int height;
+	GLenum format;
+} materialImage_t;
+
+typedef struct material_t
+{
+	char name[MATERIAL_NAME_LENGTH];
+	vec3 diffuse; // Kd
+	vec3 specular; // Ks
+	float shininess; // Ns
+	unsigned int flags; // F_MAT_* for every map that was given
+
+	// Resolved relative to the mtl file
+	char diffuseMap[MATERIAL_PATH_LENGTH]; // map_Kd
+	char specularMap[MATERIAL_PATH_LENGTH]; // map_Ks
+	char normalMap[MATERIAL_PATH_LENGTH]; // map_Bump/bump/norm
+
+	// Set by materialLibraryLoadTextures unless already set, missing maps get a 1x1 white texture
+	GLuint diffuseTex;
+	GLuint specularTex;
+	GLuint normalTex;
+
+	materialImage_t images[MATERIAL_MAPS]; // From materialLibraryDecodeTextures, freed once they're uploaded
+} material_t;
+
+typedef struct materialLibrary_t
+{
+	uint32_t numMaterials;
+	material_t* materials;
+	bool decoded; // Every map that could be was decoded, the rest are white without trying the file again
+} materialLibrary_t;
+
+// Returns NULL if the file can't be opened
+materialLibrary_t* materialLibraryLoad(const char* filename);
+// Decodes every map into the materials' images, no GL context needed so the loader's workers run it
+void materialLibraryDecodeTextures(materialLibrary_t* library);
+// Uploads the decoded images, maps that weren't decoded are loaded from their files here
+void materialLibraryLoadTextures(materialLibrary_t* library);
+void materialLibraryDestroy(materialLibrary_t* library);
+// -1 if there's no material called 'name'
+int32_t materialLibraryFind(const materialLibrary_t* library, const char* name);
+// Deletes the white texture missing maps share, only once every library using it has been destroyed
+void materialShutdown();
+
+// Binds the maps & sets 'u_material', the sampler uniforms are expected to already point at the MATERIAL_UNIT_* units.
+// Whether the normal map is read is up to the program (see meshDrawMaterials)
+void materialBind(const material_t* material, GLuint shader);
+
+#endif //MATERIAL_H
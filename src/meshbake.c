@@ -0,0 +1,720 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Offline obj -> .mesh converter so deployments only need to ship baked meshes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "cull.h"
+#include "meshcache.h"
+#include "meshcodec.h"
+#include "meshloader.h"
+#include "objloader.h"
+#include "uniformtable.h"
+#include "util.h"
+
+void printUsage()
+{
+	printf("Usage: meshbake [-f] [-a] [-b iterations] [-c instances] [-g floats] [-u frames] [-s triangles] [-t] <file.obj>...\n");
+	printf("  Writes <file.obj>%s (the packed vertex layout the app loads) next to every input\n", MESH_CACHE_PACKED_EXTENSION);
+	printf("  -f  Bake the float vertex layout instead (<file.obj>%s)\n", MESH_CACHE_EXTENSION);
+	printf("  -b  Only benchmark obj parse, meshlet culling & codec decode throughput (checking it round trips), nothing is written\n");
+	printf("  -c  Benchmark frustum culling of that many random instance spheres with every simd path\n");
+	printf("  -g  Benchmark filling an array.h array with that many floats, per element pushes against bulk appends\n");
+	printf("  -u  Benchmark resolving a frame's worth of lit shader uniforms by formatted name against pre-hashed handles\n");
+	printf("  -s  Benchmark parsing a synthetic obj of about that many triangles, written to the temp directory & removed after\n");
+	printf("  -t  Round trip the codec's edge cases, empty & partial blocks, 16 bit limits, truncated & corrupt streams\n");
+	printf("  -a  Load the inputs through the async mesh loader without a GL context, using (& refreshing) their caches\n");
+}
+
+// Stands in for the GL upload so the loader's queue & budget can be checked headless
+static bool countUpload(meshLoadHandle_t* handle, void* user)
+{
+	uint64_t* triangles = user;
+	*triangles += handle->data->lods[0].numIndices / 3;
+	return true;
+}
+
+int loadAsync(char* filenames[], const int count, const unsigned int flags)
+{
+	uint64_t triangles = 0;
+	const double startTime = timeGetSeconds();
+	meshLoader_t* loader = meshLoaderCreate(countUpload, &triangles);
+	for (int i = 0; i < count; i++)
+		meshLoadAsync(loader, filenames[i], flags);
+
+	// Poll like a frame loop would, a real frame also renders between updates
+	uint32_t frames = 0;
+	double maxUpdateMs = 0.;
+	while (meshLoaderInFlight(loader) > 0)
+	{
+		meshLoaderUpdate(loader, MESH_LOADER_BUDGET_MS);
+		maxUpdateMs = loader->lastUpdateMs > maxUpdateMs ? loader->lastUpdateMs : maxUpdateMs;
+		frames++;
+	}
+	const uint32_t failed = loader->numFailed;
+	printf("Async loaded %u / %d meshes (%llu triangles) in %.2f ms over %u updates, slowest update %.3f ms\n",
+		   loader->numReady, count, (unsigned long long) triangles, (timeGetSeconds() - startTime) * 1000., frames,
+		   maxUpdateMs);
+	meshLoaderDestroy(loader);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Fills a float array the ways mesh ingest can, 'fixed' is the old +3 growth that loadOBJ used to rely on
+void benchmarkArray(const size_t count, const int iterations)
+{
+	float* source = malloc((count ? count : 1) * sizeof(float));
+	if (source == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate array source!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (size_t i = 0; i < count; i++)
+		source[i] = (float) i;
+
+	const char* names[] = {"fixed", "push", "push8", "append"};
+	for (int mode = 0; mode < 4; mode++)
+	{
+		bool ok = true;
+		double bestSeconds = 0.;
+		for (int i = 0; i < iterations; i++)
+		{
+			const double startTime = timeGetSeconds();
+			array_float_t* array = array_float_create(0);
+			switch (mode)
+			{
+				case 0:
+					for (size_t j = 0; j < count; j++)
+					{
+						if (array->size == array->capacity)
+							array_float_reserve(&array, array->capacity + 3);
+						array_float_push(&array, source[j]);
+					}
+					break;
+				case 1:
+					for (size_t j = 0; j < count; j++)
+						array_float_push(&array, source[j]);
+					break;
+				case 2:
+					// A vertex at a time, like the obj loader's 8 floats per vertex
+					for (size_t j = 0; j < count; j += VERTEX_STRIDE)
+						array_float_push_n(&array, &source[j], count - j < VERTEX_STRIDE ? count - j : VERTEX_STRIDE);
+					break;
+				default:
+					array_float_reserve(&array, count);
+					array_float_push_n(&array, source, count);
+					break;
+			}
+			const double seconds = timeGetSeconds() - startTime;
+			if (i == 0 || seconds < bestSeconds)
+				bestSeconds = seconds;
+			ok = ok && array->size == count && memcmp(array->array, source, count * sizeof(float)) == 0 &&
+				((uintptr_t) array->array & (ARRAY_H_ALIGNMENT - 1)) == 0;
+			array_float_delete(array);
+		}
+		const double megabytes = (double) (count * sizeof(float)) / (1024. * 1024.);
+		printf("%-6s: %zu floats, best of %d: %.2f ms, %.0f MB/s%s\n", names[mode], count, iterations, bestSeconds * 1000.,
+			   megabytes / bestSeconds, ok ? "" : " (MISMATCH)");
+	}
+	free(source);
+}
+
+// Orbits a camera around the mesh & culls its meshlets from every angle
+void benchmarkCulling(const char* filename, const int iterations)
+{
+	meshData_t* data = meshDataLoadOBJ(filename);
+	if (data == NULL || data->numMeshlets == 0)
+	{
+		if (data)
+			meshDataDestroy(data);
+		return;
+	}
+
+	GLsizei* counts = malloc(data->numMeshlets * sizeof(GLsizei));
+	const void** offsets = malloc(data->numMeshlets * sizeof(void*));
+	if (counts == NULL || offsets == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate draw ranges!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	vec3 center, extent;
+	glm_vec3_center(data->boundsMin, data->boundsMax, center);
+	glm_vec3_sub(data->boundsMax, data->boundsMin, extent);
+	const float distance = glm_vec3_norm(extent) * 1.5f;
+
+	camera_t camera;
+	memset(&camera, 0, sizeof(camera));
+	camera.fov = 45.f;
+	camera.near = .1f;
+	camera.far = distance * 4.f;
+	mat4 model, projection;
+	glm_mat4_identity(model);
+	glm_perspective(glm_rad(camera.fov), 16.f / 9.f, camera.near, camera.far, projection);
+
+	const int angles = 64;
+	uint64_t tested = 0, visible = 0, draws = 0;
+	double bestSeconds = 0.;
+	for (int i = 0; i < iterations; i++)
+	{
+		tested = visible = draws = 0;
+		const double startTime = timeGetSeconds();
+		for (int a = 0; a < angles; a++)
+		{
+			const float angle = (float) a / (float) angles * 2.f * GLM_PI;
+			camera.position[0] = center[0] + sinf(angle) * distance;
+			camera.position[1] = center[1] + distance * .25f;
+			camera.position[2] = center[2] + cosf(angle) * distance;
+
+			mat4 view, viewProjection;
+			glm_lookat(camera.position, center, GLOBAL_UP, view);
+			glm_mat4_mul(projection, view, viewProjection);
+			cameraUpdateFrustum(&camera, viewProjection);
+			const GLsizei drawCount = meshCullMeshlets(data->meshlets, data->numMeshlets, meshDataIndexType(data), model,
+													   &camera, counts, offsets);
+			tested += data->numMeshlets;
+			draws += (uint64_t) drawCount;
+			for (GLsizei d = 0; d < drawCount; d++)
+				visible += (uint64_t) counts[d] / 3;
+		}
+		const double seconds = timeGetSeconds() - startTime;
+		if (i == 0 || seconds < bestSeconds)
+			bestSeconds = seconds;
+	}
+
+	const uint64_t totalTriangles = (uint64_t) data->lods[0].numIndices / 3 * angles;
+	printf("%s: %u meshlets, best of %d: %.0f meshlets/ms, %.1f%% of triangles & %.1f draws kept per view\n", filename,
+		   data->numMeshlets, iterations, (double) tested / (bestSeconds * 1000.),
+		   100. * (double) visible / (double) totalTriangles, (double) draws / angles);
+
+	free(counts);
+	free(offsets);
+	meshDataDestroy(data);
+}
+
+// Random spheres around a camera looking down -z, like main's instances but denser
+void benchmarkInstanceCulling(const int instances, const int iterations)
+{
+	cullSpheres_t* spheres = cullSpheresCreate((size_t) instances);
+	uint32_t* visible = malloc((size_t) instances * sizeof(uint32_t));
+	if (visible == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate visible instances!\n");
+		exit(EXIT_FAILURE);
+	}
+	srand(1);
+	for (int i = 0; i < instances; i++)
+	{
+		const vec3 center = {
+			(float) rand() / (float) RAND_MAX * 200.f - 100.f,
+			(float) rand() / (float) RAND_MAX * 200.f - 100.f,
+			(float) rand() / (float) RAND_MAX * 200.f - 100.f
+		};
+		cullSpheresSet(spheres, (size_t) i, center, (float) rand() / (float) RAND_MAX * .75f + .25f);
+	}
+
+	camera_t camera;
+	memset(&camera, 0, sizeof(camera));
+	mat4 view, projection, viewProjection;
+	glm_lookat(camera.position, (vec3){0.f, 0.f, -1.f}, GLOBAL_UP, view);
+	glm_perspective(glm_rad(45.f), 16.f / 9.f, .1f, 100.f, projection);
+	glm_mat4_mul(projection, view, viewProjection);
+	cameraUpdateFrustum(&camera, viewProjection);
+
+	size_t expected = 0;
+	for (int path = 0; path < CULL_PATH_COUNT; path++)
+	{
+		if (!cullPathSupported((cullPath_t) path))
+		{
+			printf("%-6s: not supported\n", cullPathName((cullPath_t) path));
+			continue;
+		}
+
+		size_t numVisible = 0;
+		double bestSeconds = 0.;
+		for (int i = 0; i < iterations; i++)
+		{
+			const double startTime = timeGetSeconds();
+			numVisible = cullFrustumSpheresPath((cullPath_t) path, &camera.frustum, spheres, visible);
+			const double seconds = timeGetSeconds() - startTime;
+			if (i == 0 || seconds < bestSeconds)
+				bestSeconds = seconds;
+		}
+		if (path == CULL_PATH_SCALAR)
+			expected = numVisible;
+		printf("%-6s: %d instances, %zu visible, best of %d: %.3f ms, %.0f instances/ms%s\n", cullPathName((cullPath_t) path),
+			   instances, numVisible, iterations, bestSeconds * 1000., (double) instances / (bestSeconds * 1000.),
+			   numVisible == expected ? "" : " (MISMATCH)");
+	}
+
+	free(visible);
+	cullSpheresDestroy(spheres);
+}
+
+// -1 if the program has no table either, the benchmark's always does
+static int32_t tableLocation(const uint32_t program, const uniform_t uniform)
+{
+	int32_t location = -1;
+	uniformTableGet(program, uniform, &location);
+	return location;
+}
+
+// A made up program with main's lit shader uniforms, no GL context so this only times resolving locations
+void benchmarkUniforms(const int frames, const int iterations)
+{
+	const uint32_t program = 1;
+	const char* globals[] = {"u_model", "u_normalMatrix", "u_view", "u_projection", "u_isInstance", "u_viewPos",
+							 "u_material.flags", "u_material.diffuseColor", "u_material.specularColor", "u_material.shininess"};
+	const char* members[] = {"enable", "mode", "position", "direction", "cutOffInner", "cutOffOuter", "ambient", "diffuse",
+							 "specular", "constant", "linear", "quadratic"};
+	const int numGlobals = sizeof(globals) / sizeof(globals[0]);
+	const int numMembers = sizeof(members) / sizeof(members[0]);
+	const int numLights = 8;
+
+	arena_t arena;
+	arenaInit(&arena, "uniform benchmark", 4096);
+	uniform_t* handles = arenaAlloc(&arena, (size_t) (numGlobals + numLights * numMembers) * sizeof(uniform_t));
+	int32_t location = 0;
+	for (int i = 0; i < numGlobals; i++)
+	{
+		uniformTableAdd(program, globals[i], location++);
+		handles[i] = uniformName(globals[i]);
+	}
+	for (int i = 0; i < numLights; i++)
+	{
+		for (int m = 0; m < numMembers; m++)
+		{
+			const char* name = arenaPrintf(&arena, "u_lights[%d].%s", i, members[m]);
+			uniformTableAdd(program, name, location++);
+			handles[numGlobals + i * numMembers + m] = uniformName(name);
+		}
+	}
+	const int perFrame = numGlobals + numLights * numMembers;
+
+	arena_t frameArena;
+	arenaInit(&frameArena, "uniform benchmark frame", 4096);
+	const char* names[] = {"string", "handle"};
+	for (int mode = 0; mode < 2; mode++)
+	{
+		int64_t sum = 0;
+		double bestSeconds = 0.;
+		for (int i = 0; i < iterations; i++)
+		{
+			sum = 0;
+			const double startTime = timeGetSeconds();
+			for (int f = 0; f < frames; f++)
+			{
+				if (mode == 0)
+				{
+					// What the frame used to do, format every light member's name & hash it on every set
+					for (int g = 0; g < numGlobals; g++)
+						sum += tableLocation(program, uniformName(globals[g]));
+					for (int l = 0; l < numLights; l++)
+					{
+						for (int m = 0; m < numMembers; m++)
+							sum += tableLocation(program, uniformName(arenaPrintf(&frameArena, "u_lights[%d].%s", l,
+																			   members[m])));
+					}
+					arenaReset(&frameArena);
+				}
+				else
+				{
+					for (int u = 0; u < perFrame; u++)
+						sum += tableLocation(program, handles[u]);
+				}
+			}
+			const double seconds = timeGetSeconds() - startTime;
+			if (i == 0 || seconds < bestSeconds)
+				bestSeconds = seconds;
+		}
+		const int64_t expected = (int64_t) frames * perFrame * (perFrame - 1) / 2;
+		printf("%-6s: %d frames of %d uniforms, best of %d: %.3f ms, %.0f lookups/ms%s\n", names[mode], frames, perFrame,
+			   iterations, bestSeconds * 1000., (double) frames * perFrame / (bestSeconds * 1000.),
+			   sum == expected ? "" : " (MISMATCH)");
+	}
+
+	uniformTableForget(program);
+	arenaDestroy(&frameArena);
+	arenaDestroy(&arena);
+}
+
+#define CODEC_BENCHMARK_BYTES (16u << 20) // Decoded per timed run
+
+// Round trips the mesh's current vertices & indices through the codec, false if anything came back different
+bool benchmarkCodecLayout(const meshData_t* data, const char* layoutName, const int iterations)
+{
+	const size_t indexSize = meshDataIndexType(data) == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t vertexBytes = (size_t) data->numVertices * data->layout.stride;
+	const size_t indexBytes = (size_t) data->numIndices * indexSize;
+	const size_t vertexBound = meshEncodeVertexBound(data->numVertices, data->layout.stride);
+	const size_t indexBound = meshEncodeIndexBound(data->numIndices);
+	unsigned char* encodedVertices = malloc(vertexBound);
+	unsigned char* encodedIndices = malloc(indexBound);
+	unsigned char* vertices = malloc(vertexBytes ? vertexBytes : 1);
+	unsigned char* indices = malloc(indexBytes ? indexBytes : 1);
+	unsigned char* expectedIndices = malloc(indexBytes ? indexBytes : 1);
+	if (encodedVertices == NULL || encodedIndices == NULL || vertices == NULL || indices == NULL || expectedIndices == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate codec buffers!\n");
+		exit(EXIT_FAILURE);
+	}
+	for (uint32_t i = 0; i < data->numIndices; i++)
+	{
+		if (indexSize == sizeof(uint16_t))
+			((uint16_t*) expectedIndices)[i] = (uint16_t) data->indices[i];
+		else
+			((uint32_t*) expectedIndices)[i] = data->indices[i];
+	}
+
+	const size_t encodedVertexSize = meshEncodeVertices(encodedVertices, vertexBound, meshDataVertices(data), data->numVertices,
+												 data->layout.stride);
+	const size_t encodedIndexSize = meshEncodeIndices(encodedIndices, indexBound, data->indices, data->numIndices);
+	bool ok = encodedVertexSize > 0 && encodedIndexSize > 0;
+
+	// The bundled meshes decode in microseconds, so every timed run repeats the decode to get past the timer's resolution
+	const size_t vertexRepeats = CODEC_BENCHMARK_BYTES / (vertexBytes ? vertexBytes : 1) + 1;
+	const size_t indexRepeats = CODEC_BENCHMARK_BYTES / (indexBytes ? indexBytes : 1) + 1;
+	double bestVertexSeconds = 0., bestIndexSeconds = 0.;
+	for (int i = 0; ok && i < iterations; i++)
+	{
+		double startTime = timeGetSeconds();
+		for (size_t r = 0; ok && r < vertexRepeats; r++)
+			ok = meshDecodeVertices(vertices, data->numVertices, data->layout.stride, encodedVertices, encodedVertexSize);
+		const double vertexSeconds = (timeGetSeconds() - startTime) / (double) vertexRepeats;
+		startTime = timeGetSeconds();
+		for (size_t r = 0; ok && r < indexRepeats; r++)
+			ok = meshDecodeIndices(indices, data->numIndices, indexSize, encodedIndices, encodedIndexSize);
+		const double indexSeconds = (timeGetSeconds() - startTime) / (double) indexRepeats;
+		if (i == 0 || vertexSeconds < bestVertexSeconds)
+			bestVertexSeconds = vertexSeconds;
+		if (i == 0 || indexSeconds < bestIndexSeconds)
+			bestIndexSeconds = indexSeconds;
+	}
+	ok = ok && memcmp(vertices, meshDataVertices(data), vertexBytes) == 0 && memcmp(indices, expectedIndices, indexBytes) == 0;
+
+	const double megabyte = 1024. * 1024.;
+	printf("  %-6s: vertices %zu -> %zu bytes (%.1f%%) %.0f MB/s, indices %zu -> %zu bytes (%.1f%%) %.0f MB/s, best of %d%s\n",
+		   layoutName, vertexBytes, encodedVertexSize, 100. * (double) encodedVertexSize / (double) (vertexBytes ? vertexBytes : 1),
+		   (double) vertexBytes / megabyte / bestVertexSeconds, indexBytes, encodedIndexSize,
+		   100. * (double) encodedIndexSize / (double) (indexBytes ? indexBytes : 1),
+		   (double) indexBytes / megabyte / bestIndexSeconds, iterations, ok ? "" : " (MISMATCH)");
+
+	free(encodedVertices);
+	free(encodedIndices);
+	free(vertices);
+	free(indices);
+	free(expectedIndices);
+	return ok;
+}
+
+// Encodes & decodes 'numVertices' made up vertices, then checks every truncation of the stream & a trailing byte are
+// refused. Each decode gets an exact size copy so reading past the stream shows up under a sanitizer
+static bool checkCodecVertices(const size_t numVertices, const size_t stride)
+{
+	const size_t bytes = numVertices * stride;
+	const size_t bound = meshEncodeVertexBound(numVertices, stride);
+	unsigned char* vertices = malloc(bytes ? bytes : 1);
+	unsigned char* decoded = malloc(bytes ? bytes : 1);
+	unsigned char* encoded = malloc(bound + 1);
+	if (vertices == NULL || decoded == NULL || encoded == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate codec buffers!\n");
+		exit(EXIT_FAILURE);
+	}
+	// Slow ramps in the low planes, noise in the rest, so every group width shows up
+	srand(1);
+	for (size_t i = 0; i < bytes; i++)
+		vertices[i] = i % stride < stride / 2 ? (unsigned char) (i / stride / 3 + i % stride) : (unsigned char) rand();
+
+	const size_t size = meshEncodeVertices(encoded, bound, vertices, numVertices, stride);
+	bool ok = size > 0;
+	for (size_t length = 0; ok && length <= size + 1; length++)
+	{
+		unsigned char* copy = malloc(length ? length : 1);
+		if (copy == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate codec buffers!\n");
+			exit(EXIT_FAILURE);
+		}
+		memcpy(copy, encoded, length < size ? length : size);
+		if (length > size)
+			copy[size] = 0;
+		const bool decodes = meshDecodeVertices(decoded, numVertices, stride, copy, length);
+		ok = length == size ? decodes && memcmp(decoded, vertices, bytes) == 0 : !decodes;
+		free(copy);
+	}
+	printf("  %zu vertices of stride %zu: %s\n", numVertices, stride, ok ? "ok" : "FAILED");
+
+	free(vertices);
+	free(decoded);
+	free(encoded);
+	return ok;
+}
+
+// Same for indices, decoded at 'indexSize', 'valid' is whether they should fit it
+static bool checkCodecIndices(const char* name, const uint32_t* indices, const size_t numIndices, const size_t indexSize,
+							  const bool valid)
+{
+	const size_t bound = meshEncodeIndexBound(numIndices);
+	unsigned char* encoded = malloc(bound + 1);
+	uint32_t* decoded = malloc(numIndices ? numIndices * sizeof(uint32_t) : 1);
+	if (encoded == NULL || decoded == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate codec buffers!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	const size_t size = meshEncodeIndices(encoded, bound, indices, numIndices);
+	bool ok = size > 0;
+	for (size_t length = 0; ok && length <= size + 1; length++)
+	{
+		unsigned char* copy = malloc(length ? length : 1);
+		if (copy == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate codec buffers!\n");
+			exit(EXIT_FAILURE);
+		}
+		memcpy(copy, encoded, length < size ? length : size);
+		if (length > size)
+			copy[size] = 0;
+		const bool decodes = meshDecodeIndices(decoded, numIndices, indexSize, copy, length);
+		if (length != size || !valid)
+			ok = !decodes;
+		else
+		{
+			ok = decodes;
+			for (size_t i = 0; ok && i < numIndices; i++)
+				ok = (indexSize == 2 ? ((const uint16_t*) decoded)[i] : decoded[i]) == indices[i];
+		}
+		free(copy);
+	}
+	printf("  %s: %s\n", name, ok ? "ok" : "FAILED");
+
+	free(encoded);
+	free(decoded);
+	return ok;
+}
+
+// Round trips the codec's edge cases, returns false if any of them doesn't behave
+bool checkCodec()
+{
+	printf("Codec checks:\n");
+	bool ok = true;
+	ok = checkCodecVertices(0, 28) && ok;
+	ok = checkCodecVertices(257, 1) && ok;
+	ok = checkCodecVertices(257, 28) && ok;
+	ok = checkCodecVertices(1000, 17) && ok;
+	ok = checkCodecVertices(300, MESH_CODEC_MAX_STRIDE) && ok;
+
+	unsigned char vertex[MESH_CODEC_MAX_STRIDE + 1] = {0};
+	unsigned char buffer[64];
+	const bool badStrides = meshEncodeVertices(buffer, sizeof(buffer), vertex, 1, 0) == 0 &&
+							meshEncodeVertices(buffer, sizeof(buffer), vertex, 1, MESH_CODEC_MAX_STRIDE + 1) == 0 &&
+							!meshDecodeVertices(vertex, 1, 0, buffer, 1) &&
+							!meshDecodeVertices(vertex, 1, MESH_CODEC_MAX_STRIDE + 1, buffer, 1);
+	printf("  strides 0 & %d refused: %s\n", MESH_CODEC_MAX_STRIDE + 1, badStrides ? "ok" : "FAILED");
+	ok = badStrides && ok;
+
+	const uint32_t wide[] = {0, 0xFFFF, 1, 0xFFFF, 0xFFFE, 0, 2, 1, 0, 3, 4, 5, 0xFFFF};
+	const uint32_t tooWide[] = {0, 1, 0x10000};
+	const uint32_t full[] = {0, 0xFFFFFFFFu, 7, 0x80000000u, 0};
+	ok = checkCodecIndices("no indices", NULL, 0, 2, true) && ok;
+	ok = checkCodecIndices("0xFFFF as 16 bit", wide, sizeof(wide) / sizeof(wide[0]), 2, true) && ok;
+	ok = checkCodecIndices("0x10000 as 16 bit refused", tooWide, sizeof(tooWide) / sizeof(tooWide[0]), 2, false) && ok;
+	ok = checkCodecIndices("full 32 bit range", full, sizeof(full) / sizeof(full[0]), 4, true) && ok;
+
+	// Hand made corrupt streams, the wrong version & a varint that never ends
+	const unsigned char badVersion[] = {MESH_CODEC_VERSION + 1, 0};
+	const unsigned char endless[] = {MESH_CODEC_VERSION, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+	uint32_t index;
+	const bool corrupt = !meshDecodeIndices(&index, 1, 4, badVersion, sizeof(badVersion)) &&
+						 !meshDecodeVertices(vertex, 1, 1, badVersion, sizeof(badVersion)) &&
+						 !meshDecodeIndices(&index, 1, 4, endless, sizeof(endless));
+	printf("  corrupt streams refused: %s\n", corrupt ? "ok" : "FAILED");
+	return corrupt && ok;
+}
+
+bool benchmarkCodec(const char* filename, const int iterations)
+{
+	meshData_t* data = meshDataLoadOBJ(filename);
+	if (data == NULL)
+		return false;
+	printf("%s codec:\n", filename);
+	bool ok = benchmarkCodecLayout(data, "float", iterations);
+	meshDataPack(data, filename);
+	ok = benchmarkCodecLayout(data, "packed", iterations) && ok;
+	meshDataDestroy(data);
+	return ok;
+}
+
+// Only the parse, best of 'iterations'
+bool benchmarkParse(const char* filename, const int iterations)
+{
+	double bestSeconds = 0.;
+	size_t fileSize = 0, triangles = 0;
+	for (int i = 0; i < iterations; i++)
+	{
+		objData_t* obj = objLoad(filename);
+		if (obj == NULL)
+			return false;
+		if (i == 0 || obj->parseSeconds < bestSeconds)
+			bestSeconds = obj->parseSeconds;
+		fileSize = obj->fileSize;
+		triangles = obj->numCorners / 3;
+		objDestroy(obj);
+	}
+	const double megabytes = (double) fileSize / (1024. * 1024.);
+	printf("%s: %.2f MB, %zu triangles, best of %d: %.2f ms, %.1f MB/s, %.0f triangles/s\n", filename, megabytes,
+		   triangles, iterations, bestSeconds * 1000., megabytes / bestSeconds, (double) triangles / bestSeconds);
+	return true;
+}
+
+// A grid of quads with uvs & normals, about 'triangles' of them, the bundled meshes are too small to time the parser
+bool benchmarkSynthetic(const uint32_t triangles, const int iterations)
+{
+#ifdef _WIN32
+	const char* directory = getenv("TEMP");
+	const char* fallback = ".";
+#else
+	const char* directory = getenv("TMPDIR");
+	const char* fallback = "/tmp";
+#endif
+	char path[512];
+	snprintf(path, sizeof(path), "%s/meshbake_synthetic.obj", directory && directory[0] ? directory : fallback);
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Failed to write %s\n", path);
+		return false;
+	}
+
+	// Rolling hills so the floats have as many digits as an exported mesh's
+	uint32_t side = 1;
+	while ((uint64_t) side * side * 2 < triangles)
+		side++;
+	const uint32_t corners = side + 1;
+	for (uint32_t y = 0; y < corners; y++)
+	{
+		for (uint32_t x = 0; x < corners; x++)
+		{
+			const float u = (float) x / (float) side, v = (float) y / (float) side;
+			fprintf(file, "v %.6f %.6f %.6f\n", u * 100.f - 50.f, sinf(u * 31.f) * cosf(v * 17.f), v * 100.f - 50.f);
+			fprintf(file, "vt %.6f %.6f\n", u, v);
+			fprintf(file, "vn %.6f %.6f %.6f\n", -cosf(u * 31.f) * .3f, .9f, sinf(v * 17.f) * .3f);
+		}
+	}
+	for (uint32_t y = 0; y < side; y++)
+	{
+		for (uint32_t x = 0; x < side; x++)
+		{
+			// obj indices start at 1
+			const uint32_t a = y * corners + x + 1, b = a + 1, c = a + corners, d = c + 1;
+			fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, c, c, c, b, b, b);
+			fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", b, b, b, c, c, c, d, d, d);
+		}
+	}
+	const bool written = fclose(file) == 0;
+	const bool ok = written && benchmarkParse(path, iterations);
+	remove(path);
+	return ok;
+}
+
+bool benchmark(const char* filename, const int iterations)
+{
+	if (!benchmarkParse(filename, iterations))
+		return false;
+	benchmarkCulling(filename, iterations);
+	return benchmarkCodec(filename, iterations);
+}
+
+int main(const int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	int iterations = 0;
+	unsigned int flags = F_MESH_PACKED;
+	int failed = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-a") == 0)
+			return loadAsync(&argv[i + 1], argc - i - 1, flags);
+		if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+		{
+			iterations = atoi(argv[++i]);
+			continue;
+		}
+		if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+		{
+			benchmarkInstanceCulling(atoi(argv[++i]), iterations > 0 ? iterations : 100);
+			continue;
+		}
+		if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+		{
+			benchmarkArray(strtoull(argv[++i], NULL, 10), iterations > 0 ? iterations : 10);
+			continue;
+		}
+		if (strcmp(argv[i], "-u") == 0 && i + 1 < argc)
+		{
+			benchmarkUniforms(atoi(argv[++i]), iterations > 0 ? iterations : 10);
+			continue;
+		}
+		if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+		{
+			if (!benchmarkSynthetic((uint32_t) strtoul(argv[++i], NULL, 10), iterations > 0 ? iterations : 5))
+				failed++;
+			continue;
+		}
+		if (strcmp(argv[i], "-t") == 0)
+		{
+			if (!checkCodec())
+				failed++;
+			continue;
+		}
+		if (strcmp(argv[i], "-f") == 0)
+		{
+			flags &= ~F_MESH_PACKED;
+			continue;
+		}
+		if (strcmp(argv[i], "-h") == 0)
+		{
+			printUsage();
+			return EXIT_SUCCESS;
+		}
+
+		if (iterations > 0)
+		{
+			if (!benchmark(argv[i], iterations))
+				failed++;
+			continue;
+		}
+
+		meshData_t* data = meshDataLoadOBJ(argv[i]);
+		if (data == NULL)
+		{
+			failed++;
+			continue;
+		}
+
+		if (flags & F_MESH_PACKED)
+			meshDataPack(data, argv[i]);
+
+		char cachePath[512];
+		meshCachePath(cachePath, sizeof(cachePath), argv[i], flags);
+		if (meshCacheWrite(cachePath, argv[i], data))
+			printf("Baked %s\n", cachePath);
+		else
+		{
+			fprintf(stderr, "Failed to write %s\n", cachePath);
+			failed++;
+		}
+		meshDataDestroy(data);
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
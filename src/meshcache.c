@@ -0,0 +1,298 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "meshcache.h"
+#include "meshcodec.h"
+#include "util.h"
+
+static uint64_t alignOffset(const uint64_t offset)
+{
+	return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(uint64_t) (MESH_CACHE_ALIGNMENT - 1);
+}
+
+static bool writePadding(FILE* file, uint64_t* offset, const uint64_t target)
+{
+	static const char zeros[MESH_CACHE_ALIGNMENT] = {0};
+	const size_t count = (size_t) (target - *offset);
+	*offset = target;
+	return count == 0 || fwrite(zeros, 1, count, file) == count;
+}
+
+static unsigned char* allocBlob(const size_t size)
+{
+	unsigned char* buffer = malloc(size ? size : 1);
+	if (buffer == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh cache data!\n");
+		exit(EXIT_FAILURE);
+	}
+	return buffer;
+}
+
+static uint64_t hashSource(const char* sourcePath, bool* found)
+{
+	mappedFile_t source;
+	*found = fileMap(sourcePath, &source);
+	if (!*found)
+		return 0;
+	const uint64_t hash = hashFNV1a(source.data, source.size, HASH_FNV1A_SEED);
+	fileUnmap(&source);
+	return hash;
+}
+
+void meshCachePath(char* path, const size_t size, const char* filename, const unsigned int flags)
+{
+	snprintf(path, size, "%s%s", filename, flags & F_MESH_PACKED ? MESH_CACHE_PACKED_EXTENSION : MESH_CACHE_EXTENSION);
+}
+
+bool meshCacheWrite(const char* cachePath, const char* sourcePath, const meshData_t* data)
+{
+	meshCacheHeader_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+
+	bool found;
+	header.sourceHash = hashSource(sourcePath, &found);
+	if (!found || !fileStat(sourcePath, &header.sourceSize, &header.sourceMtime))
+		return false;
+
+	header.layout = data->layout;
+	memcpy(header.boundsMin, data->boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, data->boundsMax, sizeof(header.boundsMax));
+	header.numVertices = data->numVertices;
+	header.numIndices = data->numIndices;
+	header.indexType = meshDataIndexType(data);
+	header.numLods = data->numLods;
+	memcpy(header.lods, data->lods, sizeof(header.lods));
+	header.numMeshlets = data->numMeshlets;
+	header.numSubmeshes = data->numSubmeshes;
+	memcpy(header.materialLibrary, data->materialLibrary, sizeof(header.materialLibrary));
+
+	const size_t vertexBound = meshEncodeVertexBound(data->numVertices, data->layout.stride);
+	const size_t indexBound = meshEncodeIndexBound(data->numIndices);
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	unsigned char* encodedVertices = arenaAlloc(scratch, vertexBound);
+	unsigned char* encodedIndices = arenaAlloc(scratch, indexBound);
+	header.vertexOffset = alignOffset(sizeof(header));
+	header.vertexSize = meshEncodeVertices(encodedVertices, vertexBound, meshDataVertices(data), data->numVertices,
+										   data->layout.stride);
+	header.indexOffset = alignOffset(header.vertexOffset + header.vertexSize);
+	header.indexSize = meshEncodeIndices(encodedIndices, indexBound, data->indices, data->numIndices);
+	header.meshletOffset = alignOffset(header.indexOffset + header.indexSize);
+	header.meshletSize = (uint64_t) data->numMeshlets * sizeof(meshlet_t);
+	header.submeshOffset = alignOffset(header.meshletOffset + header.meshletSize);
+	header.submeshSize = (uint64_t) data->numSubmeshes * sizeof(meshSubmesh_t);
+
+	// Write to a temporary file first so a crash never leaves a half written cache behind
+	char tempPath[520];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", cachePath);
+	FILE* file = header.vertexSize && header.indexSize ? fopen(tempPath, "wb") : NULL;
+	if (file == NULL)
+	{
+		arenaRewind(scratchMark);
+		return false;
+	}
+
+	uint64_t offset = sizeof(header);
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && writePadding(file, &offset, header.vertexOffset);
+	ok = ok && fwrite(encodedVertices, 1, header.vertexSize, file) == header.vertexSize;
+	offset += header.vertexSize;
+	ok = ok && writePadding(file, &offset, header.indexOffset);
+	ok = ok && fwrite(encodedIndices, 1, header.indexSize, file) == header.indexSize;
+	offset += header.indexSize;
+	arenaRewind(scratchMark);
+	ok = ok && writePadding(file, &offset, header.meshletOffset);
+	ok = ok && fwrite(data->meshlets, 1, header.meshletSize, file) == header.meshletSize;
+	offset += header.meshletSize;
+	ok = ok && writePadding(file, &offset, header.submeshOffset);
+	ok = ok && fwrite(data->submeshes, 1, header.submeshSize, file) == header.submeshSize;
+	ok = fclose(file) == 0 && ok;
+
+	if (ok)
+	{
+		remove(cachePath);
+		ok = rename(tempPath, cachePath) == 0;
+	}
+	if (!ok)
+		remove(tempPath);
+	return ok;
+}
+
+// Written aligned, so anything else is corrupt & the meshlets & submeshes would be read misaligned. Checked without
+// adding, a crafted offset could wrap past the end
+static bool blobInFile(const uint64_t offset, const uint64_t size, const uint64_t fileSize)
+{
+	return offset % MESH_CACHE_ALIGNMENT == 0 && size <= fileSize && offset <= fileSize - size;
+}
+
+// Checks every range against the file & the source's size, mtime & hash
+static bool validateCache(const mappedFile_t* file, const char* sourcePath)
+{
+	const meshCacheHeader_t* header = (const meshCacheHeader_t*) file->data;
+	bool valid = file->size >= sizeof(meshCacheHeader_t) &&
+		header->magic == MESH_CACHE_MAGIC &&
+		header->version == MESH_CACHE_VERSION &&
+		header->layout.numAttributes <= MESH_MAX_ATTRIBUTES &&
+		(header->indexType == GL_UNSIGNED_SHORT || header->indexType == GL_UNSIGNED_INT) &&
+		blobInFile(header->vertexOffset, header->vertexSize, file->size) &&
+		blobInFile(header->indexOffset, header->indexSize, file->size) &&
+		header->numLods >= 1 && header->numLods <= MESH_MAX_LODS &&
+		header->meshletSize == (uint64_t) header->numMeshlets * sizeof(meshlet_t) &&
+		blobInFile(header->meshletOffset, header->meshletSize, file->size) &&
+		header->submeshSize == (uint64_t) header->numSubmeshes * sizeof(meshSubmesh_t) &&
+		blobInFile(header->submeshOffset, header->submeshSize, file->size) &&
+		memchr(header->materialLibrary, '\0', sizeof(header->materialLibrary)) != NULL;
+	for (uint32_t i = 0; valid && i < header->numLods; i++)
+		valid = (uint64_t) header->lods[i].firstIndex + header->lods[i].numIndices <= header->numIndices;
+	const meshlet_t* meshlets = (const meshlet_t*) (file->data + header->meshletOffset);
+	for (uint32_t i = 0; valid && i < header->numMeshlets; i++)
+		valid = (uint64_t) meshlets[i].firstIndex + meshlets[i].numIndices <= header->numIndices;
+	const meshSubmesh_t* submeshes = (const meshSubmesh_t*) (file->data + header->submeshOffset);
+	for (uint32_t i = 0; valid && i < header->numSubmeshes; i++)
+	{
+		valid = memchr(submeshes[i].material, '\0', sizeof(submeshes[i].material)) != NULL;
+		for (uint32_t j = 0; valid && j < header->numLods; j++)
+			valid = (uint64_t) submeshes[i].lods[j].firstIndex + submeshes[i].lods[j].numIndices <= header->numIndices;
+	}
+
+	uint64_t sourceSize, sourceMtime;
+	if (valid && fileStat(sourcePath, &sourceSize, &sourceMtime))
+	{
+		if (sourceSize != header->sourceSize)
+			valid = false;
+		else if (sourceMtime != header->sourceMtime)
+		{
+			// Touched but maybe not changed (fresh checkout, copied resources...)
+			bool found;
+			valid = hashSource(sourcePath, &found) == header->sourceHash && found;
+		}
+	}
+	return valid;
+}
+
+// Indices only exist once decoded, so a corrupt or stale stream is caught here rather than by the gpu reading past the
+// vertex buffer
+static bool indicesInRange(const void* indices, const uint32_t numIndices, const size_t indexSize, const uint32_t numVertices)
+{
+	if (indexSize == sizeof(uint16_t))
+	{
+		const uint16_t* shortIndices = indices;
+		for (uint32_t i = 0; i < numIndices; i++)
+		{
+			if (shortIndices[i] >= numVertices)
+				return false;
+		}
+		return true;
+	}
+	const uint32_t* intIndices = indices;
+	for (uint32_t i = 0; i < numIndices; i++)
+	{
+		if (intIndices[i] >= numVertices)
+			return false;
+	}
+	return true;
+}
+
+mesh_t* meshCacheLoad(const char* cachePath, const char* sourcePath)
+{
+	mappedFile_t file;
+	if (!fileMap(cachePath, &file))
+		return NULL;
+
+	mesh_t* mesh = NULL;
+	if (validateCache(&file, sourcePath))
+	{
+		const meshCacheHeader_t* header = (const meshCacheHeader_t*) file.data;
+		const size_t vertexBytes = (size_t) header->numVertices * header->layout.stride;
+		const size_t indexSize = header->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+		// Only lives until the upload, so it comes from scratch
+		arena_t* scratch = arenaScratch();
+		const arenaMark_t scratchMark = arenaGetMark(scratch);
+		unsigned char* vertices = arenaAlloc(scratch, vertexBytes);
+		unsigned char* indices = arenaAlloc(scratch, (size_t) header->numIndices * indexSize);
+		const bool decoded =
+			meshDecodeVertices(vertices, header->numVertices, header->layout.stride,
+							   (const unsigned char*) file.data + header->vertexOffset, header->vertexSize) &&
+			meshDecodeIndices(indices, header->numIndices, indexSize, (const unsigned char*) file.data + header->indexOffset,
+							  header->indexSize) &&
+			indicesInRange(indices, header->numIndices, indexSize, header->numVertices);
+		if (decoded)
+		{
+			mesh = meshCreateFromBuffers(&header->layout, (GLsizei) header->numVertices, vertices, (GLsizei) header->numIndices,
+										 header->indexType, indices, header->lods, header->numLods, header->boundsMin,
+										 header->boundsMax);
+			meshSetMeshlets(mesh, (const meshlet_t*) (file.data + header->meshletOffset), header->numMeshlets);
+			meshSetSubmeshes(mesh, (const meshSubmesh_t*) (file.data + header->submeshOffset), header->numSubmeshes,
+							 header->materialLibrary);
+		}
+		arenaRewind(scratchMark);
+	}
+	fileUnmap(&file);
+	return mesh;
+}
+
+static void* copyBlob(const char* data, const size_t size)
+{
+	void* blob = allocBlob(size);
+	memcpy(blob, data, size);
+	return blob;
+}
+
+meshData_t* meshCacheLoadData(const char* cachePath, const char* sourcePath)
+{
+	mappedFile_t file;
+	if (!fileMap(cachePath, &file))
+		return NULL;
+	if (!validateCache(&file, sourcePath))
+	{
+		fileUnmap(&file);
+		return NULL;
+	}
+
+	const meshCacheHeader_t* header = (const meshCacheHeader_t*) file.data;
+	meshData_t* data = calloc(1, sizeof(meshData_t));
+	if (data == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh data!\n");
+		exit(EXIT_FAILURE);
+	}
+	data->layout = header->layout;
+	data->numVertices = header->numVertices;
+	data->numIndices = header->numIndices;
+	data->numLods = header->numLods;
+	memcpy(data->lods, header->lods, sizeof(data->lods));
+	memcpy(data->boundsMin, header->boundsMin, sizeof(data->boundsMin));
+	memcpy(data->boundsMax, header->boundsMax, sizeof(data->boundsMax));
+	memcpy(data->materialLibrary, header->materialLibrary, sizeof(data->materialLibrary));
+
+	// Only the gpu vertices are cached, the float source vertices & tangents stay behind
+	data->vertices = array_float_create(0);
+	data->gpuVertices = allocBlob((size_t) header->numVertices * header->layout.stride);
+	data->indices = (uint32_t*) allocBlob((size_t) header->numIndices * sizeof(uint32_t));
+	if (!meshDecodeVertices(data->gpuVertices, header->numVertices, header->layout.stride,
+							(const unsigned char*) file.data + header->vertexOffset, header->vertexSize) ||
+		!meshDecodeIndices(data->indices, header->numIndices, sizeof(uint32_t),
+						   (const unsigned char*) file.data + header->indexOffset, header->indexSize) ||
+		!indicesInRange(data->indices, header->numIndices, sizeof(uint32_t), header->numVertices))
+	{
+		fileUnmap(&file);
+		meshDataDestroy(data);
+		return NULL;
+	}
+
+	data->numMeshlets = header->numMeshlets;
+	data->meshlets = copyBlob(file.data + header->meshletOffset, header->meshletSize);
+	data->numSubmeshes = header->numSubmeshes;
+	data->submeshes = copyBlob(file.data + header->submeshOffset, header->submeshSize);
+	fileUnmap(&file);
+	return data;
+}
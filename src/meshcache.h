@@ -0,0 +1,63 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "model.h"
+
+#define MESH_CACHE_EXTENSION ".mesh"
+#define MESH_CACHE_PACKED_EXTENSION ".packed.mesh"
+#define MESH_CACHE_MAGIC 0x4853454Du // "MESH"
+#define MESH_CACHE_VERSION 8
+#define MESH_CACHE_ALIGNMENT 64 // Blobs start on a cache line
+
+typedef struct meshCacheHeader_t
+{
+	uint32_t magic;
+	uint32_t version;
+
+	// Source obj the cache was built from, checked in order: size & mtime, then hash if only the mtime changed
+	uint64_t sourceSize;
+	uint64_t sourceMtime;
+	uint64_t sourceHash;
+
+	meshLayout_t layout;
+	float boundsMin[3];
+	float boundsMax[3];
+
+	uint32_t numVertices;
+	uint32_t numIndices;
+	uint32_t indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	uint32_t numLods;
+	meshLod_t lods[MESH_MAX_LODS];
+	uint32_t numMeshlets;
+	uint32_t numSubmeshes;
+	char materialLibrary[MATERIAL_PATH_LENGTH]; // Loaded at runtime, so editing the mtl needs no rebake
+
+	// Byte offsets from the start of the file, vertices & indices are meshcodec streams so their sizes are encoded ones
+	uint64_t vertexOffset;
+	uint64_t vertexSize;
+	uint64_t indexOffset;
+	uint64_t indexSize;
+	uint64_t meshletOffset;
+	uint64_t meshletSize;
+	uint64_t submeshOffset;
+	uint64_t submeshSize;
+} meshCacheHeader_t;
+
+// '<filename>.mesh', or '<filename>.packed.mesh' for F_MESH_PACKED
+void meshCachePath(char* path, size_t size, const char* filename, unsigned int flags);
+// Writes the gpu vertices, packed if meshDataPack was called
+bool meshCacheWrite(const char* cachePath, const char* sourcePath, const meshData_t* data);
+// Returns NULL if the cache is missing, corrupt or older than the source, a missing source is fine (baked deployments)
+mesh_t* meshCacheLoad(const char* cachePath, const char* sourcePath);
+// Same checks as meshCacheLoad but copies into a meshData_t, cpu only so it's safe off the GL thread
+meshData_t* meshCacheLoadData(const char* cachePath, const char* sourcePath);
+
+#endif //MESHCACHE_H
@@ -0,0 +1,501 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <string.h>
+
+#include "arena.h"
+#include "meshcodec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE
+#include <emmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define GROUP_SIZE 16
+
+static const size_t groupBytes[4] = {0, 4, 8, 16}; // Payload of a group for each 2 bit header
+
+// Payload of the 4 groups in a header byte, 4 bytes per step of width plus 4 more for each raw (width 3) group
+static inline size_t headerBytes(const unsigned int header)
+{
+	const unsigned int pairs = (header & 0x33) + (header >> 2 & 0x33);
+	const unsigned int raw = header & header >> 1 & 0x55;
+	return 4 * ((pairs & 0x0F) + (pairs >> 4) + (raw & 1) + (raw >> 2 & 1) + (raw >> 4 & 1) + (raw >> 6 & 1));
+}
+
+static inline int lowestBit(const uint64_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return (int) index;
+#else
+	return __builtin_ctzll(bits);
+#endif
+}
+
+static inline unsigned char zigzag8(const unsigned char delta)
+{
+	return (unsigned char) ((delta << 1) ^ (unsigned char) ((signed char) delta >> 7));
+}
+
+size_t meshEncodeIndexBound(const size_t numIndices)
+{
+	return 1 + numIndices * 5;
+}
+
+size_t meshEncodeIndices(unsigned char* buffer, const size_t size, const uint32_t* indices, const size_t numIndices)
+{
+	if (size < 1)
+		return 0;
+	size_t position = 0;
+	buffer[position++] = MESH_CODEC_VERSION;
+
+	uint32_t previous = 0;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		const uint32_t delta = indices[i] - previous;
+		uint32_t value = (delta << 1) ^ (uint32_t) ((int32_t) delta >> 31);
+		previous = indices[i];
+		do
+		{
+			if (position >= size)
+				return 0;
+			buffer[position++] = (unsigned char) ((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+			value >>= 7;
+		} while (value);
+	}
+	return position;
+}
+
+bool meshDecodeIndices(void* destination, const size_t numIndices, const size_t indexSize, const unsigned char* buffer,
+					   const size_t size)
+{
+	if (size < 1 || buffer[0] != MESH_CODEC_VERSION || (indexSize != 2 && indexSize != 4))
+		return false;
+
+	uint16_t* indices16 = destination;
+	uint32_t* indices32 = destination;
+	const uint32_t maxIndex = indexSize == 2 ? 0xFFFFu : 0xFFFFFFFFu;
+	size_t position = 1;
+	uint32_t previous = 0;
+	size_t i = 0;
+	while (i < numIndices)
+	{
+		// Most varints are one byte, so the run of them at the start of the next 8 bytes goes without any per byte checks
+		if (numIndices - i >= 8 && size - position >= 8)
+		{
+			uint64_t bytes;
+			memcpy(&bytes, buffer + position, sizeof(bytes));
+			const uint64_t continues = bytes & 0x8080808080808080ull;
+			const int run = continues ? lowestBit(continues) / 8 : 8;
+			for (int b = 0; b < run; b++, i++)
+			{
+				const uint32_t value = (uint32_t) (bytes >> (b * 8)) & 0x7F;
+				previous += (value >> 1) ^ (uint32_t) -(value & 1);
+				if (previous > maxIndex)
+					return false;
+				if (indexSize == 2)
+					indices16[i] = (uint16_t) previous;
+				else
+					indices32[i] = previous;
+			}
+			position += (size_t) run;
+			if (run == 8)
+				continue;
+		}
+
+		uint32_t value = 0;
+		unsigned int shift = 0;
+		unsigned char byte;
+		// Varints are at most 5 bytes, so bounds are only checked near the end
+		if (size - position >= 5)
+		{
+			do
+			{
+				byte = buffer[position++];
+				value |= (uint32_t) (byte & 0x7F) << shift;
+				shift += 7;
+			} while ((byte & 0x80) && shift < 35);
+		} else
+		{
+			do
+			{
+				if (position >= size)
+					return false;
+				byte = buffer[position++];
+				value |= (uint32_t) (byte & 0x7F) << shift;
+				shift += 7;
+			} while ((byte & 0x80) && shift < 35);
+		}
+		if (byte & 0x80)
+			return false;
+
+		previous += (value >> 1) ^ (uint32_t) -(value & 1);
+		if (previous > maxIndex)
+			return false;
+		if (indexSize == 2)
+			indices16[i] = (uint16_t) previous;
+		else
+			indices32[i] = previous;
+		i++;
+	}
+	return position == size;
+}
+
+size_t meshEncodeVertexBound(const size_t numVertices, const size_t stride)
+{
+	const size_t numBlocks = (numVertices + MESH_CODEC_BLOCK_VERTICES - 1) / MESH_CODEC_BLOCK_VERTICES;
+	// A header byte per 4 groups, then at worst the raw bytes
+	return 1 + numBlocks * stride * (MESH_CODEC_BLOCK_VERTICES / (GROUP_SIZE * 4) + MESH_CODEC_BLOCK_VERTICES);
+}
+
+size_t meshEncodeVertices(unsigned char* buffer, const size_t size, const void* vertices, const size_t numVertices,
+						  const size_t stride)
+{
+	if (size < 1 || stride == 0 || stride > MESH_CODEC_MAX_STRIDE)
+		return 0;
+	size_t position = 0;
+	buffer[position++] = MESH_CODEC_VERSION;
+
+	const unsigned char* source = vertices;
+	unsigned char previous[MESH_CODEC_MAX_STRIDE] = {0};
+	unsigned char deltas[MESH_CODEC_BLOCK_VERTICES];
+	for (size_t first = 0; first < numVertices; first += MESH_CODEC_BLOCK_VERTICES)
+	{
+		const size_t count = numVertices - first < MESH_CODEC_BLOCK_VERTICES ? numVertices - first : MESH_CODEC_BLOCK_VERTICES;
+		const size_t numGroups = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+		const size_t headerSize = (numGroups + 3) / 4;
+		for (size_t k = 0; k < stride; k++)
+		{
+			// Byte plane k, as zigzagged differences from the previous vertex
+			for (size_t i = 0; i < count; i++)
+			{
+				const unsigned char byte = source[(first + i) * stride + k];
+				deltas[i] = zigzag8((unsigned char) (byte - previous[k]));
+				previous[k] = byte;
+			}
+			memset(deltas + count, 0, numGroups * GROUP_SIZE - count);
+
+			if (size - position < headerSize)
+				return 0;
+			unsigned char* header = buffer + position;
+			memset(header, 0, headerSize);
+			position += headerSize;
+
+			for (size_t g = 0; g < numGroups; g++)
+			{
+				const unsigned char* group = deltas + g * GROUP_SIZE;
+				unsigned char bits = 0;
+				for (int i = 0; i < GROUP_SIZE; i++)
+					bits |= group[i];
+				const unsigned int width = bits == 0 ? 0 : bits < 4 ? 1 : bits < 16 ? 2 : 3;
+				header[g / 4] |= (unsigned char) (width << (g % 4 * 2));
+
+				if (size - position < groupBytes[width])
+					return 0;
+				unsigned char* payload = buffer + position;
+				// Payload byte i holds deltas i, i + 4, i + 8 & i + 12 (or i & i + 8), so decoding is shifts & masks over words
+				if (width == 1)
+				{
+					for (int i = 0; i < 4; i++)
+						payload[i] = (unsigned char) (group[i] | group[i + 4] << 2 | group[i + 8] << 4 | group[i + 12] << 6);
+				} else if (width == 2)
+				{
+					for (int i = 0; i < 8; i++)
+						payload[i] = (unsigned char) (group[i] | group[i + 8] << 4);
+				} else if (width == 3)
+					memcpy(payload, group, GROUP_SIZE);
+				position += groupBytes[width];
+			}
+		}
+	}
+	return position;
+}
+
+// Unpacks one plane's groups (still zigzagged), the caller has checked the whole payload is there
+static void decodeGroups(unsigned char* plane, const unsigned char* header, const unsigned char* payload, const size_t numGroups)
+{
+	for (size_t g = 0; g < numGroups; g++)
+	{
+		unsigned char* group = plane + g * GROUP_SIZE;
+		switch (header[g / 4] >> (g % 4 * 2) & 3)
+		{
+			case 0:
+				memset(group, 0, GROUP_SIZE);
+				break;
+			case 1:
+			{
+				uint32_t bits;
+				memcpy(&bits, payload, sizeof(bits));
+				for (int i = 0; i < 4; i++)
+				{
+					const uint32_t quarter = bits >> (i * 2) & 0x03030303u;
+					memcpy(group + i * 4, &quarter, sizeof(quarter));
+				}
+				payload += 4;
+				break;
+			}
+			case 2:
+			{
+				uint64_t bits;
+				memcpy(&bits, payload, sizeof(bits));
+				const uint64_t low = bits & 0x0F0F0F0F0F0F0F0Full, high = bits >> 4 & 0x0F0F0F0F0F0F0F0Full;
+				memcpy(group, &low, sizeof(low));
+				memcpy(group + 8, &high, sizeof(high));
+				payload += 8;
+				break;
+			}
+			default:
+				memcpy(group, payload, GROUP_SIZE);
+				payload += GROUP_SIZE;
+				break;
+		}
+	}
+}
+
+#ifdef MESH_CODEC_SSE
+// Which of the unpacked groups (2 bit, 4 bit, raw) each width keeps
+static const unsigned char widthMasks[4][3][GROUP_SIZE] = {
+	{{0}, {0}, {0}},
+	{{0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, {0}, {0}},
+	{{0}, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}, {0}},
+	{{0}, {0}, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}},
+};
+
+static inline __m128i unzigzag(const __m128i zigzag)
+{
+	return _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(zigzag, 1), _mm_set1_epi8(0x7F)),
+						 _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(zigzag, _mm_set1_epi8(1))));
+}
+
+// decodeGroups without branching on the widths (they're close to random) & unzigzagged. Reads up to GROUP_SIZE bytes
+// past the payload, so the caller only uses it away from the end of the stream
+static void decodeGroupsSse(unsigned char* plane, const unsigned char* header, const unsigned char* payload,
+							const size_t numGroups)
+{
+	for (size_t g = 0; g < numGroups; g++)
+	{
+		const unsigned int width = header[g / 4] >> (g % 4 * 2) & 3;
+		const __m128i raw = _mm_loadu_si128((const __m128i*) payload);
+		payload += groupBytes[width];
+
+		// Dword 0 shifted by 0, 2, 4 & 6 bits into the four lanes
+		const __m128i word = _mm_shuffle_epi32(raw, 0);
+		const __m128i shifted = _mm_unpacklo_epi64(_mm_unpacklo_epi32(word, _mm_srli_epi32(word, 2)),
+												   _mm_unpacklo_epi32(_mm_srli_epi32(word, 4), _mm_srli_epi32(word, 6)));
+		const __m128i unpacked2 = _mm_and_si128(shifted, _mm_set1_epi8(0x03));
+		const __m128i unpacked4 = _mm_and_si128(_mm_unpacklo_epi64(raw, _mm_srli_epi16(raw, 4)), _mm_set1_epi8(0x0F));
+		const __m128i zigzag = _mm_or_si128(
+			_mm_or_si128(_mm_and_si128(unpacked2, _mm_loadu_si128((const __m128i*) widthMasks[width][0])),
+						 _mm_and_si128(unpacked4, _mm_loadu_si128((const __m128i*) widthMasks[width][1]))),
+			_mm_and_si128(raw, _mm_loadu_si128((const __m128i*) widthMasks[width][2])));
+		_mm_storeu_si128((__m128i*) (plane + g * GROUP_SIZE), unzigzag(zigzag));
+	}
+}
+
+static void unzigzagPlane(unsigned char* plane, const size_t length)
+{
+	for (size_t i = 0; i < length; i += GROUP_SIZE)
+		_mm_storeu_si128((__m128i*) (plane + i), unzigzag(_mm_loadu_si128((const __m128i*) (plane + i))));
+}
+
+// 16 planes of 16 vertices in, the 16 vertices' bytes out. Written out by hand, as loops over arrays of these end up
+// going through the stack
+static inline void transpose16(__m128i rows[16])
+{
+	// Pairs of planes, then quads, then eights, each step doubling the bytes kept together per vertex
+	const __m128i p0a = _mm_unpacklo_epi8(rows[0], rows[1]), p0b = _mm_unpackhi_epi8(rows[0], rows[1]);
+	const __m128i p1a = _mm_unpacklo_epi8(rows[2], rows[3]), p1b = _mm_unpackhi_epi8(rows[2], rows[3]);
+	const __m128i p2a = _mm_unpacklo_epi8(rows[4], rows[5]), p2b = _mm_unpackhi_epi8(rows[4], rows[5]);
+	const __m128i p3a = _mm_unpacklo_epi8(rows[6], rows[7]), p3b = _mm_unpackhi_epi8(rows[6], rows[7]);
+	const __m128i p4a = _mm_unpacklo_epi8(rows[8], rows[9]), p4b = _mm_unpackhi_epi8(rows[8], rows[9]);
+	const __m128i p5a = _mm_unpacklo_epi8(rows[10], rows[11]), p5b = _mm_unpackhi_epi8(rows[10], rows[11]);
+	const __m128i p6a = _mm_unpacklo_epi8(rows[12], rows[13]), p6b = _mm_unpackhi_epi8(rows[12], rows[13]);
+	const __m128i p7a = _mm_unpacklo_epi8(rows[14], rows[15]), p7b = _mm_unpackhi_epi8(rows[14], rows[15]);
+	const __m128i q0a = _mm_unpacklo_epi16(p0a, p1a), q0b = _mm_unpackhi_epi16(p0a, p1a);
+	const __m128i q0c = _mm_unpacklo_epi16(p0b, p1b), q0d = _mm_unpackhi_epi16(p0b, p1b);
+	const __m128i q1a = _mm_unpacklo_epi16(p2a, p3a), q1b = _mm_unpackhi_epi16(p2a, p3a);
+	const __m128i q1c = _mm_unpacklo_epi16(p2b, p3b), q1d = _mm_unpackhi_epi16(p2b, p3b);
+	const __m128i q2a = _mm_unpacklo_epi16(p4a, p5a), q2b = _mm_unpackhi_epi16(p4a, p5a);
+	const __m128i q2c = _mm_unpacklo_epi16(p4b, p5b), q2d = _mm_unpackhi_epi16(p4b, p5b);
+	const __m128i q3a = _mm_unpacklo_epi16(p6a, p7a), q3b = _mm_unpackhi_epi16(p6a, p7a);
+	const __m128i q3c = _mm_unpacklo_epi16(p6b, p7b), q3d = _mm_unpackhi_epi16(p6b, p7b);
+	const __m128i e00 = _mm_unpacklo_epi32(q0a, q1a), e01 = _mm_unpackhi_epi32(q0a, q1a);
+	const __m128i e02 = _mm_unpacklo_epi32(q0b, q1b), e03 = _mm_unpackhi_epi32(q0b, q1b);
+	const __m128i e04 = _mm_unpacklo_epi32(q0c, q1c), e05 = _mm_unpackhi_epi32(q0c, q1c);
+	const __m128i e06 = _mm_unpacklo_epi32(q0d, q1d), e07 = _mm_unpackhi_epi32(q0d, q1d);
+	const __m128i e10 = _mm_unpacklo_epi32(q2a, q3a), e11 = _mm_unpackhi_epi32(q2a, q3a);
+	const __m128i e12 = _mm_unpacklo_epi32(q2b, q3b), e13 = _mm_unpackhi_epi32(q2b, q3b);
+	const __m128i e14 = _mm_unpacklo_epi32(q2c, q3c), e15 = _mm_unpackhi_epi32(q2c, q3c);
+	const __m128i e16 = _mm_unpacklo_epi32(q2d, q3d), e17 = _mm_unpackhi_epi32(q2d, q3d);
+	rows[0] = _mm_unpacklo_epi64(e00, e10);
+	rows[1] = _mm_unpackhi_epi64(e00, e10);
+	rows[2] = _mm_unpacklo_epi64(e01, e11);
+	rows[3] = _mm_unpackhi_epi64(e01, e11);
+	rows[4] = _mm_unpacklo_epi64(e02, e12);
+	rows[5] = _mm_unpackhi_epi64(e02, e12);
+	rows[6] = _mm_unpacklo_epi64(e03, e13);
+	rows[7] = _mm_unpackhi_epi64(e03, e13);
+	rows[8] = _mm_unpacklo_epi64(e04, e14);
+	rows[9] = _mm_unpackhi_epi64(e04, e14);
+	rows[10] = _mm_unpacklo_epi64(e05, e15);
+	rows[11] = _mm_unpackhi_epi64(e05, e15);
+	rows[12] = _mm_unpacklo_epi64(e06, e16);
+	rows[13] = _mm_unpackhi_epi64(e06, e16);
+	rows[14] = _mm_unpacklo_epi64(e07, e17);
+	rows[15] = _mm_unpackhi_epi64(e07, e17);
+}
+
+// The low 'bytes' (under 16) of 'x'
+static inline void storePartial(unsigned char* output, __m128i x, const size_t bytes)
+{
+	if (bytes & 8)
+	{
+		_mm_storel_epi64((__m128i*) output, x);
+		output += 8;
+		x = _mm_srli_si128(x, 8);
+	}
+	uint32_t rest = (uint32_t) _mm_cvtsi128_si32(x);
+	if (bytes & 4)
+	{
+		memcpy(output, &rest, sizeof(uint32_t));
+		output += 4;
+		rest = (uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(x, 4));
+	}
+	if (bytes & 2)
+	{
+		memcpy(output, &rest, sizeof(uint16_t));
+		output += 2;
+		rest >>= 16;
+	}
+	if (bytes & 1)
+		*output = (unsigned char) rest;
+}
+
+// Transposes the block's deltas 16 planes by 16 vertices at a time, so undoing them is one add per vertex & chunk.
+// 'planes' has room for whole chunks even if 'stride' isn't a multiple of 16, 'previous' is the last vertex so far.
+// Chunks go last to first so a short chunk can still be stored whole, spilling into the next vertex's first chunk
+// before that's written, only stores that would pass the end of the block are cut short
+static void interleavePlanes(unsigned char* vertices, const unsigned char* planes, const size_t count, const size_t stride,
+							 unsigned char* previous)
+{
+	const unsigned char* end = vertices + count * stride;
+	for (size_t chunk = (stride + 15) / 16; chunk-- > 0;)
+	{
+		const size_t k = chunk * 16;
+		const size_t width = stride - k < 16 ? stride - k : 16;
+		__m128i vertex = _mm_loadu_si128((const __m128i*) (previous + k));
+		for (size_t i = 0; i < count; i += 16)
+		{
+			__m128i rows[16];
+			for (int r = 0; r < 16; r++)
+				rows[r] = _mm_loadu_si128((const __m128i*) (planes + (k + r) * MESH_CODEC_BLOCK_VERTICES + i));
+			transpose16(rows);
+
+			// Only a partial block's last group stops early
+			const size_t numRows = count - i < 16 ? count - i : 16;
+			unsigned char* output = vertices + i * stride + k;
+			for (size_t r = 0; r < numRows; r++)
+			{
+				vertex = _mm_add_epi8(vertex, rows[r]);
+				if (output + r * stride + 16 <= end)
+					_mm_storeu_si128((__m128i*) (output + r * stride), vertex);
+				else
+					storePartial(output + r * stride, vertex, width);
+			}
+		}
+		_mm_storeu_si128((__m128i*) (previous + k), vertex);
+	}
+}
+#else
+// Unzigzags & sums the deltas of a plane in place, starting from 'previous'
+static void integratePlane(unsigned char* plane, const size_t length, const unsigned char previous)
+{
+	unsigned char value = previous;
+	for (size_t i = 0; i < length; i++)
+	{
+		value += (unsigned char) (plane[i] >> 1 ^ -(plane[i] & 1));
+		plane[i] = value;
+	}
+}
+
+static void interleavePlanes(unsigned char* vertices, const unsigned char* planes, const size_t count, const size_t stride,
+							 unsigned char* previous)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		for (size_t k = 0; k < stride; k++)
+			vertices[i * stride + k] = planes[k * MESH_CODEC_BLOCK_VERTICES + i];
+	}
+	for (size_t k = 0; k < stride; k++)
+		previous[k] = planes[k * MESH_CODEC_BLOCK_VERTICES + count - 1];
+}
+#endif
+
+bool meshDecodeVertices(void* destination, const size_t numVertices, const size_t stride, const unsigned char* buffer,
+						const size_t size)
+{
+	if (size < 1 || buffer[0] != MESH_CODEC_VERSION || stride == 0 || stride > MESH_CODEC_MAX_STRIDE)
+		return false;
+
+	// Each block's planes are decoded into scratch first, then summed & interleaved into the vertices in one pass
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	// Rounded up to whole 16 plane chunks for interleavePlanes
+	const size_t paddedStride = (stride + 15) / 16 * 16;
+	unsigned char* planes = arenaAlloc(scratch, paddedStride * MESH_CODEC_BLOCK_VERTICES);
+	unsigned char previous[MESH_CODEC_MAX_STRIDE + 16] = {0};
+	unsigned char* vertices = destination;
+	size_t position = 1;
+	bool ok = true;
+	for (size_t first = 0; ok && first < numVertices; first += MESH_CODEC_BLOCK_VERTICES)
+	{
+		const size_t count = numVertices - first < MESH_CODEC_BLOCK_VERTICES ? numVertices - first : MESH_CODEC_BLOCK_VERTICES;
+		const size_t numGroups = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+		const size_t headerSize = (numGroups + 3) / 4;
+		for (size_t k = 0; k < stride; k++)
+		{
+			if (size - position < headerSize)
+			{
+				ok = false;
+				break;
+			}
+			const unsigned char* header = buffer + position;
+			position += headerSize;
+
+			// The headers give the payload's size, so it's checked once rather than per group. Groups past the end of a
+			// partial block have header bits 0
+			size_t payloadSize = 0;
+			for (size_t h = 0; h < headerSize; h++)
+				payloadSize += headerBytes(header[h]);
+			if (size - position < payloadSize)
+			{
+				ok = false;
+				break;
+			}
+			unsigned char* plane = planes + k * MESH_CODEC_BLOCK_VERTICES;
+#ifdef MESH_CODEC_SSE
+			if (size - position >= payloadSize + GROUP_SIZE)
+				decodeGroupsSse(plane, header, buffer + position, numGroups);
+			else
+			{
+				decodeGroups(plane, header, buffer + position, numGroups);
+				unzigzagPlane(plane, numGroups * GROUP_SIZE);
+			}
+#else
+			decodeGroups(plane, header, buffer + position, numGroups);
+			integratePlane(plane, numGroups * GROUP_SIZE, previous[k]);
+#endif
+			position += payloadSize;
+		}
+		if (ok)
+			interleavePlanes(vertices + first * stride, planes, count, stride, previous);
+	}
+	arenaRewind(scratchMark);
+	return ok && position == size;
+}
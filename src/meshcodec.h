@@ -0,0 +1,36 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Mesh geometry compression for the baked caches, cpu only & decodes straight into the caller's buffer
+ */
+
+#ifndef MESHCODEC_H
+#define MESHCODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESH_CODEC_VERSION 1 // First byte of every stream
+#define MESH_CODEC_BLOCK_VERTICES 256 // Vertices per block, a multiple of 16 so groups never straddle blocks
+#define MESH_CODEC_MAX_STRIDE 256
+
+// Indices: every index is the zigzagged difference from the previous one as a varint (LEB128), lossless
+// Optimized meshes reuse nearby vertices, so most indices end up one byte
+
+// Worst case encoded size, for sizing the destination
+size_t meshEncodeIndexBound(size_t numIndices);
+// Returns the encoded size, 0 if 'size' is too small
+size_t meshEncodeIndices(unsigned char* buffer, size_t size, const uint32_t* indices, size_t numIndices);
+// 'indexSize' is 2 or 4 (GL_UNSIGNED_SHORT/INT), false if the stream is corrupt or doesn't hold exactly 'numIndices'
+bool meshDecodeIndices(void* destination, size_t numIndices, size_t indexSize, const unsigned char* buffer, size_t size);
+
+// Vertices: lossless over whatever layout they're in, quantizing is meshDataPack's job (F_MESH_PACKED)
+// Blocks are split into byte planes (byte k of every vertex), each plane is delta coded against the previous vertex,
+// zigzagged, then bit packed in groups of 16 bytes at 0, 2, 4 or 8 bits per byte picked by a 2 bit header
+
+size_t meshEncodeVertexBound(size_t numVertices, size_t stride);
+// Returns the encoded size, 0 if 'size' is too small or 'stride' is over MESH_CODEC_MAX_STRIDE
+size_t meshEncodeVertices(unsigned char* buffer, size_t size, const void* vertices, size_t numVertices, size_t stride);
+bool meshDecodeVertices(void* destination, size_t numVertices, size_t stride, const unsigned char* buffer, size_t size);
+
+#endif //MESHCODEC_H
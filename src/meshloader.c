@@ -0,0 +1,234 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "meshloader.h"
+#include "resources.h"
+#include "util.h"
+
+static bool uploadMesh(meshLoadHandle_t* handle, void* user)
+{
+	(void) user;
+	handle->mesh = resourcesAddMesh(meshCreateFromData(handle->data));
+	return handle->mesh.id != POOL_NULL;
+}
+
+// Lock-free push, any number of workers can race on it
+static void pushFinished(meshLoader_t* loader, meshLoadHandle_t* handle)
+{
+	meshLoadHandle_t* head = atomic_load_explicit(&loader->finished, memory_order_relaxed);
+	do
+		handle->next = head;
+	while (!atomic_compare_exchange_weak_explicit(&loader->finished, &head, handle, memory_order_release,
+												  memory_order_relaxed));
+}
+
+static void* workerMain(void* arg)
+{
+	meshLoader_t* loader = arg;
+	for (;;)
+	{
+		pthread_mutex_lock(&loader->mutex);
+		while (loader->jobHead == NULL && !loader->quit)
+			pthread_cond_wait(&loader->wake, &loader->mutex);
+		if (loader->quit)
+		{
+			pthread_mutex_unlock(&loader->mutex);
+			return NULL;
+		}
+		meshLoadHandle_t* handle = loader->jobHead;
+		loader->jobHead = handle->next;
+		if (loader->jobHead == NULL)
+			loader->jobTail = NULL;
+		pthread_mutex_unlock(&loader->mutex);
+
+		handle->data = meshDataLoad(handle->filename, handle->flags);
+		handle->parsedSeconds = timeGetSeconds();
+		atomic_store_explicit(&handle->state, handle->data ? MESH_LOAD_PARSED : MESH_LOAD_FAILED, memory_order_relaxed);
+		pushFinished(loader, handle);
+	}
+}
+
+meshLoader_t* meshLoaderCreate(const meshUploadFunc_t upload, void* uploadUser)
+{
+	meshLoader_t* loader = calloc(1, sizeof(meshLoader_t));
+	if (loader == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh loader!\n");
+		exit(EXIT_FAILURE);
+	}
+	loader->upload = upload ? upload : uploadMesh;
+	loader->uploadUser = uploadUser;
+	atomic_init(&loader->finished, NULL);
+	atomic_init(&loader->numInFlight, 0);
+	pthread_mutex_init(&loader->mutex, NULL);
+	pthread_cond_init(&loader->wake, NULL);
+
+	for (uint32_t i = 0; i < MESH_LOADER_WORKERS; i++)
+	{
+		if (pthread_create(&loader->workers[loader->numWorkers], NULL, workerMain, loader) == 0)
+			loader->numWorkers++;
+	}
+	if (loader->numWorkers == 0)
+		fprintf(stderr, "Failed to start mesh loader workers, meshes will load in meshLoaderUpdate\n");
+	return loader;
+}
+
+void meshLoaderDestroy(meshLoader_t* loader)
+{
+	pthread_mutex_lock(&loader->mutex);
+	loader->quit = true;
+	pthread_cond_broadcast(&loader->wake);
+	pthread_mutex_unlock(&loader->mutex);
+	for (uint32_t i = 0; i < loader->numWorkers; i++)
+		pthread_join(loader->workers[i], NULL);
+
+	meshLoadHandle_t* handle = loader->handles;
+	while (handle)
+	{
+		meshLoadHandle_t* next = handle->nextHandle;
+		if (handle->data)
+			meshDataDestroy(handle->data);
+		free(handle);
+		handle = next;
+	}
+	pthread_cond_destroy(&loader->wake);
+	pthread_mutex_destroy(&loader->mutex);
+	free(loader);
+}
+
+meshLoadHandle_t* meshLoadAsync(meshLoader_t* loader, const char* filename, const unsigned int flags)
+{
+	meshLoadHandle_t* handle = calloc(1, sizeof(meshLoadHandle_t));
+	if (handle == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh load!\n");
+		exit(EXIT_FAILURE);
+	}
+	snprintf(handle->filename, sizeof(handle->filename), "%s", filename);
+	handle->flags = flags;
+	atomic_init(&handle->state, MESH_LOAD_QUEUED);
+	handle->queuedSeconds = timeGetSeconds();
+	handle->nextHandle = loader->handles;
+	loader->handles = handle;
+	atomic_fetch_add_explicit(&loader->numInFlight, 1, memory_order_relaxed);
+
+	pthread_mutex_lock(&loader->mutex);
+	if (loader->jobTail)
+		loader->jobTail->next = handle;
+	else
+		loader->jobHead = handle;
+	loader->jobTail = handle;
+	pthread_cond_signal(&loader->wake);
+	pthread_mutex_unlock(&loader->mutex);
+	return handle;
+}
+
+// Without workers the owner parses the next job itself, slow but never stuck
+static void loadQueuedInline(meshLoader_t* loader)
+{
+	pthread_mutex_lock(&loader->mutex);
+	meshLoadHandle_t* handle = loader->jobHead;
+	if (handle)
+	{
+		loader->jobHead = handle->next;
+		if (loader->jobHead == NULL)
+			loader->jobTail = NULL;
+	}
+	pthread_mutex_unlock(&loader->mutex);
+	if (handle == NULL)
+		return;
+
+	handle->data = meshDataLoad(handle->filename, handle->flags);
+	handle->parsedSeconds = timeGetSeconds();
+	atomic_store_explicit(&handle->state, handle->data ? MESH_LOAD_PARSED : MESH_LOAD_FAILED, memory_order_relaxed);
+	pushFinished(loader, handle);
+}
+
+uint32_t meshLoaderUpdate(meshLoader_t* loader, const double budgetMs)
+{
+	const double startTime = timeGetSeconds();
+	if (loader->numWorkers == 0)
+		loadQueuedInline(loader);
+
+	// The stack is newest first, reverse it onto the pending list to upload in finishing order
+	meshLoadHandle_t* stack = atomic_exchange_explicit(&loader->finished, NULL, memory_order_acquire);
+	meshLoadHandle_t* reversed = NULL;
+	meshLoadHandle_t* tail = stack;
+	while (stack)
+	{
+		meshLoadHandle_t* next = stack->next;
+		stack->next = reversed;
+		reversed = stack;
+		stack = next;
+	}
+	if (reversed)
+	{
+		if (loader->pendingTail)
+			loader->pendingTail->next = reversed;
+		else
+			loader->pendingHead = reversed;
+		loader->pendingTail = tail;
+	}
+
+	uint32_t numUploaded = 0;
+	while (loader->pendingHead)
+	{
+		// At least one upload a call so a mesh bigger than the budget still gets through
+		if (numUploaded > 0 && (timeGetSeconds() - startTime) * 1000. >= budgetMs)
+			break;
+
+		meshLoadHandle_t* handle = loader->pendingHead;
+		loader->pendingHead = handle->next;
+		if (loader->pendingHead == NULL)
+			loader->pendingTail = NULL;
+		handle->next = NULL;
+		atomic_fetch_sub_explicit(&loader->numInFlight, 1, memory_order_relaxed);
+
+		if (atomic_load_explicit(&handle->state, memory_order_relaxed) == MESH_LOAD_FAILED)
+		{
+			fprintf(stderr, "Failed to load mesh %s\n", handle->filename);
+			loader->numFailed++;
+			continue;
+		}
+
+		const bool uploaded = loader->upload(handle, loader->uploadUser);
+		meshDataDestroy(handle->data);
+		handle->data = NULL;
+		handle->readySeconds = timeGetSeconds();
+		if (uploaded)
+		{
+			atomic_store_explicit(&handle->state, MESH_LOAD_READY, memory_order_relaxed);
+			loader->numReady++;
+			numUploaded++;
+			printf("Mesh %s ready (%.2f ms after queueing, %.2f ms waiting for upload)\n", handle->filename,
+				   (handle->readySeconds - handle->queuedSeconds) * 1000., (handle->readySeconds - handle->parsedSeconds) * 1000.);
+		} else
+		{
+			atomic_store_explicit(&handle->state, MESH_LOAD_FAILED, memory_order_relaxed);
+			fprintf(stderr, "Failed to upload mesh %s\n", handle->filename);
+			loader->numFailed++;
+		}
+	}
+	loader->lastUpdateMs = (timeGetSeconds() - startTime) * 1000.;
+	return numUploaded;
+}
+
+uint32_t meshLoaderInFlight(meshLoader_t* loader)
+{
+	return atomic_load_explicit(&loader->numInFlight, memory_order_relaxed);
+}
+
+meshHandle_t meshLoadGet(const meshLoadHandle_t* handle, const meshHandle_t placeholder)
+{
+	return meshLoadGetState(handle) == MESH_LOAD_READY && handle->mesh.id != POOL_NULL ? handle->mesh : placeholder;
+}
+
+meshLoadState_t meshLoadGetState(const meshLoadHandle_t* handle)
+{
+	return (meshLoadState_t) atomic_load_explicit(&handle->state, memory_order_relaxed);
+}
@@ -0,0 +1,88 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+#include "model.h"
+
+#define MESH_LOADER_WORKERS 2 // objLoad already splits big files across threads
+#define MESH_LOADER_BUDGET_MS 2. // Upload time allowed per frame, at least one mesh always goes through
+#define MESH_LOADER_PATH_LENGTH 256
+
+typedef enum meshLoadState_t
+{
+	MESH_LOAD_QUEUED = 0,
+	MESH_LOAD_PARSED, // Waiting for the GL thread
+	MESH_LOAD_READY,
+	MESH_LOAD_FAILED
+} meshLoadState_t;
+
+typedef struct meshLoadHandle_t meshLoadHandle_t;
+
+struct meshLoadHandle_t
+{
+	char filename[MESH_LOADER_PATH_LENGTH];
+	unsigned int flags;
+	_Atomic int state; // meshLoadState_t
+	meshData_t* data; // Set by a worker, freed after uploading
+	meshHandle_t mesh; // Set once ready, the caller owns its reference from then on
+	double queuedSeconds;
+	double parsedSeconds;
+	double readySeconds;
+	meshLoadHandle_t* next; // Job queue, then the finished stack
+	meshLoadHandle_t* nextHandle; // Every handle, for cleanup
+};
+
+// Called on the loader's owner thread for every parsed mesh, sets handle->mesh, false marks it failed
+typedef bool (*meshUploadFunc_t)(meshLoadHandle_t* handle, void* user);
+
+typedef struct meshLoader_t
+{
+	pthread_t workers[MESH_LOADER_WORKERS];
+	uint32_t numWorkers;
+
+	// Jobs, workers sleep on 'wake' while it's empty
+	pthread_mutex_t mutex;
+	pthread_cond_t wake;
+	meshLoadHandle_t* jobHead;
+	meshLoadHandle_t* jobTail;
+	bool quit;
+
+	// Workers push finished handles here lock-free, the owner takes the whole stack at once
+	_Atomic(meshLoadHandle_t*) finished;
+	// Taken off 'finished' but not uploaded yet (the budget ran out), oldest first
+	meshLoadHandle_t* pendingHead;
+	meshLoadHandle_t* pendingTail;
+
+	meshUploadFunc_t upload;
+	void* uploadUser;
+
+	meshLoadHandle_t* handles;
+	_Atomic uint32_t numInFlight; // Queued or parsed but not ready/failed
+	uint32_t numReady;
+	uint32_t numFailed;
+	double lastUpdateMs;
+} meshLoader_t;
+
+// 'upload' NULL uploads with meshCreateFromData (needs a GL context), anything else can run headless
+meshLoader_t* meshLoaderCreate(meshUploadFunc_t upload, void* uploadUser);
+// Stops the workers, frees every handle & any mesh data that was never uploaded, meshes that were are the caller's
+void meshLoaderDestroy(meshLoader_t* loader);
+// Returns straight away, the handle lives until meshLoaderDestroy
+meshLoadHandle_t* meshLoadAsync(meshLoader_t* loader, const char* filename, unsigned int flags);
+// Uploads parsed meshes until 'budgetMs' is used, returns how many became ready
+uint32_t meshLoaderUpdate(meshLoader_t* loader, double budgetMs);
+uint32_t meshLoaderInFlight(meshLoader_t* loader);
+// The loaded mesh, or 'placeholder' until it's ready (or if it failed)
+meshHandle_t meshLoadGet(const meshLoadHandle_t* handle, meshHandle_t placeholder);
+meshLoadState_t meshLoadGetState(const meshLoadHandle_t* handle);
+
+#endif //MESHLOADER_H
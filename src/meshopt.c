@@ -0,0 +1,673 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Vertex cache: https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+ * Overdraw: Sander, Nehab & Barczak - Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "meshopt.h"
+
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_CACHE_DECAY_POWER 1.5f
+#define FORSYTH_LAST_TRIANGLE_SCORE .75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.f
+#define FORSYTH_VALENCE_BOOST_POWER .5f
+
+#define NO_TRIANGLE UINT32_MAX
+
+typedef struct clusterSort_t
+{
+	float key;
+	uint32_t cluster;
+} clusterSort_t;
+
+meshOptCacheStats_t meshOptAnalyzeVertexCache(const uint32_t* indices, const size_t numIndices, const size_t numVertices,
+											  const uint32_t cacheSize)
+{
+	meshOptCacheStats_t stats = {0, 0.f, 0.f};
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	// A vertex is still cached if fewer than 'cacheSize' misses happened since it was loaded
+	uint32_t* timestamps = arenaAllocZero(scratch, (numVertices ? numVertices : 1) * sizeof(uint32_t));
+	uint32_t time = cacheSize + 1;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		const uint32_t vertex = indices[i];
+		if (time - timestamps[vertex] > cacheSize)
+		{
+			timestamps[vertex] = time++;
+			stats.misses++;
+		}
+	}
+
+	size_t referenced = 0;
+	for (size_t i = 0; i < numVertices; i++)
+		referenced += timestamps[i] != 0;
+
+	if (numIndices)
+		stats.acmr = (float) stats.misses / (float) (numIndices / 3);
+	if (referenced)
+		stats.atvr = (float) stats.misses / (float) referenced;
+	arenaRewind(scratchMark);
+	return stats;
+}
+
+static float forsythVertexScore(const int cachePosition, const uint32_t remaining)
+{
+	if (remaining == 0)
+		return -1.f; // Nothing left to draw with this vertex
+
+	float score = 0.f;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+			score = FORSYTH_LAST_TRIANGLE_SCORE; // Fixed score so the triangle just drawn doesn't get favoured
+		else
+		{
+			const float scaler = 1.f / (FORSYTH_CACHE_SIZE - 3);
+			score = powf(1.f - (float) (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+		}
+	}
+	// Boost vertices with few triangles left so lone triangles don't get stranded
+	score += FORSYTH_VALENCE_BOOST_SCALE * powf((float) remaining, -FORSYTH_VALENCE_BOOST_POWER);
+	return score;
+}
+
+void meshOptVertexCache(uint32_t* indices, const size_t numIndices, const size_t numVertices)
+{
+	const size_t numTriangles = numIndices / 3;
+	if (numTriangles == 0)
+		return;
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+
+	// Vertex -> triangle adjacency, each vertex's list is shrunk as its triangles are emitted
+	uint32_t* remaining = arenaAllocZero(scratch, numVertices * sizeof(uint32_t));
+	uint32_t* offsets = arenaAlloc(scratch, numVertices * sizeof(uint32_t));
+	uint32_t* adjacency = arenaAlloc(scratch, numIndices * sizeof(uint32_t));
+	for (size_t i = 0; i < numIndices; i++)
+		remaining[indices[i]]++;
+	uint32_t offset = 0;
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		offsets[i] = offset;
+		offset += remaining[i];
+		remaining[i] = 0;
+	}
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		const uint32_t vertex = indices[i];
+		adjacency[offsets[vertex] + remaining[vertex]++] = (uint32_t) (i / 3);
+	}
+
+	int* cachePositions = arenaAlloc(scratch, numVertices * sizeof(int));
+	float* vertexScores = arenaAlloc(scratch, numVertices * sizeof(float));
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		cachePositions[i] = -1;
+		vertexScores[i] = forsythVertexScore(-1, remaining[i]);
+	}
+
+	float* triangleScores = arenaAlloc(scratch, numTriangles * sizeof(float));
+	bool* emitted = arenaAllocZero(scratch, numTriangles * sizeof(bool));
+	uint32_t* output = arenaAlloc(scratch, numIndices * sizeof(uint32_t));
+
+	uint32_t best = 0;
+	float bestScore = -1.f;
+	for (size_t i = 0; i < numTriangles; i++)
+	{
+		triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+		if (triangleScores[i] > bestScore)
+		{
+			bestScore = triangleScores[i];
+			best = (uint32_t) i;
+		}
+	}
+
+	uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+	uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+	int cacheCount = 0;
+	size_t deadEndCursor = 0;
+
+	for (size_t out = 0; out < numTriangles; out++)
+	{
+		if (best == NO_TRIANGLE)
+		{
+			// Dead end, nothing in the cache has triangles left so continue in input order
+			while (emitted[deadEndCursor])
+				deadEndCursor++;
+			best = (uint32_t) deadEndCursor;
+		}
+
+		const uint32_t* triangle = &indices[best * 3];
+		memcpy(&output[out * 3], triangle, 3 * sizeof(uint32_t));
+		emitted[best] = true;
+
+		for (int i = 0; i < 3; i++)
+		{
+			const uint32_t vertex = triangle[i];
+			uint32_t* list = &adjacency[offsets[vertex]];
+			for (uint32_t j = 0; j < remaining[vertex]; j++)
+			{
+				if (list[j] == best)
+				{
+					list[j] = list[remaining[vertex] - 1];
+					break;
+				}
+			}
+			remaining[vertex]--;
+		}
+
+		// Most recently used first, older entries shift back & fall off the end
+		int newCount = 0;
+		newCache[newCount++] = triangle[0];
+		newCache[newCount++] = triangle[1];
+		newCache[newCount++] = triangle[2];
+		for (int i = 0; i < cacheCount; i++)
+		{
+			const uint32_t vertex = cache[i];
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				newCache[newCount++] = vertex;
+		}
+		if (newCount > FORSYTH_CACHE_SIZE)
+		{
+			for (int i = FORSYTH_CACHE_SIZE; i < newCount; i++)
+			{
+				cachePositions[newCache[i]] = -1;
+				vertexScores[newCache[i]] = forsythVertexScore(-1, remaining[newCache[i]]);
+			}
+			newCount = FORSYTH_CACHE_SIZE;
+		}
+		memcpy(cache, newCache, newCount * sizeof(uint32_t));
+		cacheCount = newCount;
+
+		for (int i = 0; i < cacheCount; i++)
+		{
+			cachePositions[cache[i]] = i;
+			vertexScores[cache[i]] = forsythVertexScore(i, remaining[cache[i]]);
+		}
+
+		// Only triangles touching the cache changed score, pick the best of those
+		best = NO_TRIANGLE;
+		bestScore = -1.f;
+		for (int i = 0; i < cacheCount; i++)
+		{
+			const uint32_t vertex = cache[i];
+			const uint32_t* list = &adjacency[offsets[vertex]];
+			for (uint32_t j = 0; j < remaining[vertex]; j++)
+			{
+				const uint32_t t = list[j];
+				const float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				triangleScores[t] = score;
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+	}
+
+	memcpy(indices, output, numTriangles * 3 * sizeof(uint32_t));
+
+	arenaRewind(scratchMark);
+}
+
+static int compareClusters(const void* a, const void* b)
+{
+	const float keyA = ((const clusterSort_t*) a)->key;
+	const float keyB = ((const clusterSort_t*) b)->key;
+	return keyA < keyB ? 1 : keyA > keyB ? -1 : 0; // Descending, outward facing clusters first
+}
+
+void meshOptOverdraw(uint32_t* indices, const size_t numIndices, const float* positions, const size_t positionStride,
+					 const size_t numVertices, const float threshold)
+{
+	const size_t numTriangles = numIndices / 3;
+	if (numTriangles < 2)
+		return;
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+
+	const meshOptCacheStats_t inputStats = meshOptAnalyzeVertexCache(indices, numIndices, numVertices, MESHOPT_CACHE_SIZE);
+	const float targetAcmr = inputStats.acmr * threshold;
+
+	// Cut wherever the cluster so far, drawn from a cold cache, is within the target ACMR
+	// Clusters can then be drawn in any order without losing more than 'threshold' of the cache efficiency
+	uint32_t* clusterStarts = arenaAlloc(scratch, (numTriangles + 1) * sizeof(uint32_t));
+	uint32_t* timestamps = arenaAllocZero(scratch, numVertices * sizeof(uint32_t));
+	uint32_t time = MESHOPT_CACHE_SIZE + 1;
+	size_t numClusters = 0;
+	size_t clusterStart = 0;
+	uint32_t clusterMisses = 0;
+	clusterStarts[numClusters++] = 0;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			const uint32_t vertex = indices[t * 3 + i];
+			if (time - timestamps[vertex] > MESHOPT_CACHE_SIZE)
+			{
+				timestamps[vertex] = time++;
+				clusterMisses++;
+			}
+		}
+
+		const size_t clusterTriangles = t - clusterStart + 1;
+		if (t + 1 < numTriangles && (float) clusterMisses / (float) clusterTriangles <= targetAcmr)
+		{
+			clusterStart = t + 1;
+			clusterStarts[numClusters++] = (uint32_t) clusterStart;
+			clusterMisses = 0;
+			time += MESHOPT_CACHE_SIZE + 1; // Cold cache for the next cluster
+		}
+	}
+	clusterStarts[numClusters] = (uint32_t) numTriangles;
+
+	// Area weighted mesh centroid
+	float meshCentroid[3] = {0.f, 0.f, 0.f};
+	float meshArea = 0.f;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		const float* a = &positions[indices[t * 3] * positionStride];
+		const float* b = &positions[indices[t * 3 + 1] * positionStride];
+		const float* c = &positions[indices[t * 3 + 2] * positionStride];
+		const float e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+		const float e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+		const float n[3] = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0]};
+		const float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		for (int k = 0; k < 3; k++)
+			meshCentroid[k] += (a[k] + b[k] + c[k]) / 3.f * area;
+		meshArea += area;
+	}
+	if (meshArea > 0.f)
+		for (int k = 0; k < 3; k++)
+			meshCentroid[k] /= meshArea;
+
+	// Sort key is how far the cluster faces away from the centre, those occlude the rest
+	clusterSort_t* sorted = arenaAlloc(scratch, numClusters * sizeof(clusterSort_t));
+	for (size_t cluster = 0; cluster < numClusters; cluster++)
+	{
+		float centroid[3] = {0.f, 0.f, 0.f};
+		float normal[3] = {0.f, 0.f, 0.f};
+		float area = 0.f;
+		for (uint32_t t = clusterStarts[cluster]; t < clusterStarts[cluster + 1]; t++)
+		{
+			const float* a = &positions[indices[t * 3] * positionStride];
+			const float* b = &positions[indices[t * 3 + 1] * positionStride];
+			const float* c = &positions[indices[t * 3 + 2] * positionStride];
+			const float e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+			const float e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+			const float n[3] = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0]};
+			const float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			for (int k = 0; k < 3; k++)
+			{
+				centroid[k] += (a[k] + b[k] + c[k]) / 3.f * triangleArea;
+				normal[k] += n[k];
+			}
+			area += triangleArea;
+		}
+		if (area > 0.f)
+			for (int k = 0; k < 3; k++)
+				centroid[k] /= area;
+		const float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		const float inverseLength = normalLength > 0.f ? 1.f / normalLength : 0.f;
+
+		sorted[cluster].cluster = (uint32_t) cluster;
+		sorted[cluster].key = ((centroid[0] - meshCentroid[0]) * normal[0] +
+							   (centroid[1] - meshCentroid[1]) * normal[1] +
+							   (centroid[2] - meshCentroid[2]) * normal[2]) * inverseLength;
+	}
+	qsort(sorted, numClusters, sizeof(clusterSort_t), compareClusters);
+
+	uint32_t* output = arenaAlloc(scratch, numIndices * sizeof(uint32_t));
+	size_t written = 0;
+	for (size_t i = 0; i < numClusters; i++)
+	{
+		const uint32_t cluster = sorted[i].cluster;
+		const size_t count = (clusterStarts[cluster + 1] - clusterStarts[cluster]) * 3;
+		memcpy(&output[written], &indices[clusterStarts[cluster] * 3], count * sizeof(uint32_t));
+		written += count;
+	}
+	memcpy(indices, output, written * sizeof(uint32_t));
+
+	arenaRewind(scratchMark);
+}
+
+size_t meshOptVertexFetch(float* vertices, const size_t stride, uint32_t* indices, const size_t numIndices,
+						  const size_t numVertices)
+{
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	uint32_t* remap = arenaAlloc(scratch, numVertices * sizeof(uint32_t));
+	memset(remap, 0xFF, numVertices * sizeof(uint32_t));
+
+	uint32_t next = 0;
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		const uint32_t vertex = indices[i];
+		if (remap[vertex] == UINT32_MAX)
+			remap[vertex] = next++;
+		indices[i] = remap[vertex];
+	}
+
+	float* original = arenaAlloc(scratch, numVertices * stride * sizeof(float));
+	memcpy(original, vertices, numVertices * stride * sizeof(float));
+	for (size_t i = 0; i < numVertices; i++)
+		if (remap[i] != UINT32_MAX)
+			memcpy(&vertices[remap[i] * stride], &original[i * stride], stride * sizeof(float));
+
+	arenaRewind(scratchMark);
+	return next;
+}
+
+typedef struct quadric_t
+{
+	// error(p) = p.A.p + 2 b.p + c, A is symmetric so only 6 entries are stored
+	float a00, a01, a02, a11, a12, a22;
+	float b0, b1, b2;
+	float c;
+	float weight; // Total plane area, dividing by it keeps the error a squared distance
+} quadric_t;
+
+typedef struct collapse_t
+{
+	uint32_t from; // Wedge (index buffer vertex) being removed
+	uint32_t to;
+	float error;
+} collapse_t;
+
+static void quadricAddPlane(quadric_t* q, const float n[3], const float d, const float weight)
+{
+	q->a00 += weight * n[0] * n[0];
+	q->a01 += weight * n[0] * n[1];
+	q->a02 += weight * n[0] * n[2];
+	q->a11 += weight * n[1] * n[1];
+	q->a12 += weight * n[1] * n[2];
+	q->a22 += weight * n[2] * n[2];
+	q->b0 += weight * n[0] * d;
+	q->b1 += weight * n[1] * d;
+	q->b2 += weight * n[2] * d;
+	q->c += weight * d * d;
+	q->weight += weight;
+}
+
+static void quadricAdd(quadric_t* q, const quadric_t* other)
+{
+	q->a00 += other->a00;
+	q->a01 += other->a01;
+	q->a02 += other->a02;
+	q->a11 += other->a11;
+	q->a12 += other->a12;
+	q->a22 += other->a22;
+	q->b0 += other->b0;
+	q->b1 += other->b1;
+	q->b2 += other->b2;
+	q->c += other->c;
+	q->weight += other->weight;
+}
+
+static float quadricError(const quadric_t* q, const float* p)
+{
+	const float x = q->a00 * p[0] + q->a01 * p[1] + q->a02 * p[2];
+	const float y = q->a01 * p[0] + q->a11 * p[1] + q->a12 * p[2];
+	const float z = q->a02 * p[0] + q->a12 * p[1] + q->a22 * p[2];
+	const float error = p[0] * x + p[1] * y + p[2] * z + 2.f * (q->b0 * p[0] + q->b1 * p[1] + q->b2 * p[2]) + q->c;
+	return error > 0.f && q->weight > 0.f ? error / q->weight : 0.f;
+}
+
+static void triangleNormal(const float* a, const float* b, const float* c, float n[3])
+{
+	const float e0[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+	const float e1[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+	n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+	n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+	n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+static uint32_t hashPosition(const float* p)
+{
+	uint32_t bits[3];
+	memcpy(bits, p, sizeof(bits));
+	return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+}
+
+static uint64_t edgeKey(const uint32_t a, const uint32_t b)
+{
+	return (uint64_t) a << 32 | b;
+}
+
+static uint64_t hashEdge(const uint64_t key)
+{
+	uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+	return hash ^ hash >> 29;
+}
+
+static int compareCollapses(const void* a, const void* b)
+{
+	const float errorA = ((const collapse_t*) a)->error;
+	const float errorB = ((const collapse_t*) b)->error;
+	return errorA < errorB ? -1 : errorA > errorB ? 1 : 0;
+}
+
+size_t meshOptSimplify(uint32_t* destination, const uint32_t* indices, const size_t numIndices, const float* positions,
+					   const size_t positionStride, const size_t numVertices, const size_t targetIndexCount, float* resultError)
+{
+	*resultError = 0.f;
+	memcpy(destination, indices, numIndices * sizeof(uint32_t));
+	if (numIndices <= targetIndexCount || numVertices == 0)
+		return numIndices;
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+
+	// Wedges sharing a position (uv/normal seams) map to one canonical vertex
+	size_t tableSize = 64;
+	while (tableSize < numVertices * 2)
+		tableSize *= 2;
+	uint32_t* table = arenaAlloc(scratch, tableSize * sizeof(uint32_t));
+	memset(table, 0xFF, tableSize * sizeof(uint32_t));
+	uint32_t* canonical = arenaAlloc(scratch, numVertices * sizeof(uint32_t));
+	uint32_t* wedges = arenaAllocZero(scratch, numVertices * sizeof(uint32_t));
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		const float* p = &positions[v * positionStride];
+		size_t slot = hashPosition(p) & (tableSize - 1);
+		while (table[slot] != UINT32_MAX && memcmp(&positions[table[slot] * positionStride], p, 3 * sizeof(float)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+		if (table[slot] == UINT32_MAX)
+			table[slot] = (uint32_t) v;
+		canonical[v] = table[slot];
+		wedges[canonical[v]]++;
+	}
+
+	// Seams & borders stay put, a border is an edge without its opposite half edge
+	bool* locked = arenaAlloc(scratch, numVertices * sizeof(bool));
+	for (size_t v = 0; v < numVertices; v++)
+		locked[v] = wedges[canonical[v]] > 1;
+
+	size_t edgeTableSize = 64;
+	while (edgeTableSize < numIndices * 2)
+		edgeTableSize *= 2;
+	uint64_t* edges = arenaAlloc(scratch, edgeTableSize * sizeof(uint64_t));
+	uint8_t* edgeCounts = arenaAllocZero(scratch, edgeTableSize * sizeof(uint8_t));
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		const uint32_t a = canonical[indices[i]];
+		const uint32_t b = canonical[indices[i - i % 3 + (i + 1) % 3]];
+		const uint64_t key = edgeKey(a, b);
+		size_t slot = hashEdge(key) & (edgeTableSize - 1);
+		while (edgeCounts[slot] && edges[slot] != key)
+			slot = (slot + 1) & (edgeTableSize - 1);
+		edges[slot] = key;
+		if (edgeCounts[slot] < UINT8_MAX)
+			edgeCounts[slot]++;
+	}
+	for (size_t i = 0; i < numIndices; i++)
+	{
+		const uint32_t a = canonical[indices[i]];
+		const uint32_t b = canonical[indices[i - i % 3 + (i + 1) % 3]];
+		const uint64_t key = edgeKey(b, a);
+		size_t slot = hashEdge(key) & (edgeTableSize - 1);
+		while (edgeCounts[slot] && edges[slot] != key)
+			slot = (slot + 1) & (edgeTableSize - 1);
+
+		// Also lock non-manifold edges (the same half edge more than once)
+		const uint64_t forward = edgeKey(a, b);
+		size_t forwardSlot = hashEdge(forward) & (edgeTableSize - 1);
+		while (edges[forwardSlot] != forward)
+			forwardSlot = (forwardSlot + 1) & (edgeTableSize - 1);
+
+		if (edgeCounts[slot] != 1 || edgeCounts[forwardSlot] != 1)
+			locked[a] = locked[b] = true;
+	}
+
+	quadric_t* quadrics = arenaAllocZero(scratch, numVertices * sizeof(quadric_t));
+	for (size_t i = 0; i < numIndices; i += 3)
+	{
+		const float* a = &positions[indices[i] * positionStride];
+		const float* b = &positions[indices[i + 1] * positionStride];
+		const float* c = &positions[indices[i + 2] * positionStride];
+		float n[3];
+		triangleNormal(a, b, c, n);
+		const float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (area <= 0.f)
+			continue;
+		n[0] /= area;
+		n[1] /= area;
+		n[2] /= area;
+		const float d = -(n[0] * a[0] + n[1] * a[1] + n[2] * a[2]);
+		for (int k = 0; k < 3; k++)
+			quadricAddPlane(&quadrics[canonical[indices[i + k]]], n, d, area);
+	}
+
+	size_t count = numIndices;
+	collapse_t* collapses = arenaAlloc(scratch, numIndices * sizeof(collapse_t));
+	uint32_t* remap = arenaAlloc(scratch, numVertices * sizeof(uint32_t));
+	bool* visited = arenaAlloc(scratch, numVertices * sizeof(bool));
+	uint32_t* adjacencyOffsets = arenaAlloc(scratch, (numVertices + 1) * sizeof(uint32_t));
+	uint32_t* adjacency = arenaAlloc(scratch, numIndices * sizeof(uint32_t));
+	float maxError = 0.f;
+
+	while (count > targetIndexCount)
+	{
+		// Canonical vertex -> triangles
+		memset(adjacencyOffsets, 0, (numVertices + 1) * sizeof(uint32_t));
+		for (size_t i = 0; i < count; i++)
+			adjacencyOffsets[canonical[destination[i]] + 1]++;
+		for (size_t v = 0; v < numVertices; v++)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		for (size_t i = 0; i < count; i++)
+			adjacency[adjacencyOffsets[canonical[destination[i]]]++] = (uint32_t) (i / 3);
+		for (size_t v = numVertices; v > 0; v--)
+			adjacencyOffsets[v] = adjacencyOffsets[v - 1];
+		adjacencyOffsets[0] = 0;
+
+		size_t numCollapses = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint32_t from = destination[i];
+			const uint32_t to = destination[i - i % 3 + (i + 1) % 3];
+			if (locked[from] || canonical[from] == canonical[to])
+				continue;
+			collapses[numCollapses++] = (collapse_t) {
+				from, to, quadricError(&quadrics[canonical[from]], &positions[to * positionStride])
+			};
+		}
+		if (numCollapses == 0)
+			break;
+		qsort(collapses, numCollapses, sizeof(collapse_t), compareCollapses);
+
+		for (size_t v = 0; v < numVertices; v++)
+		{
+			remap[v] = (uint32_t) v;
+			visited[v] = false;
+		}
+
+		size_t applied = 0;
+		size_t removedIndices = 0;
+		// Only the cheapest part of each pass, the quadrics of the rest change as their neighbours collapse
+		const size_t passCollapses = numCollapses / 4 + 1;
+		for (size_t c = 0; c < passCollapses && count - removedIndices > targetIndexCount; c++)
+		{
+			const collapse_t* collapse = &collapses[c];
+			const uint32_t from = canonical[collapse->from];
+			const uint32_t to = canonical[collapse->to];
+			if (visited[from] || visited[to])
+				continue;
+
+			// Reject collapses that flip a triangle
+			const float* target = &positions[collapse->to * positionStride];
+			bool flips = false;
+			size_t removedTriangles = 0;
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1] && !flips; a++)
+			{
+				const uint32_t* triangle = &destination[adjacency[a] * 3];
+				const uint32_t c0 = canonical[triangle[0]], c1 = canonical[triangle[1]], c2 = canonical[triangle[2]];
+				if (c0 == to || c1 == to || c2 == to)
+				{
+					removedTriangles++;
+					continue;
+				}
+
+				const float* p[3];
+				const float* q[3];
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = &positions[triangle[k] * positionStride];
+					q[k] = canonical[triangle[k]] == from ? target : p[k];
+				}
+				float before[3], after[3];
+				triangleNormal(p[0], p[1], p[2], before);
+				triangleNormal(q[0], q[1], q[2], after);
+				const float beforeLength = sqrtf(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+				const float afterLength = sqrtf(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+				const float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+				flips = dot <= .25f * beforeLength * afterLength; // More than ~75 degrees counts as a flip too
+			}
+			if (flips)
+				continue;
+
+			// Lock the whole one ring so the flip check stays valid for the rest of this pass
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++)
+			{
+				const uint32_t* triangle = &destination[adjacency[a] * 3];
+				for (int k = 0; k < 3; k++)
+					visited[canonical[triangle[k]]] = true;
+			}
+			visited[from] = visited[to] = true;
+
+			remap[collapse->from] = collapse->to;
+			quadricAdd(&quadrics[to], &quadrics[from]);
+			if (collapse->error > maxError)
+				maxError = collapse->error;
+			removedIndices += removedTriangles * 3;
+			applied++;
+		}
+		if (applied == 0)
+			break;
+
+		size_t written = 0;
+		for (size_t i = 0; i < count; i += 3)
+		{
+			const uint32_t a = remap[destination[i]];
+			const uint32_t b = remap[destination[i + 1]];
+			const uint32_t c = remap[destination[i + 2]];
+			if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c])
+				continue;
+			destination[written++] = a;
+			destination[written++] = b;
+			destination[written++] = c;
+		}
+		count = written;
+	}
+
+	*resultError = sqrtf(maxError);
+	arenaRewind(scratchMark);
+	return count;
+}
@@ -0,0 +1,42 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Index/vertex reordering passes, all of them work on cpu data only
+ */
+
+#ifndef MESHOPT_H
+#define MESHOPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MESHOPT_CACHE_SIZE 16 // FIFO size used for the statistics, roughly what current GPUs reuse per batch
+
+typedef struct meshOptCacheStats_t
+{
+	uint32_t misses;
+	float acmr; // Average cache miss ratio, misses per triangle (0.5 best, 3 worst)
+	float atvr; // Average transformed vertex ratio, misses per referenced vertex (1 best)
+} meshOptCacheStats_t;
+
+// Simulates a FIFO post-transform cache of 'cacheSize' entries
+meshOptCacheStats_t meshOptAnalyzeVertexCache(const uint32_t* indices, size_t numIndices, size_t numVertices, uint32_t cacheSize);
+
+// Reorders triangles for the post-transform cache (Forsyth's linear speed algorithm)
+void meshOptVertexCache(uint32_t* indices, size_t numIndices, size_t numVertices);
+
+// Splits the cache optimized order into clusters & sorts them outside-in to reduce overdraw (Tipsify style)
+// 'threshold' is how much worse than the input ACMR the result may get, 1.05 keeps 95% of the cache gain
+void meshOptOverdraw(uint32_t* indices, size_t numIndices, const float* positions, size_t positionStride, size_t numVertices,
+					 float threshold);
+
+// Reorders vertices by first use so fetches walk memory linearly, unreferenced vertices are dropped
+// 'vertices' holds 'stride' floats per vertex, returns the new vertex count
+size_t meshOptVertexFetch(float* vertices, size_t stride, uint32_t* indices, size_t numIndices, size_t numVertices);
+
+// Quadric error edge collapse (Garland & Heckbert), vertices only ever collapse onto existing ones so no new vertices are needed
+// Attribute seams & open borders are locked, writes to 'destination' (numIndices big) & returns the new index count
+// 'resultError' receives the largest collapse error as a distance in model units
+size_t meshOptSimplify(uint32_t* destination, const uint32_t* indices, size_t numIndices, const float* positions,
+					   size_t positionStride, size_t numVertices, size_t targetIndexCount, float* resultError);
+
+#endif //MESHOPT_H
@@ -3,172 +3,1306 @@
  * Based on: https://github.com/marichardson137/VerletIntegration/blob/main/src/model.c
  */
 
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "model.h"
+#include "arena.h"
+#include "glstate.h"
+#include "meshcache.h"
+#include "meshopt.h"
+#include "objloader.h"
+#include "shader.h"
+#include "util.h"
 
-#define VERTEX_LIMIT 2000
-#define MAX_LINE_LENGTH 50
+array_float_t* buildIndexedOBJ(const objData_t* obj, uint32_t** indices);
+void buildSubmeshesOBJ(meshData_t* data, const objData_t* obj, const char* filename);
+static void setSubmeshes(mesh_t* mesh, const meshSubmesh_t* submeshes, uint32_t numSubmeshes, materialLibrary_t* materials,
+						 const char* materialLibrary);
 
-array_float_t* loadOBJ(const char* filename);
-void processVertex(array_float_t** vertices, char* vertexData[3], vec3 v[], vec3 vt[], vec3 vn[]);
+static void computeBounds(meshData_t* data)
+{
+	glm_vec3_copy((vec3){FLT_MAX, FLT_MAX, FLT_MAX}, data->boundsMin);
+	glm_vec3_copy((vec3){-FLT_MAX, -FLT_MAX, -FLT_MAX}, data->boundsMax);
+	for (uint32_t i = 0; i < data->numVertices; i++)
+	{
+		float* position = &data->vertices->array[i * VERTEX_STRIDE];
+		glm_vec3_minv(data->boundsMin, position, data->boundsMin);
+		glm_vec3_maxv(data->boundsMax, position, data->boundsMax);
+	}
+	if (data->numVertices == 0)
+	{
+		glm_vec3_zero(data->boundsMin);
+		glm_vec3_zero(data->boundsMax);
+	}
+}
 
-mesh_t* meshCreate(const char* filename, const bool instanced)
+meshData_t* meshDataLoadOBJ(const char* filename)
 {
-	mesh_t* mesh = (mesh_t*) malloc(sizeof(mesh_t));
-	mesh->vertices = loadOBJ(filename);
-	mesh->numVertices = mesh->vertices->size / VERTEX_STRIDE;
+	objData_t* obj = objLoad(filename);
+	if (obj == NULL)
+		return NULL;
+
+	meshData_t* data = (meshData_t*) malloc(sizeof(meshData_t));
+	data->vertices = buildIndexedOBJ(obj, &data->indices);
+	data->tangents = NULL;
+	data->gpuVertices = NULL;
+	data->meshlets = NULL;
+	data->numMeshlets = 0;
+	data->materials = NULL;
+	data->maxPositionError = data->maxNormalError = 0.f;
+	data->numVertices = data->vertices->size / VERTEX_STRIDE;
+	data->numIndices = obj->numCorners;
+	data->numLods = 1;
+	data->lods[0] = (meshLod_t) {0, data->numIndices, 0.f};
+	buildSubmeshesOBJ(data, obj, filename);
+	computeBounds(data);
+
+	const double megabytes = (double) obj->fileSize / (1024. * 1024.);
+	const double triangles = (double) (obj->numCorners / 3);
+	printf("Mesh %s parsed (%.0f triangles, %.2f MB in %.2f ms, %.1f MB/s, %.0f triangles/s)\n", filename, triangles,
+		   megabytes, obj->parseSeconds * 1000., megabytes / obj->parseSeconds, triangles / obj->parseSeconds);
+
+	meshDataOptimize(data, filename);
+
+	const size_t unindexedBytes = obj->numCorners * VERTEX_STRIDE * sizeof(float);
+	const size_t indexedBytes = data->numVertices * VERTEX_STRIDE * sizeof(float) +
+		data->numIndices * (meshDataIndexType(data) == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+	printf("Mesh %s indexed (%zu -> %u vertices, %zu -> %zu bytes)\n", filename, obj->numCorners, data->numVertices,
+		   unindexedBytes, indexedBytes);
+	objDestroy(obj);
+
+	// Tangents can still add vertices after optimizing (mirrored uv seams are split), so they go first. Lods & meshlets
+	// only add indices & meshlets count their vertices from the final indices
+	meshDataBuildTangents(data, filename);
+	meshDataBuildLods(data, filename);
+	meshDataBuildMeshlets(data, filename);
+	return data;
+}
+
+meshData_t* meshDataCreate(const float* vertices, const uint32_t numVertices, const char* name)
+{
+	meshData_t* data = calloc(1, sizeof(meshData_t));
+	uint32_t* indices = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+	meshSubmesh_t* submesh = calloc(1, sizeof(meshSubmesh_t));
+	if (data == NULL || indices == NULL || submesh == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh data!\n");
+		exit(EXIT_FAILURE);
+	}
+	data->vertices = array_float_create(numVertices * VERTEX_STRIDE);
+	array_float_push_n(&data->vertices, vertices, numVertices * VERTEX_STRIDE);
+	for (uint32_t i = 0; i < numVertices; i++)
+		indices[i] = i;
+	data->indices = indices;
+	data->numVertices = numVertices;
+	data->numIndices = numVertices;
+	data->numLods = 1;
+	data->lods[0] = (meshLod_t) {0, numVertices, 0.f};
+	submesh->materialIndex = -1;
+	submesh->lods[0] = data->lods[0];
+	data->submeshes = submesh;
+	data->numSubmeshes = 1;
+	computeBounds(data);
+	meshDataBuildTangents(data, name);
+	return data;
+}
+
+void meshDataOptimize(meshData_t* data, const char* name)
+{
+	const meshOptCacheStats_t before = meshOptAnalyzeVertexCache(data->indices, data->numIndices, data->numVertices, MESHOPT_CACHE_SIZE);
+
+	// Per submesh so triangles never move between materials
+	for (uint32_t i = 0; i < data->numSubmeshes; i++)
+	{
+		const meshLod_t* range = &data->submeshes[i].lods[0];
+		meshOptVertexCache(&data->indices[range->firstIndex], range->numIndices, data->numVertices);
+		meshOptOverdraw(&data->indices[range->firstIndex], range->numIndices, data->vertices->array, VERTEX_STRIDE,
+						data->numVertices, 1.05f);
+	}
+	data->numVertices = meshOptVertexFetch(data->vertices->array, VERTEX_STRIDE, data->indices, data->numIndices, data->numVertices);
+	data->vertices->size = data->numVertices * VERTEX_STRIDE;
+
+	data->cacheStats = meshOptAnalyzeVertexCache(data->indices, data->numIndices, data->numVertices, MESHOPT_CACHE_SIZE);
+	printf("Mesh %s optimized (ACMR %.3f -> %.3f, ATVR %.3f -> %.3f)\n", name, before.acmr, data->cacheStats.acmr,
+		   before.atvr, data->cacheStats.atvr);
+}
+
+void meshDataBuildLods(meshData_t* data, const char* name)
+{
+	static const float ratios[MESH_MAX_LODS] = {1.f, .5f, .25f, .125f};
+
+	// Later lods are appended after lod 0, so drop any chain built before
+	const meshLod_t base = data->lods[0];
+	uint32_t largestSubmesh = 1;
+	for (uint32_t s = 0; s < data->numSubmeshes; s++)
+		largestSubmesh = glm_max(largestSubmesh, data->submeshes[s].lods[0].numIndices);
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	uint32_t* lodIndices = arenaAlloc(scratch, largestSubmesh * sizeof(uint32_t));
+	uint32_t* indices = realloc(data->indices, (base.numIndices * (size_t) MESH_MAX_LODS + 1) * sizeof(uint32_t));
+	if (indices == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh lods!\n");
+		exit(EXIT_FAILURE);
+	}
+	data->indices = indices;
+	data->numIndices = base.numIndices;
+	data->numLods = 1;
+
+	// Every lod holds all submeshes back to back, each simplified on its own so materials stay put
+	for (uint32_t i = 1; i < MESH_MAX_LODS; i++)
+	{
+		const uint32_t firstIndex = data->numIndices;
+		float error = 0.f;
+		for (uint32_t s = 0; s < data->numSubmeshes; s++)
+		{
+			meshSubmesh_t* submesh = &data->submeshes[s];
+			const meshLod_t* submeshBase = &submesh->lods[0];
+			const size_t target = (size_t) ((float) (submeshBase->numIndices / 3) * ratios[i]) * 3;
+			float submeshError;
+			const size_t count = meshOptSimplify(lodIndices, &data->indices[submeshBase->firstIndex], submeshBase->numIndices,
+												 data->vertices->array, VERTEX_STRIDE, data->numVertices, target, &submeshError);
+			meshOptVertexCache(lodIndices, count, data->numVertices);
+			memcpy(&data->indices[data->numIndices], lodIndices, count * sizeof(uint32_t));
+			submesh->lods[i] = (meshLod_t) {data->numIndices, (uint32_t) count, submeshError};
+			data->numIndices += (uint32_t) count;
+			error = glm_max(error, submeshError);
+		}
+
+		// Not worth another lod if it barely shrunk
+		const uint32_t count = data->numIndices - firstIndex;
+		const meshLod_t* previous = &data->lods[data->numLods - 1];
+		if (count == 0 || (float) count > (float) previous->numIndices * .9f)
+		{
+			data->numIndices = firstIndex;
+			break;
+		}
+		data->lods[data->numLods++] = (meshLod_t) {firstIndex, count, error};
+	}
+	arenaRewind(scratchMark);
+
+	printf("Mesh %s lods (%u", name, data->lods[0].numIndices / 3);
+	for (uint32_t i = 1; i < data->numLods; i++)
+		printf(", %u (error %g)", data->lods[i].numIndices / 3, data->lods[i].error);
+	printf(" triangles)\n");
+}
 
-	// Create vao & vbo
-	glCreateVertexArrays(1, &mesh->vao);
-	glBindVertexArray(mesh->vao);
+static void meshletFinish(const meshData_t* data, meshlet_t* meshlet, const uint32_t* vertices, const uint32_t numVertices)
+{
+	// Sphere around the aabb of the meshlet's vertices, tight enough & cheap
+	vec3 min = {FLT_MAX, FLT_MAX, FLT_MAX}, max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for (uint32_t i = 0; i < numVertices; i++)
+	{
+		float* position = &data->vertices->array[vertices[i] * VERTEX_STRIDE];
+		glm_vec3_minv(min, position, min);
+		glm_vec3_maxv(max, position, max);
+	}
+	glm_vec3_center(min, max, meshlet->center);
+	meshlet->radius = 0.f;
+	for (uint32_t i = 0; i < numVertices; i++)
+	{
+		const float distance = glm_vec3_distance(meshlet->center, &data->vertices->array[vertices[i] * VERTEX_STRIDE]);
+		meshlet->radius = glm_max(meshlet->radius, distance);
+	}
+
+	// Cone axis is the average face normal, the cutoff comes from the widest normal around it
+	vec3 normals[MESHLET_MAX_TRIANGLES];
+	const uint32_t numTriangles = meshlet->numIndices / 3;
+	glm_vec3_zero(meshlet->coneAxis);
+	for (uint32_t t = 0; t < numTriangles; t++)
+	{
+		const uint32_t* triangle = &data->indices[meshlet->firstIndex + t * 3];
+		vec3 e0, e1;
+		glm_vec3_sub(&data->vertices->array[triangle[1] * VERTEX_STRIDE], &data->vertices->array[triangle[0] * VERTEX_STRIDE], e0);
+		glm_vec3_sub(&data->vertices->array[triangle[2] * VERTEX_STRIDE], &data->vertices->array[triangle[0] * VERTEX_STRIDE], e1);
+		glm_vec3_cross(e0, e1, normals[t]);
+		glm_vec3_normalize(normals[t]);
+		glm_vec3_add(meshlet->coneAxis, normals[t], meshlet->coneAxis);
+	}
+	meshlet->coneCutoff = 1.f;
+	glm_vec3_copy(meshlet->center, meshlet->coneApex);
+	if (glm_vec3_norm2(meshlet->coneAxis) <= 0.f)
+		return;
+	glm_vec3_normalize(meshlet->coneAxis);
+
+	float minDot = 1.f;
+	for (uint32_t t = 0; t < numTriangles; t++)
+	{
+		if (glm_vec3_norm2(normals[t]) > 0.f)
+			minDot = glm_min(minDot, glm_vec3_dot(normals[t], meshlet->coneAxis));
+	}
+	// Past ~84 degrees of spread the cone covers nearly every direction, not worth testing
+	if (minDot <= .1f)
+		return;
+	meshlet->coneCutoff = sqrtf(1.f - minDot * minDot);
+
+	// Apex is pulled back along the axis until it's behind every triangle's plane
+	float apexDistance = 0.f;
+	for (uint32_t t = 0; t < numTriangles; t++)
+	{
+		const float denominator = glm_vec3_dot(normals[t], meshlet->coneAxis);
+		if (denominator <= 0.f)
+			continue;
+		vec3 toCenter;
+		glm_vec3_sub(meshlet->center, &data->vertices->array[data->indices[meshlet->firstIndex + t * 3] * VERTEX_STRIDE], toCenter);
+		apexDistance = glm_max(apexDistance, glm_vec3_dot(toCenter, normals[t]) / denominator);
+	}
+	glm_vec3_scale(meshlet->coneAxis, -apexDistance, meshlet->coneApex);
+	glm_vec3_add(meshlet->center, meshlet->coneApex, meshlet->coneApex);
+}
+
+void meshDataBuildMeshlets(meshData_t* data, const char* name)
+{
+	const meshLod_t* lod = &data->lods[0];
+	free(data->meshlets);
+	data->numMeshlets = 0;
+	// Worst case every meshlet is cut short by the vertex limit with a single triangle in it
+	data->meshlets = malloc((lod->numIndices / 3 + 1) * sizeof(meshlet_t));
+	if (data->meshlets == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate meshlets!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	uint8_t* used = arenaAllocZero(scratch, data->numVertices);
 
-	glCreateBuffers(1, &mesh->vbo);
+	// The cache optimized order already keeps neighbours together, so a linear scan gives compact meshlets
+	uint32_t vertices[MESHLET_MAX_VERTICES];
+	uint32_t numVertices = 0;
+	meshlet_t meshlet = {.firstIndex = lod->firstIndex};
+	vec3 normalSum = {0.f, 0.f, 0.f};
+	uint32_t submesh = 0;
+	for (uint32_t i = lod->firstIndex; i < lod->firstIndex + lod->numIndices; i += 3)
+	{
+		bool newSubmesh = false;
+		while (submesh + 1 < data->numSubmeshes && i >= data->submeshes[submesh + 1].lods[0].firstIndex)
+		{
+			submesh++;
+			newSubmesh = meshlet.numIndices > 0;
+		}
 
-	glNamedBufferData(mesh->vao, mesh->numVertices * VERTEX_STRIDE * sizeof(float), mesh->vertices->array, GL_STATIC_DRAW);
+		const uint32_t* triangle = &data->indices[i];
+		uint32_t newVertices = !used[triangle[0]];
+		newVertices += !used[triangle[1]] && triangle[1] != triangle[0];
+		newVertices += !used[triangle[2]] && triangle[2] != triangle[0] && triangle[2] != triangle[1];
+		// Also split when the triangle turns away from the meshlet, otherwise the cones end up too wide to cull anything
+		vec3 e0, e1, normal;
+		glm_vec3_sub(&data->vertices->array[triangle[1] * VERTEX_STRIDE], &data->vertices->array[triangle[0] * VERTEX_STRIDE], e0);
+		glm_vec3_sub(&data->vertices->array[triangle[2] * VERTEX_STRIDE], &data->vertices->array[triangle[0] * VERTEX_STRIDE], e1);
+		glm_vec3_cross(e0, e1, normal);
+		glm_vec3_normalize(normal);
+		vec3 axis;
+		glm_vec3_normalize_to(normalSum, axis);
+		const bool turnsAway = meshlet.numIndices / 3 >= MESHLET_MIN_CONE_TRIANGLES && glm_vec3_dot(axis, normal) < MESHLET_CONE_SPLIT;
 
-	glVertexArrayVertexBuffer(mesh->vao, 0, mesh->vbo, 0, VERTEX_STRIDE * sizeof(float));
+		if (numVertices + newVertices > MESHLET_MAX_VERTICES || meshlet.numIndices / 3 >= MESHLET_MAX_TRIANGLES || turnsAway ||
+			newSubmesh)
+		{
+			meshletFinish(data, &meshlet, vertices, numVertices);
+			data->meshlets[data->numMeshlets++] = meshlet;
+			for (uint32_t v = 0; v < numVertices; v++)
+				used[vertices[v]] = 0;
+			numVertices = 0;
+			meshlet = (meshlet_t) {.firstIndex = i};
+			glm_vec3_zero(normalSum);
+		}
+		glm_vec3_add(normalSum, normal, normalSum);
 
-	// position
-	glVertexArrayAttribFormat(mesh->vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexArrayAttribBinding(mesh->vao, 0, 0);
-	// normal
-	glVertexArrayAttribFormat(mesh->vao, 1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
-	glVertexArrayAttribBinding(mesh->vao, 1, 0);
-	// uv
-	glVertexArrayAttribFormat(mesh->vao, 2, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float));
-	glVertexArrayAttribBinding(mesh->vao, 2, 0);
+		for (int k = 0; k < 3; k++)
+		{
+			if (!used[triangle[k]])
+			{
+				used[triangle[k]] = 1;
+				vertices[numVertices++] = triangle[k];
+			}
+		}
+		meshlet.numIndices += 3;
+	}
+	if (meshlet.numIndices > 0)
+	{
+		meshletFinish(data, &meshlet, vertices, numVertices);
+		data->meshlets[data->numMeshlets++] = meshlet;
+	}
+	arenaRewind(scratchMark);
 
-	glEnableVertexArrayAttrib(mesh->vao, 0);
-	glEnableVertexArrayAttrib(mesh->vao, 1);
-	glEnableVertexArrayAttrib(mesh->vao, 2);
+	uint32_t cones = 0;
+	for (uint32_t i = 0; i < data->numMeshlets; i++)
+		cones += data->meshlets[i].coneCutoff < 1.f;
+	printf("Mesh %s meshlets (%u meshlets, %.1f triangles each, %u with a backface cone)\n", name, data->numMeshlets,
+		   data->numMeshlets ? (float) lod->numIndices / 3.f / (float) data->numMeshlets : 0.f, cones);
+}
 
-	if (instanced)
+static uint16_t floatToHalf(const float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const uint32_t sign = (bits >> 16) & 0x8000;
+	const int32_t exponent = (int32_t) ((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return (uint16_t) (sign | 0x7C00 | (mantissa ? 0x200 : 0)); // inf/nan
+	if (exponent >= 31)
+		return (uint16_t) (sign | 0x7C00); // Too big, inf
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return (uint16_t) sign; // Too small, zero
+		// Denormal
+		mantissa |= 0x800000;
+		const uint32_t shift = (uint32_t) (14 - exponent);
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			half++;
+		return (uint16_t) (sign | half);
+	}
+	uint32_t half = sign | (uint32_t) exponent << 10 | mantissa >> 13;
+	if (mantissa & 0x1000)
+		half++; // Round, carrying into the exponent is correct
+	return (uint16_t) half;
+}
+
+static void* allocVertices(const uint32_t numVertices, const size_t size)
+{
+	void* vertices = malloc(numVertices ? numVertices * size : 1);
+	if (vertices == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate gpu vertices!\n");
+		exit(EXIT_FAILURE);
+	}
+	return vertices;
+}
+
+void meshPackQTangent(const vec3 normal, const vec4 tangent, int16_t packed[3])
+{
+	// Right handed orthonormal basis, the handedness only flips the bitangent so it's stored on the side
+	vec3 n, t, b;
+	glm_vec3_normalize_to((float*) normal, n);
+	glm_vec3_scale(n, glm_vec3_dot(n, (float*) tangent), t);
+	glm_vec3_sub((float*) tangent, t, t);
+	if (glm_vec3_norm2(t) < 1e-12f)
+		glm_vec3_cross(n, fabsf(n[0]) < .9f ? (vec3){1.f, 0.f, 0.f} : (vec3){0.f, 1.f, 0.f}, t);
+	glm_vec3_normalize(t);
+	glm_vec3_cross(n, t, b);
+
+	// Rotation with columns t, b & n to a quaternion (x, y, z, w)
+	float q[4];
+	const float trace = t[0] + b[1] + n[2];
+	if (trace > 0.f)
+	{
+		const float s = sqrtf(trace + 1.f) * 2.f;
+		q[0] = (b[2] - n[1]) / s;
+		q[1] = (n[0] - t[2]) / s;
+		q[2] = (t[1] - b[0]) / s;
+		q[3] = .25f * s;
+	} else if (t[0] > b[1] && t[0] > n[2])
+	{
+		const float s = sqrtf(1.f + t[0] - b[1] - n[2]) * 2.f;
+		q[0] = .25f * s;
+		q[1] = (b[0] + t[1]) / s;
+		q[2] = (n[0] + t[2]) / s;
+		q[3] = (b[2] - n[1]) / s;
+	} else if (b[1] > n[2])
+	{
+		const float s = sqrtf(1.f + b[1] - t[0] - n[2]) * 2.f;
+		q[0] = (b[0] + t[1]) / s;
+		q[1] = .25f * s;
+		q[2] = (n[1] + b[2]) / s;
+		q[3] = (n[0] - t[2]) / s;
+	} else
+	{
+		const float s = sqrtf(1.f + n[2] - t[0] - b[1]) * 2.f;
+		q[0] = (n[0] + t[2]) / s;
+		q[1] = (n[1] + b[2]) / s;
+		q[2] = .25f * s;
+		q[3] = (t[1] - b[0]) / s;
+	}
+
+	// q & -q are the same rotation, so the largest component is always positive & can be rebuilt from the others
+	int largest = 0;
+	for (int i = 1; i < 4; i++)
+		largest = fabsf(q[i]) > fabsf(q[largest]) ? i : largest;
+	const float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+	const float sign = q[largest] < 0.f ? -1.f : 1.f;
+
+	// The rest are within +-1/sqrt(2), stretch them to the full range
+	const int32_t bits[3] = {largest & 1, (largest >> 1) & 1, tangent[3] < 0.f};
+	for (int i = 0, k = 0; i < 4; i++)
+	{
+		if (i == largest)
+			continue;
+		const float value = glm_clamp(q[i] * sign / length * (float) GLM_SQRT2, -1.f, 1.f);
+		const int32_t quantized = (int32_t) lroundf(value * 32767.f);
+		packed[k] = (int16_t) ((quantized & ~1) | bits[k]);
+		k++;
+	}
+}
+
+void meshUnpackQTangent(const int16_t packed[3], vec3 normal, vec4 tangent)
+{
+	const int largest = (packed[0] & 1) | ((packed[1] & 1) << 1);
+	float small[3], sum = 0.f;
+	for (int i = 0; i < 3; i++)
+	{
+		small[i] = (float) packed[i] / 32767.f / (float) GLM_SQRT2;
+		sum += small[i] * small[i];
+	}
+
+	float q[4];
+	for (int i = 0, k = 0; i < 4; i++)
+		q[i] = i == largest ? sqrtf(glm_max(1.f - sum, 0.f)) : small[k++];
+	const float x = q[0], y = q[1], z = q[2], w = q[3];
+	normal[0] = 2.f * (x * z + w * y);
+	normal[1] = 2.f * (y * z - w * x);
+	normal[2] = 1.f - 2.f * (x * x + y * y);
+	tangent[0] = 1.f - 2.f * (y * y + z * z);
+	tangent[1] = 2.f * (x * y + w * z);
+	tangent[2] = 2.f * (x * z - w * y);
+	tangent[3] = packed[2] & 1 ? -1.f : 1.f;
+}
+
+static float angleBetween(const float* a, const float* b)
+{
+	const float cosAngle = glm_clamp(glm_vec3_dot((float*) a, (float*) b), -1.f, 1.f);
+	return acosf(cosAngle) * 180.f / GLM_PI;
+}
+
+void meshDataBuildGpuVertices(meshData_t* data)
+{
+	free(data->gpuVertices);
+	data->gpuVertices = allocVertices(data->numVertices, FLOAT_VERTEX_SIZE);
+	for (uint32_t i = 0; i < data->numVertices; i++)
+	{
+		const float* vertex = &data->vertices->array[i * VERTEX_STRIDE];
+		unsigned char* gpu = &data->gpuVertices[i * FLOAT_VERTEX_SIZE];
+		int16_t qtangent[3];
+		meshPackQTangent(vertex + 3, &data->tangents[i * 4], qtangent);
+		memcpy(gpu, vertex, 3 * sizeof(float));
+		memcpy(gpu + 12, qtangent, sizeof(qtangent));
+		memset(gpu + 18, 0, 2); // Keeps the uv aligned
+		memcpy(gpu + 20, vertex + 6, 2 * sizeof(float));
+	}
+
+	data->layout = (meshLayout_t) {
+		.stride = FLOAT_VERTEX_SIZE,
+		.numAttributes = 3,
+		.attributes = {
+			{0, 3, GL_FLOAT, GL_FALSE, 0}, // position
+			{1, 3, GL_SHORT, GL_FALSE, 12, GL_TRUE}, // qtangent
+			{2, 2, GL_FLOAT, GL_FALSE, 20} // uv
+		}
+	};
+}
+
+// Signed uv area of a triangle, negative if its uvs are mirrored
+static float uvDeterminant(const float* vertices, const uint32_t* triangle)
+{
+	const float* v0 = &vertices[triangle[0] * VERTEX_STRIDE];
+	const float* v1 = &vertices[triangle[1] * VERTEX_STRIDE];
+	const float* v2 = &vertices[triangle[2] * VERTEX_STRIDE];
+	return (v1[6] - v0[6]) * (v2[7] - v0[7]) - (v2[6] - v0[6]) * (v1[7] - v0[7]);
+}
+
+// Vertices used by both mirrored & unmirrored triangles (uv seams on symmetric models) get a copy for the mirrored ones,
+// otherwise the sums cancel & one handedness is wrong across half the vertex's triangles. Returns how many were split
+static uint32_t splitMirroredVertices(meshData_t* data)
+{
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	// Bit 0 if an unmirrored triangle uses the vertex, bit 1 if a mirrored one does, then the copy's index
+	uint32_t* remap = arenaAllocZero(scratch, (size_t) data->numVertices * sizeof(uint32_t));
+
+	const meshLod_t* lod = &data->lods[0];
+	for (uint32_t i = lod->firstIndex; i + 2 < lod->firstIndex + lod->numIndices; i += 3)
+	{
+		const float determinant = uvDeterminant(data->vertices->array, &data->indices[i]);
+		if (fabsf(determinant) < 1e-20f)
+			continue;
+		for (int corner = 0; corner < 3; corner++)
+			remap[data->indices[i + corner]] |= determinant < 0.f ? 2u : 1u;
+	}
+
+	const uint32_t numVertices = data->numVertices;
+	for (uint32_t i = 0; i < numVertices; i++)
+	{
+		if (remap[i] != 3u)
+		{
+			remap[i] = 0;
+			continue;
+		}
+		float vertex[VERTEX_STRIDE]; // Pushing can move the array
+		memcpy(vertex, &data->vertices->array[i * VERTEX_STRIDE], sizeof(vertex));
+		array_float_push_n(&data->vertices, vertex, VERTEX_STRIDE);
+		remap[i] = data->numVertices++;
+	}
+
+	const uint32_t split = data->numVertices - numVertices;
+	// Every lod, simplified triangles go by their own handedness
+	for (uint32_t i = 0; split && i + 2 < data->numIndices; i += 3)
+	{
+		uint32_t* triangle = &data->indices[i];
+		if (uvDeterminant(data->vertices->array, triangle) >= 0.f)
+			continue;
+		for (int corner = 0; corner < 3; corner++)
+			if (remap[triangle[corner]])
+				triangle[corner] = remap[triangle[corner]];
+	}
+	arenaRewind(scratchMark);
+	return split;
+}
+
+void meshDataBuildTangents(meshData_t* data, const char* name)
+{
+	const uint32_t split = splitMirroredVertices(data);
+
+	// Tangent & bitangent sums, every lod shares lod 0's vertices
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	float* sums = arenaAllocZero(scratch, (size_t) data->numVertices * 6 * sizeof(float));
+	free(data->tangents);
+	data->tangents = allocVertices(data->numVertices, 4 * sizeof(float));
+
+	const meshLod_t* lod = &data->lods[0];
+	const float* vertices = data->vertices->array;
+	for (uint32_t i = lod->firstIndex; i + 2 < lod->firstIndex + lod->numIndices; i += 3)
+	{
+		const uint32_t* triangle = &data->indices[i];
+		const float* v0 = &vertices[triangle[0] * VERTEX_STRIDE];
+		const float* v1 = &vertices[triangle[1] * VERTEX_STRIDE];
+		const float* v2 = &vertices[triangle[2] * VERTEX_STRIDE];
+
+		vec3 edge1, edge2;
+		glm_vec3_sub((float*) v1, (float*) v0, edge1);
+		glm_vec3_sub((float*) v2, (float*) v0, edge2);
+		const float du1 = v1[6] - v0[6], dv1 = v1[7] - v0[7];
+		const float du2 = v2[6] - v0[6], dv2 = v2[7] - v0[7];
+		const float determinant = uvDeterminant(vertices, triangle);
+		if (fabsf(determinant) < 1e-20f)
+			continue; // No uv area, the vertex keeps whatever its other triangles give it
+
+		// Face tangent & bitangent are normalized so only the corner angles weight them, like mikktspace
+		vec3 tangent, bitangent, scaled;
+		glm_vec3_scale(edge1, dv2, tangent);
+		glm_vec3_scale(edge2, dv1, scaled);
+		glm_vec3_sub(tangent, scaled, tangent);
+		glm_vec3_scale(edge2, du1, bitangent);
+		glm_vec3_scale(edge1, du2, scaled);
+		glm_vec3_sub(bitangent, scaled, bitangent);
+		glm_vec3_scale(tangent, determinant < 0.f ? -1.f : 1.f, tangent);
+		glm_vec3_scale(bitangent, determinant < 0.f ? -1.f : 1.f, bitangent);
+		glm_vec3_normalize(tangent);
+		glm_vec3_normalize(bitangent);
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const float* p = &vertices[triangle[corner] * VERTEX_STRIDE];
+			const float* a = &vertices[triangle[(corner + 1) % 3] * VERTEX_STRIDE];
+			const float* b = &vertices[triangle[(corner + 2) % 3] * VERTEX_STRIDE];
+			vec3 toA, toB;
+			glm_vec3_sub((float*) a, (float*) p, toA);
+			glm_vec3_sub((float*) b, (float*) p, toB);
+			glm_vec3_normalize(toA);
+			glm_vec3_normalize(toB);
+			const float angle = acosf(glm_clamp(glm_vec3_dot(toA, toB), -1.f, 1.f));
+
+			float* sum = &sums[triangle[corner] * 6];
+			glm_vec3_muladds(tangent, angle, sum);
+			glm_vec3_muladds(bitangent, angle, sum + 3);
+		}
+	}
+
+	// Gram-Schmidt against the normal, handedness from which side the bitangent ended up on
+	uint32_t mirrored = 0;
+	for (uint32_t i = 0; i < data->numVertices; i++)
+	{
+		vec3 normal, projected, bitangent;
+		glm_vec3_normalize_to((float*) &vertices[i * VERTEX_STRIDE + 3], normal);
+		float* tangent = &data->tangents[i * 4];
+		glm_vec3_copy(&sums[i * 6], tangent);
+		glm_vec3_scale(normal, glm_vec3_dot(normal, tangent), projected);
+		glm_vec3_sub(tangent, projected, tangent);
+		if (glm_vec3_norm2(tangent) < 1e-12f)
+			glm_vec3_cross(normal, fabsf(normal[0]) < .9f ? (vec3){1.f, 0.f, 0.f} : (vec3){0.f, 1.f, 0.f}, tangent);
+		glm_vec3_normalize(tangent);
+
+		glm_vec3_cross(normal, tangent, bitangent);
+		tangent[3] = glm_vec3_dot(bitangent, &sums[i * 6 + 3]) < 0.f ? -1.f : 1.f;
+		mirrored += tangent[3] < 0.f;
+	}
+	arenaRewind(scratchMark);
+
+	meshDataBuildGpuVertices(data);
+	printf("Mesh %s tangents (%u vertices, %u mirrored, %u split)\n", name, data->numVertices, mirrored, split);
+}
+
+void meshDataPack(meshData_t* data, const char* name)
+{
+	free(data->gpuVertices);
+	data->gpuVertices = allocVertices(data->numVertices, PACKED_VERTEX_SIZE);
+
+	vec3 extent;
+	glm_vec3_sub(data->boundsMax, data->boundsMin, extent);
+
+	data->maxPositionError = data->maxNormalError = 0.f;
+	for (uint32_t i = 0; i < data->numVertices; i++)
+	{
+		const float* vertex = &data->vertices->array[i * VERTEX_STRIDE];
+		unsigned char* packed = &data->gpuVertices[i * PACKED_VERTEX_SIZE];
+
+		uint16_t position[3] = {0, 0, 0};
+		vec3 dequantized;
+		for (int k = 0; k < 3; k++)
+		{
+			const float t = extent[k] > 0.f ? (vertex[k] - data->boundsMin[k]) / extent[k] : 0.f;
+			position[k] = (uint16_t) lroundf(glm_clamp(t, 0.f, 1.f) * 65535.f);
+			dequantized[k] = data->boundsMin[k] + (float) position[k] / 65535.f * extent[k];
+		}
+		const float positionError = glm_vec3_distance((float*) vertex, dequantized);
+		if (positionError > data->maxPositionError)
+			data->maxPositionError = positionError;
+
+		// Measured against the exact frame, so the error covers quantizing & rebuilding the largest component
+		const float* tangent = &data->tangents[i * 4];
+		int16_t qtangent[3];
+		meshPackQTangent(vertex + 3, tangent, qtangent);
+		vec3 normal, decodedNormal;
+		vec4 decodedTangent;
+		meshUnpackQTangent(qtangent, decodedNormal, decodedTangent);
+		glm_vec3_normalize_to((float*) vertex + 3, normal);
+		if (glm_vec3_norm2(normal) > 0.f)
+		{
+			const float normalError = glm_max(angleBetween(normal, decodedNormal), angleBetween(tangent, decodedTangent));
+			if (normalError > data->maxNormalError)
+				data->maxNormalError = normalError;
+		}
+
+		const uint16_t uv[2] = {floatToHalf(vertex[6]), floatToHalf(vertex[7])};
+
+		memcpy(packed, position, sizeof(position));
+		memcpy(packed + 6, qtangent, sizeof(qtangent));
+		memcpy(packed + 12, uv, sizeof(uv));
+	}
+
+	data->layout = (meshLayout_t) {
+		.stride = PACKED_VERTEX_SIZE,
+		.numAttributes = 3,
+		.attributes = {
+			{0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0}, // position
+			{1, 3, GL_SHORT, GL_FALSE, 6, GL_TRUE}, // qtangent
+			{2, 2, GL_HALF_FLOAT, GL_FALSE, 12} // uv
+		}
+	};
+
+	printf("Mesh %s packed (%d -> %d bytes per vertex, max position error %g, max normal/tangent error %.3f degrees)\n",
+		   name, FLOAT_VERTEX_SIZE, PACKED_VERTEX_SIZE, data->maxPositionError, data->maxNormalError);
+}
+
+void meshDataDestroy(meshData_t* data)
+{
+	array_float_delete(data->vertices);
+	free(data->indices);
+	free(data->tangents);
+	free(data->gpuVertices);
+	free(data->meshlets);
+	free(data->submeshes);
+	if (data->materials)
+		materialLibraryDestroy(data->materials);
+	free(data);
+}
+
+const void* meshDataVertices(const meshData_t* data)
+{
+	return data->gpuVertices;
+}
+
+GLenum meshDataIndexType(const meshData_t* data)
+{
+	return data->numVertices <= UINT16_MAX + 1 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+// Parses the obj, packs it if asked & (re)writes the cache
+static meshData_t* meshDataBake(const char* filename, const unsigned int flags, const char* cachePath)
+{
+	meshData_t* data = meshDataLoadOBJ(filename);
+	if (data == NULL)
+		return NULL;
+	if (flags & F_MESH_PACKED)
+		meshDataPack(data, filename);
+	if (!meshCacheWrite(cachePath, filename, data))
+		fprintf(stderr, "Failed to write mesh cache %s\n", cachePath);
+	return data;
+}
+
+meshData_t* meshDataLoad(const char* filename, const unsigned int flags)
+{
+	char cachePath[512];
+	meshCachePath(cachePath, sizeof(cachePath), filename, flags);
+
+	const double startTime = timeGetSeconds();
+	meshData_t* data = meshCacheLoadData(cachePath, filename);
+	if (data)
+		printf("Mesh %s read from cache (%.2f ms)\n", filename, (timeGetSeconds() - startTime) * 1000.);
+	else
+		data = meshDataBake(filename, flags, cachePath);
+
+	if (data && data->materialLibrary[0])
+	{
+		const double decodeStart = timeGetSeconds();
+		data->materials = materialLibraryLoad(data->materialLibrary);
+		if (data->materials)
+		{
+			materialLibraryDecodeTextures(data->materials);
+			printf("Mesh %s materials decoded (%.2f ms)\n", filename, (timeGetSeconds() - decodeStart) * 1000.);
+		}
+	}
+	return data;
+}
+
+mesh_t* meshCreate(const char* filename, const unsigned int flags)
+{
+	char cachePath[512];
+	meshCachePath(cachePath, sizeof(cachePath), filename, flags);
+
+	const double startTime = timeGetSeconds();
+	mesh_t* mesh = meshCacheLoad(cachePath, filename);
+	if (mesh)
+		printf("Mesh %s loaded from cache (%.2f ms)\n", filename, (timeGetSeconds() - startTime) * 1000.);
+	else
+	{
+		meshData_t* data = meshDataBake(filename, flags, cachePath);
+		if (data == NULL)
+		{
+			fprintf(stderr, "Failed to load mesh %s\n", filename);
+			exit(EXIT_FAILURE);
+		}
+
+		mesh = meshCreateFromData(data);
+		meshDataDestroy(data);
+		printf("Mesh %s loaded\n", filename);
+	}
+
+	if (flags & F_MESH_INSTANCED)
 	{
 		// stuff
 	}
+	return mesh;
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+mesh_t* meshCreateFromData(meshData_t* data)
+{
+	mesh_t* mesh;
+	const GLenum indexType = meshDataIndexType(data);
+	if (indexType == GL_UNSIGNED_INT)
+		mesh = meshCreateFromBuffers(&data->layout, data->numVertices, meshDataVertices(data), data->numIndices, indexType,
+									 data->indices, data->lods, data->numLods, data->boundsMin, data->boundsMax);
+	else
+	{
+		uint16_t* indices16 = malloc((data->numIndices ? data->numIndices : 1) * sizeof(uint16_t));
+		if (indices16 == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate mesh indices!\n");
+			exit(EXIT_FAILURE);
+		}
+		for (uint32_t i = 0; i < data->numIndices; i++)
+			indices16[i] = (uint16_t) data->indices[i];
+		mesh = meshCreateFromBuffers(&data->layout, data->numVertices, meshDataVertices(data), data->numIndices, indexType,
+									 indices16, data->lods, data->numLods, data->boundsMin, data->boundsMax);
+		free(indices16);
+	}
+	meshSetMeshlets(mesh, data->meshlets, data->numMeshlets);
+	if (data->materials)
+	{
+		materialLibraryLoadTextures(data->materials);
+		setSubmeshes(mesh, data->submeshes, data->numSubmeshes, data->materials, data->materialLibrary);
+		data->materials = NULL;
+	} else
+		meshSetSubmeshes(mesh, data->submeshes, data->numSubmeshes, data->materialLibrary);
+	return mesh;
+}
 
-	printf("Mesh %s loaded\n", filename);
+mesh_t* meshCreateFromBuffers(const meshLayout_t* layout, const GLsizei numVertices, const void* vertices,
+							  const GLsizei numIndices, const GLenum indexType, const void* indices,
+							  const meshLod_t* lods, const uint32_t numLods, const vec3 boundsMin, const vec3 boundsMax)
+{
+	mesh_t* mesh = (mesh_t*) malloc(sizeof(mesh_t));
+	mesh->numVertices = numVertices;
+	mesh->numIndices = numIndices;
+	mesh->indexType = indexType;
+	if (numLods == 0)
+	{
+		mesh->numLods = 1;
+		mesh->lods[0] = (meshLod_t) {0, (uint32_t) numIndices, 0.f};
+	} else
+	{
+		mesh->numLods = numLods < MESH_MAX_LODS ? numLods : MESH_MAX_LODS;
+		memcpy(mesh->lods, lods, mesh->numLods * sizeof(meshLod_t));
+	}
+	mesh->gltfVertices = false;
+	mesh->numMeshlets = 0;
+	mesh->meshlets = NULL;
+	mesh->numSubmeshes = 0;
+	mesh->submeshes = NULL;
+	mesh->materials = NULL;
+	glm_vec3_copy((float*) boundsMin, mesh->boundsMin);
+	glm_vec3_copy((float*) boundsMax, mesh->boundsMax);
+	glm_vec3_center(mesh->boundsMin, mesh->boundsMax, mesh->center);
+	mesh->radius = glm_vec3_distance(mesh->boundsMin, mesh->boundsMax) * .5f;
+	if (layout->numAttributes > 0 && layout->attributes[0].type == GL_UNSIGNED_SHORT)
+	{
+		glm_vec3_copy(mesh->boundsMin, mesh->positionOffset);
+		glm_vec3_sub(mesh->boundsMax, mesh->boundsMin, mesh->positionScale);
+	} else
+	{
+		glm_vec3_zero(mesh->positionOffset);
+		glm_vec3_copy((vec3){1.f, 1.f, 1.f}, mesh->positionScale);
+	}
+
+	// Sequential indices so hand made vertex lists draw like any other mesh, 16 bit unless they'd wrap
+	void* sequential = NULL;
+	if (indices == NULL)
+	{
+		mesh->indexType = numIndices > 65536 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+		sequential = malloc((numIndices ? numIndices : 1) * (mesh->indexType == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t)));
+		if (sequential == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to allocate mesh indices!\n");
+			exit(EXIT_FAILURE);
+		}
+		for (GLsizei i = 0; i < numIndices; i++)
+		{
+			if (mesh->indexType == GL_UNSIGNED_INT)
+				((uint32_t*) sequential)[i] = (uint32_t) i;
+			else
+				((uint16_t*) sequential)[i] = (uint16_t) i;
+		}
+		indices = sequential;
+	}
+
+	// Suballocated from the layout's arena, so meshes never own a buffer or vao
+	const size_t indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	mesh->geometry = geometryUpload(layout, (uint32_t) numVertices, vertices, (uint32_t) (numIndices * indexSize), indices);
+	mesh->vao = mesh->geometry.arena->vao;
+	mesh->instancedVao = mesh->geometry.arena->instancedVao;
+	mesh->baseVertex = (GLint) mesh->geometry.vertices.offset;
+	mesh->indexOffset = mesh->geometry.indices.offset;
+	free(sequential);
 	return mesh;
 }
 
+void meshSetMeshlets(mesh_t* mesh, const meshlet_t* meshlets, const uint32_t numMeshlets)
+{
+	free(mesh->meshlets);
+	mesh->meshlets = NULL;
+	mesh->numMeshlets = 0;
+	if (numMeshlets == 0)
+		return;
+
+	mesh->meshlets = malloc(numMeshlets * sizeof(meshlet_t));
+	if (mesh->meshlets == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate meshlets!\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(mesh->meshlets, meshlets, numMeshlets * sizeof(meshlet_t));
+	mesh->numMeshlets = numMeshlets;
+}
+
+// Takes 'materials' (NULL if there's none), 'materialLibrary' is its path for the log
+static void setSubmeshes(mesh_t* mesh, const meshSubmesh_t* submeshes, const uint32_t numSubmeshes,
+						 materialLibrary_t* materials, const char* materialLibrary)
+{
+	free(mesh->submeshes);
+	if (mesh->materials)
+		materialLibraryDestroy(mesh->materials);
+	mesh->submeshes = malloc((numSubmeshes ? numSubmeshes : 1) * sizeof(meshSubmesh_t));
+	if (mesh->submeshes == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate submeshes!\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(mesh->submeshes, submeshes, numSubmeshes * sizeof(meshSubmesh_t));
+	mesh->numSubmeshes = numSubmeshes;
+	mesh->materials = materials;
+
+	for (uint32_t i = 0; i < numSubmeshes; i++)
+	{
+		meshSubmesh_t* submesh = &mesh->submeshes[i];
+		submesh->materialIndex = mesh->materials ? materialLibraryFind(mesh->materials, submesh->material) : -1;
+		if (mesh->materials && submesh->materialIndex < 0 && submesh->material[0])
+			fprintf(stderr, "Material %s not found in %s\n", submesh->material, materialLibrary);
+	}
+}
+
+void meshSetSubmeshes(mesh_t* mesh, const meshSubmesh_t* submeshes, const uint32_t numSubmeshes, const char* materialLibrary)
+{
+	materialLibrary_t* materials = materialLibrary && materialLibrary[0] ? materialLibraryLoad(materialLibrary) : NULL;
+	if (materials)
+		materialLibraryLoadTextures(materials);
+	else if (materialLibrary && materialLibrary[0])
+		fprintf(stderr, "Material library %s is missing\n", materialLibrary);
+	setSubmeshes(mesh, submeshes, numSubmeshes, materials, materialLibrary);
+}
+
 void meshDestroy(mesh_t* mesh)
 {
-	glDeleteVertexArrays(1, &mesh->vao);
-	glDeleteBuffers(1, &mesh->vbo);
-	array_float_delete(mesh->vertices);
+	meshDestroyContents(mesh);
 	free(mesh);
 }
 
-model_t* modelCreate(mesh_t* mesh)
+void meshDestroyContents(mesh_t* mesh)
+{
+	geometryRelease(&mesh->geometry);
+	free(mesh->meshlets);
+	free(mesh->submeshes);
+	if (mesh->materials)
+		materialLibraryDestroy(mesh->materials);
+}
+
+void meshSetUniforms(const mesh_t* mesh, const GLuint shader)
+{
+	// Hashed on the first call, it runs for every draw
+	static uniform_t positionOffset, positionScale;
+	if (positionOffset.hash == 0)
+	{
+		positionOffset = uniformName("u_positionOffset");
+		positionScale = uniformName("u_positionScale");
+	}
+
+	const GLint offsetLocation = shaderGetLocation(shader, positionOffset);
+	const GLint scaleLocation = shaderGetLocation(shader, positionScale);
+	if (mesh)
+	{
+		setUniformLocation3fv(&shader, offsetLocation, (float*) mesh->positionOffset);
+		setUniformLocation3fv(&shader, scaleLocation, (float*) mesh->positionScale);
+	} else
+	{
+		setUniformLocation3f(&shader, offsetLocation, 0.f, 0.f, 0.f);
+		setUniformLocation3f(&shader, scaleLocation, 1.f, 1.f, 1.f);
+	}
+}
+
+void meshGetWorldSphere(const mesh_t* mesh, const mat4 model, vec3 center, float* radius)
+{
+	glm_mat4_mulv3((vec4*) model, (float*) mesh->center, 1.f, center);
+	const float scale = glm_max(glm_vec3_norm((float*) model[0]), glm_max(glm_vec3_norm((float*) model[1]),
+																		  glm_vec3_norm((float*) model[2])));
+	*radius = mesh->radius * scale;
+}
+
+bool meshInFrustum(const mesh_t* mesh, const mat4 model, const camera_t* camera)
+{
+	vec3 center;
+	float radius;
+	meshGetWorldSphere(mesh, model, center, &radius);
+	return frustumTestSphere(&camera->frustum, center, radius);
+}
+
+uint32_t meshSelectLod(const mesh_t* mesh, const mat4 model, const camera_t* camera, const float viewportHeight,
+					   const float pixelError)
+{
+	vec3 center;
+	float radius;
+	meshGetWorldSphere(mesh, model, center, &radius);
+	const float scale = radius / glm_max(mesh->radius, FLT_EPSILON);
+
+	// Distance to the nearest point of the bounding sphere, inside it everything is full detail
+	const float distance = glm_vec3_distance(center, (float*) camera->position) - radius;
+	if (distance <= camera->near)
+		return 0;
+
+	// World units to pixels at that distance
+	const float pixelsPerUnit = viewportHeight * .5f / (distance * tanf(glm_rad(camera->fov) * .5f));
+	uint32_t lod = 0;
+	while (lod + 1 < mesh->numLods && mesh->lods[lod + 1].error * scale * pixelsPerUnit <= pixelError)
+		lod++;
+	return lod;
+}
+
+static inline const void* meshIndexPointer(const mesh_t* mesh, const uint32_t firstIndex)
+{
+	const size_t indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	return (const void*) (mesh->indexOffset + firstIndex * indexSize);
+}
+
+void meshDraw(const mesh_t* mesh)
+{
+	meshDrawLod(mesh, 0);
+}
+
+void meshDrawLod(const mesh_t* mesh, const uint32_t lod)
 {
-	model_t* model = (model_t*) malloc(sizeof(model_t));
-	model->mesh = mesh;
-	model->position[0] = model->position[1] = model->position[2] = 0.f;
-	model->rotation[0] = model->rotation[1] = model->rotation[2] = 0.f;
-	model->scale[0] = model->scale[1] = model->scale[2] = 0.f;
-	model->renderMethod = GL_TRIANGLES;
-	return model;
+	const meshLod_t* range = &mesh->lods[lod < mesh->numLods ? lod : mesh->numLods - 1];
+	glStateBindVertexArray(mesh->vao);
+	glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei) range->numIndices, mesh->indexType, meshIndexPointer(mesh, range->firstIndex),
+							 mesh->baseVertex);
 }
 
-void modelDestroy(model_t* model)
+void meshDrawInstanced(const mesh_t* mesh, const GLsizei instanceCount)
 {
-	meshDestroy(model->mesh);
-	free(model);
+	meshDrawInstancedLod(mesh, 0, instanceCount, 0);
 }
 
-array_float_t* loadOBJ(const char* filename)
+void meshDrawInstancedLod(const mesh_t* mesh, const uint32_t lod, const GLsizei instanceCount, const GLuint baseInstance)
 {
-	// I can use array.h for 'infinite' vertices
-	vec3 v[VERTEX_LIMIT];
-	vec3 vt[VERTEX_LIMIT];
-	vec3 vn[VERTEX_LIMIT];
+	const meshLod_t* range = &mesh->lods[lod < mesh->numLods ? lod : mesh->numLods - 1];
+	glStateBindVertexArray(mesh->instancedVao);
+	glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, (GLsizei) range->numIndices, mesh->indexType,
+												  meshIndexPointer(mesh, range->firstIndex), instanceCount, mesh->baseVertex,
+												  baseInstance);
+}
 
-	int vCount = 0;
-	int vtCount = 0;
-	int vnCount = 0;
+void meshDrawSubmesh(const mesh_t* mesh, const uint32_t submesh, const uint32_t lod)
+{
+	const meshSubmesh_t* part = &mesh->submeshes[submesh];
+	const meshLod_t* range = &part->lods[lod < mesh->numLods ? lod : mesh->numLods - 1];
+	glStateBindVertexArray(mesh->vao);
+	glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei) range->numIndices, mesh->indexType, meshIndexPointer(mesh, range->firstIndex),
+							 mesh->baseVertex);
+}
 
-	array_float_t* vertices = array_float_create(3);
-	vertices->capacityIncrement = 3;
-	FILE* file = fopen(filename, "r");
-	if (!file)
+void meshDrawMaterials(const mesh_t* mesh, const uint32_t lod, const GLuint shader, const GLuint normalShader)
+{
+	// Grouped by program so it only changes once
+	for (int normalPass = 0; normalPass < 2; normalPass++)
 	{
-		fprintf(stderr, "Could not open file %s\n", filename);
-		exit(EXIT_FAILURE);
+		const GLuint program = normalPass ? normalShader : shader;
+		for (uint32_t i = 0; i < mesh->numSubmeshes; i++)
+		{
+			const int32_t material = mesh->submeshes[i].materialIndex;
+			const bool normalMapped = material >= 0 && (mesh->materials->materials[material].flags & F_MAT_NORMAL) != 0;
+			if (normalMapped != (normalPass != 0))
+				continue;
+			glStateUseProgram(program);
+			if (material >= 0)
+				materialBind(&mesh->materials->materials[material], program);
+			meshDrawSubmesh(mesh, i, lod);
+		}
 	}
+}
 
-	char line[MAX_LINE_LENGTH];
-	while (fgets(line, MAX_LINE_LENGTH, file) != NULL)
+GLsizei meshCullMeshlets(const meshlet_t* meshlets, const uint32_t numMeshlets, const GLenum indexType, const mat4 model,
+						 const camera_t* camera, GLsizei* counts, const void** offsets)
+{
+	const float scale = glm_vec3_norm((float*) model[0]);
+	const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	GLsizei drawCount = 0;
+	uint32_t rangeEnd = UINT32_MAX;
+	for (uint32_t i = 0; i < numMeshlets; i++)
 	{
-		char* words[4];
-		words[0] = strtok(line, " ");
-		for (int i = 1; i < 4; i++)
-			words[i] = strtok(NULL, " ");
+		const meshlet_t* meshlet = &meshlets[i];
 
-		if (strcmp(words[0], "v") == 0)
-		{
-			v[vCount][0] = atof(words[1]);
-			v[vCount][1] = atof(words[2]);
-			v[vCount][2] = atof(words[3]);
-			vCount++;
-		} else if (strcmp(words[0], "vt") == 0)
-		{
-			vt[vtCount][0] = atof(words[1]);
-			vt[vtCount][1] = atof(words[2]);
-			vtCount++;
-		} else if (strcmp(words[0], "vn") == 0)
+		vec3 center;
+		glm_mat4_mulv3((vec4*) model, (float*) meshlet->center, 1.f, center);
+		if (!frustumTestSphere(&camera->frustum, center, meshlet->radius * scale))
+			continue;
+
+		if (meshlet->coneCutoff < 1.f)
 		{
-			vn[vnCount][0] = atof(words[1]);
-			vn[vnCount][1] = atof(words[2]);
-			vn[vnCount][2] = atof(words[3]);
-			vnCount++;
-		} else if (strcmp(words[0], "f") == 0)
+			vec3 apex, axis, toApex;
+			glm_mat4_mulv3((vec4*) model, (float*) meshlet->coneApex, 1.f, apex);
+			glm_mat4_mulv3((vec4*) model, (float*) meshlet->coneAxis, 0.f, axis);
+			glm_vec3_normalize(axis);
+			glm_vec3_sub(apex, (float*) camera->position, toApex);
+			glm_vec3_normalize(toApex);
+			if (glm_vec3_dot(toApex, axis) >= meshlet->coneCutoff)
+				continue;
+		}
+
+		// Neighbouring survivors merge into one draw
+		if (meshlet->firstIndex == rangeEnd)
+			counts[drawCount - 1] += (GLsizei) meshlet->numIndices;
+		else
 		{
-			char* v1[3];
-			char* v2[3];
-			char* v3[3];
+			counts[drawCount] = (GLsizei) meshlet->numIndices;
+			offsets[drawCount] = (const void*) (meshlet->firstIndex * indexSize);
+			drawCount++;
+		}
+		rangeEnd = meshlet->firstIndex + meshlet->numIndices;
+	}
+	return drawCount;
+}
 
-			v1[0] = strtok(words[1], "/");
-			v1[1] = strtok(NULL, "/");
-			v1[2] = strtok(NULL, "/");
-			v2[0] = strtok(words[2], "/");
-			v2[1] = strtok(NULL, "/");
-			v2[2] = strtok(NULL, "/");
-			v3[0] = strtok(words[3], "/");
-			v3[1] = strtok(NULL, "/");
-			v3[2] = strtok(NULL, "/");
+void meshDrawMeshlets(const mesh_t* mesh, const GLsizei* counts, const void* const* offsets, const GLsizei drawCount,
+					  arena_t* arena)
+{
+	if (drawCount == 0)
+		return;
+	// Culling gives offsets relative to the mesh, rebase them into the arena
+	const void** arenaOffsets = arenaAlloc(arena, (size_t) drawCount * sizeof(void*));
+	GLint* baseVertices = arenaAlloc(arena, (size_t) drawCount * sizeof(GLint));
+	for (GLsizei i = 0; i < drawCount; i++)
+	{
+		arenaOffsets[i] = (const char*) offsets[i] + mesh->indexOffset;
+		baseVertices[i] = mesh->baseVertex;
+	}
 
-			processVertex(&vertices, v1, v, vt, vn);
-			processVertex(&vertices, v2, v, vt, vn);
-			processVertex(&vertices, v3, v, vt, vn);
+	glStateBindVertexArray(mesh->vao);
+	glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts, mesh->indexType, (const void* const*) arenaOffsets, drawCount,
+								  baseVertices);
+}
+
+static uint32_t findSubmesh(meshData_t* data, const char* material)
+{
+	for (uint32_t i = 0; i < data->numSubmeshes; i++)
+	{
+		if (strcmp(data->submeshes[i].material, material) == 0)
+			return i;
+	}
+
+	meshSubmesh_t* submeshes = realloc(data->submeshes, (data->numSubmeshes + 1) * sizeof(meshSubmesh_t));
+	if (submeshes == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate submeshes!\n");
+		exit(EXIT_FAILURE);
+	}
+	data->submeshes = submeshes;
+	meshSubmesh_t* submesh = &data->submeshes[data->numSubmeshes];
+	memset(submesh, 0, sizeof(meshSubmesh_t));
+	snprintf(submesh->material, sizeof(submesh->material), "%s", material);
+	submesh->materialIndex = -1;
+	return data->numSubmeshes++;
+}
+
+// Sorts the triangles by material, in order of first use, with one submesh per material
+void buildSubmeshesOBJ(meshData_t* data, const objData_t* obj, const char* filename)
+{
+	// mtllib is relative to the obj
+	data->materialLibrary[0] = '\0';
+	if (obj->materialLibrary[0])
+	{
+		const char* slash = strrchr(filename, '/');
+		const char* backslash = strrchr(filename, '\\');
+		if (backslash > slash)
+			slash = backslash;
+		const int directoryLength = slash ? (int) (slash - filename + 1) : 0;
+		if (snprintf(data->materialLibrary, sizeof(data->materialLibrary), "%.*s%s", directoryLength, filename,
+					 obj->materialLibrary) >= (int) sizeof(data->materialLibrary))
+		{
+			fprintf(stderr, "Material library path of %s is too long, drawing without materials\n", filename);
+			data->materialLibrary[0] = '\0';
 		}
 	}
 
-	fclose(file);
+	data->submeshes = NULL;
+	data->numSubmeshes = 0;
+	const size_t numTriangles = data->numIndices / 3;
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	uint32_t* triangleSubmeshes = arenaAlloc(scratch, numTriangles * sizeof(uint32_t));
+	uint32_t* sorted = arenaAlloc(scratch, (size_t) data->numIndices * sizeof(uint32_t));
 
-	array_float_adjust(&vertices);
-	return vertices;
+	uint32_t current = UINT32_MAX;
+	size_t range = 0;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		while (range < obj->numMaterialRanges && obj->materialRanges[range].firstCorner <= t * 3)
+			current = findSubmesh(data, obj->materialRanges[range++].name);
+		if (current == UINT32_MAX)
+			current = findSubmesh(data, ""); // Before the first usemtl
+		triangleSubmeshes[t] = current;
+	}
+	if (data->numSubmeshes == 0)
+		findSubmesh(data, "");
+
+	// Counting sort keeps the file order within a submesh
+	for (size_t t = 0; t < numTriangles; t++)
+		data->submeshes[triangleSubmeshes[t]].lods[0].numIndices += 3;
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < data->numSubmeshes; i++)
+	{
+		data->submeshes[i].lods[0].firstIndex = offset;
+		offset += data->submeshes[i].lods[0].numIndices;
+		data->submeshes[i].lods[0].numIndices = 0;
+	}
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		meshLod_t* lod = &data->submeshes[triangleSubmeshes[t]].lods[0];
+		memcpy(&sorted[lod->firstIndex + lod->numIndices], &data->indices[t * 3], 3 * sizeof(uint32_t));
+		lod->numIndices += 3;
+	}
+	// Sorted into scratch, so it's copied back over the same sized indices rather than swapping buffers
+	memcpy(data->indices, sorted, (size_t) data->numIndices * sizeof(uint32_t));
+	arenaRewind(scratchMark);
+
+	if (data->numSubmeshes > 1 || data->materialLibrary[0])
+		printf("Mesh %s has %u submeshes (mtllib %s)\n", filename, data->numSubmeshes,
+			   data->materialLibrary[0] ? data->materialLibrary : "none");
+}
+
+static inline uint32_t hashCorner(const objIndex_t* corner)
+{
+	uint32_t hash = (uint32_t) corner->v * 0x9E3779B1u;
+	hash ^= (uint32_t) corner->vt * 0x85EBCA77u + (hash << 6) + (hash >> 2);
+	hash ^= (uint32_t) corner->vn * 0xC2B2AE3Du + (hash << 6) + (hash >> 2);
+	return hash;
 }
 
-void processVertex(array_float_t** vertices, char* vertexData[3], vec3 v[], vec3 vt[], vec3 vn[])
+// Welds face corners sharing the same (v, vt, vn) triple into one vertex
+array_float_t* buildIndexedOBJ(const objData_t* obj, uint32_t** indices)
 {
-	const int vertex = atoi(vertexData[0]) - 1;
-	const int texture = atoi(vertexData[1]) - 1;
-	const int normal = atoi(vertexData[2]) - 1;
+	size_t tableSize = 64;
+	while (tableSize < obj->numCorners * 2)
+		tableSize *= 2;
+	const uint32_t EMPTY = UINT32_MAX;
+	arena_t* scratch = arenaScratch();
+	const arenaMark_t scratchMark = arenaGetMark(scratch);
+	uint32_t* table = arenaAlloc(scratch, tableSize * sizeof(uint32_t)); // Vertex index of the first corner for each slot
+	const objIndex_t** tableCorners = arenaAlloc(scratch, tableSize * sizeof(objIndex_t*));
+	*indices = malloc((obj->numCorners ? obj->numCorners : 1) * sizeof(uint32_t));
+	if (*indices == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate mesh index table!\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(table, 0xFF, tableSize * sizeof(uint32_t));
+
+	// Worst case every corner is unique, shrunk to fit afterward
+	array_float_t* vertices = array_float_create(obj->numCorners * VERTEX_STRIDE);
+	array_float_resize_uninitialized(&vertices, obj->numCorners * VERTEX_STRIDE);
+	uint32_t numVertices = 0;
+	for (size_t i = 0; i < obj->numCorners; i++)
+	{
+		const objIndex_t* corner = &obj->corners[i];
+		size_t slot = hashCorner(corner) & (tableSize - 1);
+		while (table[slot] != EMPTY)
+		{
+			const objIndex_t* other = tableCorners[slot];
+			if (other->v == corner->v && other->vt == corner->vt && other->vn == corner->vn)
+				break;
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] != EMPTY)
+		{
+			(*indices)[i] = table[slot];
+			continue;
+		}
 
-	array_float_push(vertices, v[vertex][0]);
-	array_float_push(vertices, v[vertex][1]);
-	array_float_push(vertices, v[vertex][2]);
+		table[slot] = numVertices;
+		tableCorners[slot] = corner;
+		(*indices)[i] = numVertices;
 
-	array_float_push(vertices, vn[normal][0]);
-	array_float_push(vertices, vn[normal][1]);
-	array_float_push(vertices, vn[normal][2]);
+		float* vertex = &vertices->array[numVertices * VERTEX_STRIDE];
+		memcpy(vertex, &obj->positions[corner->v * 3], 3 * sizeof(float));
 
-	array_float_push(vertices, vt[texture][0]);
-	array_float_push(vertices, vt[texture][1]);
+		if (corner->vn >= 0)
+			memcpy(vertex + 3, &obj->normals[corner->vn * 3], 3 * sizeof(float));
+		else
+			vertex[3] = vertex[4] = vertex[5] = 0.f;
+
+		if (corner->vt >= 0)
+			memcpy(vertex + 6, &obj->uvs[corner->vt * 2], 2 * sizeof(float));
+		else
+			vertex[6] = vertex[7] = 0.f;
+		numVertices++;
+	}
+	vertices->size = numVertices * VERTEX_STRIDE;
+	array_float_adjust(&vertices);
+
+	arenaRewind(scratchMark);
+	return vertices;
 }
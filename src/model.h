@@ -6,34 +6,212 @@
 #define MODEL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <glad/glad.h>
 
 #include <array.h>
 #include <cglm/cglm.h>
 
+#include "arena.h"
+#include "camera.h"
+#include "geometry.h"
+#include "material.h"
+#include "meshopt.h"
+#include "pool.h"
+
 #define VERTEX_STRIDE 8
+#define FLOAT_VERTEX_SIZE 28 // Float position & uv, qtangent
+#define PACKED_VERTEX_SIZE 16
+#define MESH_MAX_ATTRIBUTES 4
+#define MESH_MAX_LODS 4 // 100, 50, 25 & 12.5% of the triangles
+#define MESH_LOD_PIXEL_ERROR 1.f // Default screen space error allowed when picking a lod
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_MIN_CONE_TRIANGLES 8 // Meshlets are never split for their cone before this size
+#define MESHLET_CONE_SPLIT .5f // Cosine between a new triangle & the meshlet's average normal that starts a new meshlet
+
+#define F_MESH_INSTANCED 0x01
+#define F_MESH_PACKED 0x02 // unorm16 position (relative to bounds), qtangent & half float uv
+
+typedef struct meshAttribute_t
+{
+	uint32_t location;
+	uint32_t components;
+	uint32_t type; // GL_FLOAT etc.
+	uint32_t normalized;
+	uint32_t offset;
+	uint32_t integer; // Read as an ivec/uvec (glVertexArrayAttribIFormat), 'normalized' is ignored
+} meshAttribute_t;
+
+typedef struct meshLayout_t
+{
+	uint32_t stride;
+	uint32_t numAttributes;
+	meshAttribute_t attributes[MESH_MAX_ATTRIBUTES];
+} meshLayout_t;
+
+// Range of the shared index buffer, every lod uses the same vertices
+typedef struct meshLod_t
+{
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	float error; // Simplification error in model units, 0 for lod 0
+} meshLod_t;
+
+// Triangles sharing a material, sorted by material & contiguous within every lod
+typedef struct meshSubmesh_t
+{
+	char material[MATERIAL_NAME_LENGTH]; // 'usemtl' name, empty if none
+	int32_t materialIndex; // Into mesh_t's materials, -1 if it has none (only meaningful on a mesh_t)
+	meshLod_t lods[MESH_MAX_LODS]; // This submesh's range of each of the mesh's lods
+} meshSubmesh_t;
+
+// Cluster of lod 0's triangles, meshlets are contiguous, in index buffer order & never span submeshes
+typedef struct meshlet_t
+{
+	uint32_t firstIndex;
+	uint32_t numIndices;
+	vec3 center;
+	float radius;
+	// Backface cone, culled when dot(normalize(apex - eye), axis) >= cutoff
+	vec3 coneApex;
+	vec3 coneAxis;
+	float coneCutoff; // 1 if the triangles face too many ways to ever be culled
+} meshlet_t;
+
+// CPU side mesh, what the obj loader produces & the mesh cache stores
+typedef struct meshData_t
+{
+	meshLayout_t layout;
+	uint32_t numVertices;
+	uint32_t numIndices; // All lods
+	array_float_t* vertices; // Includes position, normal & uv (8 floats), unique per (v, vt, vn)
+	float* tangents; // xyz & handedness per vertex, from meshDataBuildTangents
+	uint32_t* indices;
+	uint32_t numLods;
+	meshLod_t lods[MESH_MAX_LODS];
+	uint32_t numSubmeshes;
+	meshSubmesh_t* submeshes;
+	char materialLibrary[MATERIAL_PATH_LENGTH]; // Path of the obj's mtllib, empty if none
+	materialLibrary_t* materials; // Parsed with its maps decoded by meshDataLoad, meshCreateFromData takes it
+	uint32_t numMeshlets;
+	meshlet_t* meshlets;
+	vec3 boundsMin;
+	vec3 boundsMax;
+	meshOptCacheStats_t cacheStats; // Lod 0, after optimizing
+
+	// What the gpu gets & 'layout' describes, float positions with qtangents unless meshDataPack swapped in the packed ones
+	unsigned char* gpuVertices;
+	float maxPositionError; // In model units
+	float maxNormalError; // In degrees, of the normal & tangent decoded from the qtangent
+} meshData_t;
+
+POOL_HANDLE(meshHandle_t);
+POOL_HANDLE(modelHandle_t);
 
 typedef struct mesh_t
 {
 	GLsizei numVertices;
-	array_float_t* vertices; // Includes position, normal & uv (8 floats)
-	GLuint vao, vbo;
+	GLsizei numIndices; // All lods
+	GLenum indexType; // GL_UNSIGNED_SHORT if every index fits, otherwise GL_UNSIGNED_INT
+	uint32_t numLods;
+	meshLod_t lods[MESH_MAX_LODS];
+	uint32_t numSubmeshes;
+	meshSubmesh_t* submeshes;
+	materialLibrary_t* materials; // NULL if the obj has no mtllib or it's missing, glTF scenes share theirs (see gltf.h)
+	uint32_t numMeshlets;
+	meshlet_t* meshlets; // Kept on the cpu for culling
+	vec3 boundsMin;
+	vec3 boundsMax;
+	// Bounding sphere of the aabb
+	vec3 center;
+	float radius;
+	// position = offset + i_position * scale, identity unless the mesh is packed
+	vec3 positionOffset;
+	vec3 positionScale;
+	// Where the mesh lives in its layout's geometry arena, lods & meshlets stay relative to it
+	geometryRange_t geometry;
+	GLuint vao; // The arena's, shared by every mesh with the same layout
+	GLuint instancedVao; // The arena's instanced one, for meshDrawInstanced
+	GLint baseVertex;
+	size_t indexOffset; // In bytes
+	bool gltfVertices; // In glTF's own layout (see gltf.h) rather than with a qtangent
 } mesh_t;
 
+// Lives in the resources' model pool, see resources.h
 typedef struct model_t
 {
-	mesh_t* mesh;
-	vec3 position;
-	vec3 rotation;
-	vec3 scale;
+	meshHandle_t mesh; // Holds a reference
+	uint32_t transform; // Into whichever transforms_t the owner keeps, world matrices live there
 	GLuint renderMethod;
 } model_t;
 
-mesh_t* meshCreate(const char* filename, bool instanced);
+meshData_t* meshDataLoadOBJ(const char* filename);
+// Hand made triangle list in the 'vertices' layout (position, normal & uv), drawn in order
+meshData_t* meshDataCreate(const float* vertices, uint32_t numVertices, const char* name);
+// meshCreate without the GL part, reads the cache if it's up-to-date, otherwise parses the obj & (re)writes the cache.
+// Also parses the mtllib & decodes its maps so only their upload is left for the GL thread
+meshData_t* meshDataLoad(const char* filename, unsigned int flags);
+// Vertex cache, overdraw & vertex fetch passes, in that order, meshDataLoadOBJ already runs it
+void meshDataOptimize(meshData_t* data, const char* name);
+// Simplifies lod 0 into the rest of the chain, stops early once the mesh won't reduce any further
+void meshDataBuildLods(meshData_t* data, const char* name);
+// Splits lod 0 into meshlets following the optimized triangle order, so the index buffer isn't touched
+void meshDataBuildMeshlets(meshData_t* data, const char* name);
+// Per vertex tangent frames following mikktspace's conventions: angle weighted, orthogonal to the normal with the
+// bitangent's handedness in w, meshDataLoadOBJ already runs it. Vertices shared by mirrored & unmirrored triangles are
+// split first, so it can add vertices
+void meshDataBuildTangents(meshData_t* data, const char* name);
+// Rebuilds 'gpuVertices' in the float layout from 'vertices' & 'tangents', meshDataBuildTangents already calls it
+void meshDataBuildGpuVertices(meshData_t* data);
+// Quantizes to the F_MESH_PACKED layout & measures the error
+void meshDataPack(meshData_t* data, const char* name);
+// Smallest three quaternion of the tangent frame in 3 shorts: x & y's low bits say which component was dropped, z's is
+// the handedness, decodeTangentFrame in the shaders undoes it
+void meshPackQTangent(const vec3 normal, const vec4 tangent, int16_t packed[3]);
+void meshUnpackQTangent(const int16_t packed[3], vec3 normal, vec4 tangent);
+void meshDataDestroy(meshData_t* data);
+GLenum meshDataIndexType(const meshData_t* data);
+const void* meshDataVertices(const meshData_t* data);
+
+// Loads from the mesh cache when it's up-to-date, otherwise parses the obj & (re)writes the cache
+mesh_t* meshCreate(const char* filename, unsigned int flags);
+// Takes 'data->materials' if meshDataLoad set it, otherwise loads the mtllib (see meshSetSubmeshes)
+mesh_t* meshCreateFromData(meshData_t* data);
+// 'numLods' of 0 makes a single lod covering every index, NULL 'indices' draws the vertices in order
+mesh_t* meshCreateFromBuffers(const meshLayout_t* layout, GLsizei numVertices, const void* vertices, GLsizei numIndices,
+							  GLenum indexType, const void* indices, const meshLod_t* lods, uint32_t numLods,
+							  const vec3 boundsMin, const vec3 boundsMax);
+// Copies 'meshlets', they have to describe lod 0 of 'mesh'
+void meshSetMeshlets(mesh_t* mesh, const meshlet_t* meshlets, uint32_t numMeshlets);
+// Copies 'submeshes' & loads 'materialLibrary' (with textures) if it's given & exists, needs a GL context
+void meshSetSubmeshes(mesh_t* mesh, const meshSubmesh_t* submeshes, uint32_t numSubmeshes, const char* materialLibrary);
 void meshDestroy(mesh_t* mesh);
+// Frees what the mesh owns but not the mesh_t itself, for meshes stored by value in a pool
+void meshDestroyContents(mesh_t* mesh);
 
-model_t* modelCreate(mesh_t* mesh);
-void modelDestroy(model_t* model);
+// Sets the position dequantize uniforms, NULL for meshes (or hand made vaos) that aren't packed
+void meshSetUniforms(const mesh_t* mesh, GLuint shader);
+// Bounding sphere after 'model', the radius grows with the largest axis scale
+void meshGetWorldSphere(const mesh_t* mesh, const mat4 model, vec3 center, float* radius);
+bool meshInFrustum(const mesh_t* mesh, const mat4 model, const camera_t* camera);
+// Coarsest lod whose error projects to at most 'pixelError' pixels, 'model' is the mesh's world transform
+uint32_t meshSelectLod(const mesh_t* mesh, const mat4 model, const camera_t* camera, float viewportHeight, float pixelError);
+void meshDraw(const mesh_t* mesh);
+void meshDrawLod(const mesh_t* mesh, uint32_t lod);
+void meshDrawInstanced(const mesh_t* mesh, GLsizei instanceCount);
+void meshDrawSubmesh(const mesh_t* mesh, uint32_t submesh, uint32_t lod);
+// One draw per submesh, binding its material first, submeshes without one use whatever is bound. Submeshes whose material
+// has a normal map are drawn with 'normalShader' after the rest, both programs need the model's uniforms set already
+void meshDrawMaterials(const mesh_t* mesh, uint32_t lod, GLuint shader, GLuint normalShader);
+// Frustum (camera->frustum) & backface cone culling, fills 'counts' & 'offsets' (numMeshlets big each) with the surviving
+// ranges merged, cpu only so it can run without a context, 'model' is assumed to have a uniform scale
+GLsizei meshCullMeshlets(const meshlet_t* meshlets, uint32_t numMeshlets, GLenum indexType, const mat4 model,
+						 const camera_t* camera, GLsizei* counts, const void** offsets);
+// The draws' rebased offsets are allocated from 'arena', a per frame one that's reset after the frame
+void meshDrawMeshlets(const mesh_t* mesh, const GLsizei* counts, const void* const* offsets, GLsizei drawCount,
+					  arena_t* arena);
+void meshDrawInstancedLod(const mesh_t* mesh, uint32_t lod, GLsizei instanceCount, GLuint baseInstance);
 
 #endif //MODEL_H
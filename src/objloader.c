@@ -0,0 +1,530 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "objloader.h"
+#include "util.h"
+
+#define OBJ_MIN_CHUNK_SIZE (1 << 20) // Anything smaller isn't worth a thread
+#define OBJ_MAX_THREADS 64
+
+// Face corners as written in the file, relative (negative) indices can only be resolved once every chunk is counted
+typedef struct objRawCorner_t
+{
+	int32_t index[3]; // v, vt, vn: >0 absolute (1-based), 0 missing, otherwise see 'relative'
+	uint8_t relative; // Bit n set if index[n] is relative to the start of the chunk
+} objRawCorner_t;
+
+typedef struct objBuffer_t
+{
+	char* data;
+	size_t size; // In elements
+	size_t capacity;
+} objBuffer_t;
+
+typedef struct objChunk_t
+{
+	const char* begin;
+	const char* end;
+	bool failed;
+
+	objBuffer_t positions;
+	objBuffer_t uvs;
+	objBuffer_t normals;
+	objBuffer_t corners;
+	objBuffer_t materialRanges; // 'firstCorner' is local to the chunk
+	char materialLibrary[OBJ_PATH_LENGTH];
+
+	// Filled in before merging
+	objData_t* obj;
+	size_t positionOffset;
+	size_t uvOffset;
+	size_t normalOffset;
+	size_t cornerOffset;
+} objChunk_t;
+
+static const double POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static void* bufferPush(objBuffer_t* buffer, const size_t elementSize, const size_t count)
+{
+	if (buffer->size + count > buffer->capacity)
+	{
+		size_t capacity = buffer->capacity ? buffer->capacity * 2 : 1024;
+		while (capacity < buffer->size + count)
+			capacity *= 2;
+		char* data = realloc(buffer->data, capacity * elementSize);
+		if (data == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to grow obj buffer!\n");
+			exit(EXIT_FAILURE);
+		}
+		buffer->data = data;
+		buffer->capacity = capacity;
+	}
+	void* element = buffer->data + buffer->size * elementSize;
+	buffer->size += count;
+	return element;
+}
+
+static inline bool isBlank(const char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool isDigit(const char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char* skipBlank(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p))
+		p++;
+	return p;
+}
+
+static inline const char* skipLine(const char* p, const char* end)
+{
+	const char* newLine = memchr(p, '\n', end - p);
+	return newLine ? newLine + 1 : end;
+}
+
+// Not correctly rounded like strtod, but good to ~1 ulp which is plenty for mesh data
+static const char* parseFloat(const char* p, const char* end, float* value)
+{
+	p = skipBlank(p, end);
+	const char* start = p;
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	for (; p < end && isDigit(*p); p++)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+		} else
+			exponent++;
+	}
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && isDigit(*p); p++)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		p++;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negativeExponent = *p++ == '-';
+		int e = 0;
+		for (; p < end && isDigit(*p); p++)
+			if (e < 10000)
+				e = e * 10 + (*p - '0');
+		exponent += negativeExponent ? -e : e;
+	}
+
+	if (p == start)
+	{
+		*value = 0.f;
+		return p;
+	}
+
+	double result = (double) mantissa;
+	if (exponent < 0)
+		result = exponent >= -22 ? result / POWERS_OF_TEN[-exponent] : result * pow(10., exponent);
+	else if (exponent > 0)
+		result = exponent <= 22 ? result * POWERS_OF_TEN[exponent] : result * pow(10., exponent);
+	*value = (float) (negative ? -result : result);
+	return p;
+}
+
+static const char* parseInt(const char* p, const char* end, int32_t* value)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+	int64_t result = 0;
+	for (; p < end && isDigit(*p); p++)
+		if (result <= INT32_MAX)
+			result = result * 10 + (*p - '0');
+	if (result > INT32_MAX)
+		result = INT32_MAX;
+	*value = (int32_t) (negative ? -result : result);
+	return p;
+}
+
+static void storeIndex(objRawCorner_t* corner, const int n, const int32_t index, const size_t localCount)
+{
+	if (index < 0)
+	{
+		corner->index[n] = (int32_t) localCount + index;
+		corner->relative |= 1 << n;
+	} else
+		corner->index[n] = index;
+}
+
+// Returns NULL on a malformed corner
+static const char* parseCorner(const char* p, const char* end, const objChunk_t* chunk, objRawCorner_t* corner)
+{
+	corner->index[0] = corner->index[1] = corner->index[2] = 0;
+	corner->relative = 0;
+
+	int32_t index;
+	const char* start = p;
+	p = parseInt(p, end, &index);
+	if (p == start || index == 0)
+		return NULL;
+	storeIndex(corner, 0, index, chunk->positions.size / 3);
+
+	if (p < end && *p == '/')
+	{
+		p++;
+		if (p < end && *p != '/')
+		{
+			start = p;
+			p = parseInt(p, end, &index);
+			if (p != start && index != 0)
+				storeIndex(corner, 1, index, chunk->uvs.size / 2);
+		}
+		if (p < end && *p == '/')
+		{
+			p++;
+			start = p;
+			p = parseInt(p, end, &index);
+			if (p != start && index != 0)
+				storeIndex(corner, 2, index, chunk->normals.size / 3);
+		}
+	}
+	return p;
+}
+
+static const char* parseFace(const char* p, const char* end, objChunk_t* chunk)
+{
+	objRawCorner_t first = {0}, previous = {0}, current;
+	int count = 0;
+	while (true)
+	{
+		p = skipBlank(p, end);
+		if (p >= end || *p == '\n' || *p == '\r' || *p == '#')
+			break;
+
+		p = parseCorner(p, end, chunk, &current);
+		if (p == NULL)
+		{
+			chunk->failed = true;
+			return end;
+		}
+
+		// Fan triangulation, handles quads & n-gons
+		if (count == 0)
+			first = current;
+		else if (count >= 2)
+		{
+			objRawCorner_t* triangle = bufferPush(&chunk->corners, sizeof(objRawCorner_t), 3);
+			triangle[0] = first;
+			triangle[1] = previous;
+			triangle[2] = current;
+		}
+		previous = current;
+		count++;
+	}
+	return p;
+}
+
+// Copies the rest of the line without trailing whitespace, names may contain spaces
+static const char* parseName(const char* p, const char* end, char* name, const size_t size)
+{
+	p = skipBlank(p, end);
+	const char* lineEnd = p < end ? memchr(p, '\n', (size_t) (end - p)) : NULL;
+	if (lineEnd == NULL)
+		lineEnd = end;
+	const char* nameEnd = lineEnd;
+	while (nameEnd > p && (isBlank(nameEnd[-1]) || nameEnd[-1] == '\r'))
+		nameEnd--;
+
+	size_t length = (size_t) (nameEnd - p);
+	if (length >= size)
+		length = size - 1;
+	memcpy(name, p, length);
+	name[length] = '\0';
+	return lineEnd;
+}
+
+static inline bool isKeyword(const char* p, const char* end, const char* keyword, const size_t length)
+{
+	return (size_t) (end - p) > length && memcmp(p, keyword, length) == 0 && isBlank(p[length]);
+}
+
+static void* parseChunk(void* arg)
+{
+	objChunk_t* chunk = arg;
+	const char* p = chunk->begin;
+	const char* end = chunk->end;
+
+	while (p < end && !chunk->failed)
+	{
+		p = skipBlank(p, end);
+		if (p + 1 >= end)
+			break;
+
+		if (p[0] == 'v')
+		{
+			if (isBlank(p[1]))
+			{
+				float* position = bufferPush(&chunk->positions, sizeof(float), 3);
+				p = parseFloat(p + 2, end, &position[0]);
+				p = parseFloat(p, end, &position[1]);
+				p = parseFloat(p, end, &position[2]);
+			} else if (p[1] == 't' && p + 2 < end && isBlank(p[2]))
+			{
+				float* uv = bufferPush(&chunk->uvs, sizeof(float), 2);
+				p = parseFloat(p + 3, end, &uv[0]);
+				p = parseFloat(p, end, &uv[1]);
+			} else if (p[1] == 'n' && p + 2 < end && isBlank(p[2]))
+			{
+				float* normal = bufferPush(&chunk->normals, sizeof(float), 3);
+				p = parseFloat(p + 3, end, &normal[0]);
+				p = parseFloat(p, end, &normal[1]);
+				p = parseFloat(p, end, &normal[2]);
+			}
+		} else if (p[0] == 'f' && isBlank(p[1]))
+			p = parseFace(p + 2, end, chunk);
+		else if (isKeyword(p, end, "usemtl", 6))
+		{
+			objMaterialRange_t* range = bufferPush(&chunk->materialRanges, sizeof(objMaterialRange_t), 1);
+			range->firstCorner = chunk->corners.size;
+			p = parseName(p + 7, end, range->name, sizeof(range->name));
+		} else if (isKeyword(p, end, "mtllib", 6) && chunk->materialLibrary[0] == '\0')
+			p = parseName(p + 7, end, chunk->materialLibrary, sizeof(chunk->materialLibrary));
+
+		// Everything else (comments, objects, groups, w components...) is skipped
+		p = skipLine(p, end);
+	}
+	return NULL;
+}
+
+static bool resolveIndex(const objRawCorner_t* raw, const int n, const size_t offset, const size_t count, int32_t* index)
+{
+	int64_t resolved;
+	if (raw->relative & 1 << n)
+		resolved = (int64_t) offset + raw->index[n];
+	else if (raw->index[n] == 0)
+	{
+		*index = -1;
+		return true;
+	} else
+		resolved = (int64_t) raw->index[n] - 1;
+
+	*index = (int32_t) resolved;
+	return resolved >= 0 && resolved < (int64_t) count;
+}
+
+static void* mergeChunk(void* arg)
+{
+	objChunk_t* chunk = arg;
+	objData_t* obj = chunk->obj;
+
+	if (chunk->positions.size)
+		memcpy(obj->positions + chunk->positionOffset, chunk->positions.data, chunk->positions.size * sizeof(float));
+	if (chunk->uvs.size)
+		memcpy(obj->uvs + chunk->uvOffset, chunk->uvs.data, chunk->uvs.size * sizeof(float));
+	if (chunk->normals.size)
+		memcpy(obj->normals + chunk->normalOffset, chunk->normals.data, chunk->normals.size * sizeof(float));
+
+	const objRawCorner_t* raw = (const objRawCorner_t*) chunk->corners.data;
+	objIndex_t* corners = obj->corners + chunk->cornerOffset;
+	for (size_t i = 0; i < chunk->corners.size; i++)
+	{
+		if (!resolveIndex(&raw[i], 0, chunk->positionOffset / 3, obj->numPositions, &corners[i].v) ||
+			!resolveIndex(&raw[i], 1, chunk->uvOffset / 2, obj->numUvs, &corners[i].vt) ||
+			!resolveIndex(&raw[i], 2, chunk->normalOffset / 3, obj->numNormals, &corners[i].vn))
+		{
+			chunk->failed = true;
+			break;
+		}
+	}
+	return NULL;
+}
+
+// Runs 'task' over every chunk, the calling thread takes chunk 0
+static void runChunks(objChunk_t* chunks, const int numChunks, void* (*task)(void*))
+{
+	pthread_t threads[OBJ_MAX_THREADS];
+	bool started[OBJ_MAX_THREADS];
+	for (int i = 1; i < numChunks; i++)
+		started[i] = pthread_create(&threads[i], NULL, task, &chunks[i]) == 0;
+	task(&chunks[0]);
+	for (int i = 1; i < numChunks; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			task(&chunks[i]);
+	}
+}
+
+static void* allocArray(const size_t count, const size_t size)
+{
+	void* array = malloc(count ? count * size : 1);
+	if (array == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate obj data!\n");
+		exit(EXIT_FAILURE);
+	}
+	return array;
+}
+
+objData_t* objLoad(const char* filename)
+{
+	const double startTime = timeGetSeconds();
+
+	mappedFile_t file;
+	if (!fileMap(filename, &file))
+	{
+		fprintf(stderr, "Could not open file %s\n", filename);
+		return NULL;
+	}
+
+	// Split into line aligned chunks
+	int numChunks = (int) (file.size / OBJ_MIN_CHUNK_SIZE);
+	const int threadCount = cpuGetThreadCount();
+	if (numChunks > threadCount)
+		numChunks = threadCount;
+	if (numChunks > OBJ_MAX_THREADS)
+		numChunks = OBJ_MAX_THREADS;
+	if (numChunks < 1)
+		numChunks = 1;
+
+	objChunk_t* chunks = calloc(numChunks, sizeof(objChunk_t));
+	if (chunks == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate obj chunks!\n");
+		exit(EXIT_FAILURE);
+	}
+	const char* fileEnd = file.data + file.size;
+	const char* chunkBegin = file.data;
+	for (int i = 0; i < numChunks; i++)
+	{
+		const char* chunkEnd = i == numChunks - 1 ? fileEnd : file.data + file.size / numChunks * (i + 1);
+		if (chunkEnd < chunkBegin)
+			chunkEnd = chunkBegin;
+		if (chunkEnd < fileEnd)
+			chunkEnd = skipLine(chunkEnd, fileEnd);
+		chunks[i].begin = chunkBegin;
+		chunks[i].end = chunkEnd;
+		chunkBegin = chunkEnd;
+	}
+
+	runChunks(chunks, numChunks, parseChunk);
+
+	objData_t* obj = calloc(1, sizeof(objData_t));
+	if (obj == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate obj data!\n");
+		exit(EXIT_FAILURE);
+	}
+	bool failed = false;
+	size_t numPositionFloats = 0, numUvFloats = 0, numNormalFloats = 0;
+	for (int i = 0; i < numChunks; i++)
+	{
+		failed |= chunks[i].failed;
+		chunks[i].obj = obj;
+		chunks[i].positionOffset = numPositionFloats;
+		chunks[i].uvOffset = numUvFloats;
+		chunks[i].normalOffset = numNormalFloats;
+		chunks[i].cornerOffset = obj->numCorners;
+		numPositionFloats += chunks[i].positions.size;
+		numUvFloats += chunks[i].uvs.size;
+		numNormalFloats += chunks[i].normals.size;
+		obj->numCorners += chunks[i].corners.size;
+	}
+	for (int i = 0; i < numChunks; i++)
+	{
+		obj->numMaterialRanges += chunks[i].materialRanges.size;
+		if (obj->materialLibrary[0] == '\0')
+			memcpy(obj->materialLibrary, chunks[i].materialLibrary, sizeof(obj->materialLibrary));
+	}
+	obj->numPositions = numPositionFloats / 3;
+	obj->numUvs = numUvFloats / 2;
+	obj->numNormals = numNormalFloats / 3;
+
+	if (!failed)
+	{
+		obj->positions = allocArray(numPositionFloats, sizeof(float));
+		obj->uvs = allocArray(numUvFloats, sizeof(float));
+		obj->normals = allocArray(numNormalFloats, sizeof(float));
+		obj->corners = allocArray(obj->numCorners, sizeof(objIndex_t));
+		obj->materialRanges = allocArray(obj->numMaterialRanges, sizeof(objMaterialRange_t));
+
+		// Only a handful of these, not worth a thread
+		size_t numRanges = 0;
+		for (int i = 0; i < numChunks; i++)
+		{
+			const objMaterialRange_t* ranges = (const objMaterialRange_t*) chunks[i].materialRanges.data;
+			for (size_t r = 0; r < chunks[i].materialRanges.size; r++)
+			{
+				obj->materialRanges[numRanges] = ranges[r];
+				obj->materialRanges[numRanges++].firstCorner += chunks[i].cornerOffset;
+			}
+		}
+
+		runChunks(chunks, numChunks, mergeChunk);
+		for (int i = 0; i < numChunks; i++)
+			failed |= chunks[i].failed;
+	}
+
+	for (int i = 0; i < numChunks; i++)
+	{
+		free(chunks[i].positions.data);
+		free(chunks[i].uvs.data);
+		free(chunks[i].normals.data);
+		free(chunks[i].corners.data);
+		free(chunks[i].materialRanges.data);
+	}
+	free(chunks);
+	obj->fileSize = file.size;
+	fileUnmap(&file);
+
+	if (failed)
+	{
+		fprintf(stderr, "Malformed obj file %s\n", filename);
+		objDestroy(obj);
+		return NULL;
+	}
+
+	obj->parseSeconds = timeGetSeconds() - startTime;
+	return obj;
+}
+
+void objDestroy(objData_t* obj)
+{
+	free(obj->positions);
+	free(obj->uvs);
+	free(obj->normals);
+	free(obj->corners);
+	free(obj->materialRanges);
+	free(obj);
+}
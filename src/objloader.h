@@ -0,0 +1,52 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct objIndex_t
+{
+	int32_t v, vt, vn; // 0-based, -1 if the face corner doesn't reference one
+} objIndex_t;
+
+#define OBJ_NAME_LENGTH 64
+#define OBJ_PATH_LENGTH 256
+
+// 'usemtl', applies to every corner up to the next range
+typedef struct objMaterialRange_t
+{
+	size_t firstCorner;
+	char name[OBJ_NAME_LENGTH];
+} objMaterialRange_t;
+
+typedef struct objData_t
+{
+	size_t numPositions;
+	size_t numUvs;
+	size_t numNormals;
+	size_t numCorners; // Always a multiple of 3, polygons are fan triangulated
+
+	float* positions; // 3 floats each
+	float* uvs; // 2 floats each
+	float* normals; // 3 floats each
+	objIndex_t* corners;
+
+	// Corners before the first range have no material, objects & groups ('o' & 'g') don't matter for batching so are skipped
+	size_t numMaterialRanges;
+	objMaterialRange_t* materialRanges;
+	char materialLibrary[OBJ_PATH_LENGTH]; // First 'mtllib' as written in the file, empty if none
+
+	size_t fileSize;
+	double parseSeconds;
+} objData_t;
+
+// Parses a wavefront obj, the file is memory mapped & split into line aligned chunks that are parsed in parallel
+// Returns NULL if the file can't be opened or is malformed
+objData_t* objLoad(const char* filename);
+void objDestroy(objData_t* obj);
+
+#endif //OBJLOADER_H
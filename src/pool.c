@@ -0,0 +1,131 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+static uint32_t makeHandle(const uint32_t index, const uint16_t generation)
+{
+	return ((uint32_t) generation << POOL_INDEX_BITS) | index;
+}
+
+static void* growArray(void* array, const size_t size, const char* name)
+{
+	void* grown = realloc(array, size);
+	if (grown == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to grow %s pool!\n", name);
+		exit(EXIT_FAILURE);
+	}
+	return grown;
+}
+
+static void grow(pool_t* pool)
+{
+	const uint32_t capacity = pool->capacity ? pool->capacity * 2 : POOL_CAPACITY;
+	if (pool->capacity == POOL_MAX_SLOTS)
+	{
+		fprintf(stderr, "%s pool is full! (%u slots)\n", pool->name, POOL_MAX_SLOTS);
+		exit(EXIT_FAILURE);
+	}
+	pool->elements = growArray(pool->elements, capacity * pool->elementSize, pool->name);
+	pool->generations = growArray(pool->generations, capacity * sizeof(uint16_t), pool->name);
+	pool->refCounts = growArray(pool->refCounts, capacity * sizeof(uint32_t), pool->name);
+	pool->freeSlots = growArray(pool->freeSlots, capacity * sizeof(uint32_t), pool->name);
+	pool->capacity = capacity > POOL_MAX_SLOTS ? POOL_MAX_SLOTS : capacity;
+}
+
+// The slot 'handle' points at, or POOL_MAX_SLOTS if it's stale
+static uint32_t resolve(const pool_t* pool, const uint32_t handle)
+{
+	const uint32_t index = handle & (POOL_MAX_SLOTS - 1);
+	if (handle == POOL_NULL || index >= pool->numSlots || pool->refCounts[index] == 0 ||
+		pool->generations[index] != handle >> POOL_INDEX_BITS)
+		return POOL_MAX_SLOTS;
+	return index;
+}
+
+void poolDestroy(pool_t* pool)
+{
+	free(pool->elements);
+	free(pool->generations);
+	free(pool->refCounts);
+	free(pool->freeSlots);
+	pool->elements = NULL;
+	pool->generations = NULL;
+	pool->refCounts = NULL;
+	pool->freeSlots = NULL;
+	pool->capacity = pool->numSlots = pool->numAlive = pool->numFree = 0;
+}
+
+uint32_t poolAdd(pool_t* pool, const void* element)
+{
+	uint32_t index;
+	if (pool->numFree > 0)
+		index = pool->freeSlots[--pool->numFree];
+	else
+	{
+		if (pool->numSlots == pool->capacity)
+			grow(pool);
+		index = pool->numSlots++;
+		pool->generations[index] = 1;
+	}
+	memcpy(pool->elements + index * pool->elementSize, element, pool->elementSize);
+	pool->refCounts[index] = 1;
+	pool->numAlive++;
+	return makeHandle(index, pool->generations[index]);
+}
+
+void* poolGet(const pool_t* pool, const uint32_t handle)
+{
+	const uint32_t index = resolve(pool, handle);
+	return index == POOL_MAX_SLOTS ? NULL : pool->elements + index * pool->elementSize;
+}
+
+bool poolRetain(pool_t* pool, const uint32_t handle)
+{
+	const uint32_t index = resolve(pool, handle);
+	if (index == POOL_MAX_SLOTS)
+	{
+		fprintf(stderr, "Stale %s handle %08x retained!\n", pool->name, handle);
+		return false;
+	}
+	pool->refCounts[index]++;
+	return true;
+}
+
+bool poolRelease(pool_t* pool, const uint32_t handle, void* released)
+{
+	const uint32_t index = resolve(pool, handle);
+	if (index == POOL_MAX_SLOTS)
+	{
+		fprintf(stderr, "Stale %s handle %08x released!\n", pool->name, handle);
+		return false;
+	}
+	if (--pool->refCounts[index] > 0)
+		return false;
+
+	if (released)
+		memcpy(released, pool->elements + index * pool->elementSize, pool->elementSize);
+	// Skips 0 when it wraps, so a recycled slot never hands out POOL_NULL
+	pool->generations[index] = (uint16_t) ((pool->generations[index] + 1) & POOL_GENERATION_MASK);
+	if (pool->generations[index] == 0)
+		pool->generations[index] = 1;
+	pool->freeSlots[pool->numFree++] = index;
+	pool->numAlive--;
+	return true;
+}
+
+void* poolAt(const pool_t* pool, const uint32_t index)
+{
+	return index < pool->numSlots && pool->refCounts[index] > 0 ? pool->elements + index * pool->elementSize : NULL;
+}
+
+uint32_t poolHandleAt(const pool_t* pool, const uint32_t index)
+{
+	return index < pool->numSlots && pool->refCounts[index] > 0 ? makeHandle(index, pool->generations[index]) : POOL_NULL;
+}
@@ -0,0 +1,54 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Generational handle pools, elements are stored by value in one array with a free list of slots
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define POOL_INDEX_BITS 20 // Slot in the low bits, generation in the rest
+#define POOL_MAX_SLOTS (1u << POOL_INDEX_BITS)
+#define POOL_GENERATION_MASK ((1u << (32 - POOL_INDEX_BITS)) - 1)
+#define POOL_NULL 0u // Generations start at 1, so this never matches a slot
+#define POOL_CAPACITY 16 // Initial slots, doubles when full
+
+// Handles of different pools are different structs so they can't be mixed up, {POOL_NULL} is the empty one
+#define POOL_HANDLE(type) typedef struct type { uint32_t id; } type
+
+// Static pools can start out like this, the arrays are allocated on the first add
+#define POOL_INIT(name, type) {name, sizeof(type), 0, 0, 0, NULL, NULL, NULL, NULL, 0}
+
+typedef struct pool_t
+{
+	const char* name; // For the log
+	size_t elementSize;
+	uint32_t capacity;
+	uint32_t numSlots; // Handed out so far, alive or free, iterate up to this with poolAt
+	uint32_t numAlive;
+	unsigned char* elements; // Moves when the pool grows, so pointers from poolGet don't outlive the next add
+	uint16_t* generations; // Bumped when a slot is freed so old handles stop matching
+	uint32_t* refCounts; // 0 for free slots
+	uint32_t* freeSlots; // Reused newest first
+	uint32_t numFree;
+} pool_t;
+
+void poolDestroy(pool_t* pool);
+
+// Copies 'element' into a slot, the handle starts with one reference
+uint32_t poolAdd(pool_t* pool, const void* element);
+// NULL if the handle is stale or POOL_NULL
+void* poolGet(const pool_t* pool, uint32_t handle);
+bool poolRetain(pool_t* pool, uint32_t handle);
+// Drops a reference, returns true if it was the last one after copying the element into 'released' (if not NULL) &
+// freeing the slot, the caller destroys whatever the element owned
+bool poolRelease(pool_t* pool, uint32_t handle, void* released);
+
+// By slot, NULL for free ones
+void* poolAt(const pool_t* pool, uint32_t index);
+uint32_t poolHandleAt(const pool_t* pool, uint32_t index);
+
+#endif //POOL_H
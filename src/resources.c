@@ -0,0 +1,199 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "resources.h"
+#include "glstate.h"
+#include "shader.h"
+
+// Pending shaders have no program yet & draw with their fallback's
+typedef struct resourceShader_t
+{
+	GLuint program;
+	shaderHandle_t fallback;
+} resourceShader_t;
+
+static pool_t meshes = POOL_INIT("mesh", mesh_t);
+static pool_t models = POOL_INIT("model", model_t);
+static pool_t textures = POOL_INIT("texture", GLuint);
+static pool_t shaders = POOL_INIT("shader", resourceShader_t);
+
+meshHandle_t resourcesAddMesh(mesh_t* mesh)
+{
+	if (mesh == NULL)
+		return (meshHandle_t) {POOL_NULL};
+	const meshHandle_t handle = {poolAdd(&meshes, mesh)};
+	free(mesh);
+	return handle;
+}
+
+mesh_t* resourcesGetMesh(const meshHandle_t mesh)
+{
+	return poolGet(&meshes, mesh.id);
+}
+
+meshHandle_t resourcesRetainMesh(const meshHandle_t mesh)
+{
+	return poolRetain(&meshes, mesh.id) ? mesh : (meshHandle_t) {POOL_NULL};
+}
+
+void resourcesReleaseMesh(const meshHandle_t mesh)
+{
+	mesh_t released;
+	if (poolRelease(&meshes, mesh.id, &released))
+		meshDestroyContents(&released);
+}
+
+modelHandle_t resourcesAddModel(const meshHandle_t mesh, const uint32_t transform)
+{
+	const model_t model = {resourcesRetainMesh(mesh), transform, GL_TRIANGLES};
+	return (modelHandle_t) {poolAdd(&models, &model)};
+}
+
+model_t* resourcesGetModel(const modelHandle_t model)
+{
+	return poolGet(&models, model.id);
+}
+
+void resourcesReleaseModel(const modelHandle_t model)
+{
+	model_t released;
+	if (poolRelease(&models, model.id, &released) && released.mesh.id != POOL_NULL)
+		resourcesReleaseMesh(released.mesh);
+}
+
+textureHandle_t resourcesAddTexture(const GLuint texture)
+{
+	return (textureHandle_t) {texture ? poolAdd(&textures, &texture) : POOL_NULL};
+}
+
+GLuint resourcesGetTexture(const textureHandle_t texture)
+{
+	const GLuint* id = poolGet(&textures, texture.id);
+	return id ? *id : 0;
+}
+
+void resourcesReleaseTexture(const textureHandle_t texture)
+{
+	GLuint released;
+	if (poolRelease(&textures, texture.id, &released))
+	{
+		glDeleteTextures(1, &released);
+		glStateReset();
+	}
+}
+
+static void destroyShader(const resourceShader_t* shader)
+{
+	if (shader->program)
+	{
+		uniformTableForget(shader->program);
+		glDeleteProgram(shader->program);
+		glStateReset();
+	}
+}
+
+shaderHandle_t resourcesAddShader(const GLuint program)
+{
+	const resourceShader_t shader = {program, {POOL_NULL}};
+	return (shaderHandle_t) {program ? poolAdd(&shaders, &shader) : POOL_NULL};
+}
+
+shaderHandle_t resourcesAddShaderPending(const shaderHandle_t fallback)
+{
+	const resourceShader_t shader = {0, resourcesRetainShader(fallback)};
+	return (shaderHandle_t) {poolAdd(&shaders, &shader)};
+}
+
+void resourcesSetShaderProgram(const shaderHandle_t shader, const GLuint program)
+{
+	resourceShader_t* entry = poolGet(&shaders, shader.id);
+	if (entry == NULL)
+	{
+		// Nothing will ever delete it otherwise
+		uniformTableForget(program);
+		glDeleteProgram(program);
+		return;
+	}
+	const resourceShader_t old = *entry;
+	entry->program = program;
+	entry->fallback = (shaderHandle_t) {POOL_NULL};
+	destroyShader(&old);
+	if (old.fallback.id != POOL_NULL)
+		resourcesReleaseShader(old.fallback);
+}
+
+GLuint resourcesGetShader(const shaderHandle_t shader)
+{
+	const resourceShader_t* entry = poolGet(&shaders, shader.id);
+	if (entry == NULL)
+		return 0;
+	if (entry->program == 0 && entry->fallback.id != POOL_NULL)
+		return resourcesGetShader(entry->fallback);
+	return entry->program;
+}
+
+shaderHandle_t resourcesRetainShader(const shaderHandle_t shader)
+{
+	return poolRetain(&shaders, shader.id) ? shader : (shaderHandle_t) {POOL_NULL};
+}
+
+void resourcesReleaseShader(const shaderHandle_t shader)
+{
+	resourceShader_t released;
+	if (!poolRelease(&shaders, shader.id, &released))
+		return;
+	destroyShader(&released);
+	if (released.fallback.id != POOL_NULL)
+		resourcesReleaseShader(released.fallback);
+}
+
+const pool_t* resourcesMeshPool()
+{
+	return &meshes;
+}
+
+const pool_t* resourcesModelPool()
+{
+	return &models;
+}
+
+void resourcesDestroyPools()
+{
+	// Models first, they hold mesh references
+	if (models.numAlive > 0 || meshes.numAlive > 0 || textures.numAlive > 0 || shaders.numAlive > 0)
+		printf("Leaked resources: %u models, %u meshes, %u textures, %u shaders\n", models.numAlive, meshes.numAlive,
+			   textures.numAlive, shaders.numAlive);
+	for (uint32_t i = 0; i < models.numSlots; i++)
+	{
+		const model_t* model = poolAt(&models, i);
+		if (model && model->mesh.id != POOL_NULL)
+			resourcesReleaseMesh(model->mesh);
+	}
+	for (uint32_t i = 0; i < meshes.numSlots; i++)
+	{
+		mesh_t* mesh = poolAt(&meshes, i);
+		if (mesh)
+			meshDestroyContents(mesh);
+	}
+	for (uint32_t i = 0; i < textures.numSlots; i++)
+	{
+		const GLuint* texture = poolAt(&textures, i);
+		if (texture)
+			glDeleteTextures(1, texture);
+	}
+	glStateReset();
+	for (uint32_t i = 0; i < shaders.numSlots; i++)
+	{
+		const resourceShader_t* shader = poolAt(&shaders, i);
+		if (shader)
+			destroyShader(shader);
+	}
+	poolDestroy(&models);
+	poolDestroy(&meshes);
+	poolDestroy(&textures);
+	poolDestroy(&shaders);
+}
@@ -0,0 +1,57 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Pools of meshes, models, textures & shaders behind generational handles, reference counted so they can be shared
+ */
+
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include <stdint.h>
+
+#include <glad/glad.h>
+
+#include "model.h"
+#include "pool.h"
+
+POOL_HANDLE(textureHandle_t);
+POOL_HANDLE(shaderHandle_t);
+
+// Takes ownership, the mesh_t is copied into the pool & freed, NULL gives {POOL_NULL}
+meshHandle_t resourcesAddMesh(mesh_t* mesh);
+// NULL for stale handles, pointers are only good until the next mesh is added
+mesh_t* resourcesGetMesh(meshHandle_t mesh);
+// Returns 'mesh' so sharing reads like an assignment
+meshHandle_t resourcesRetainMesh(meshHandle_t mesh);
+// Destroys the mesh once nothing references it
+void resourcesReleaseMesh(meshHandle_t mesh);
+
+// The model holds a reference to 'mesh' until it's released
+modelHandle_t resourcesAddModel(meshHandle_t mesh, uint32_t transform);
+model_t* resourcesGetModel(modelHandle_t model);
+void resourcesReleaseModel(modelHandle_t model);
+
+// Takes ownership of the GL object, 0 gives {POOL_NULL}
+textureHandle_t resourcesAddTexture(GLuint texture);
+// 0 for stale handles
+GLuint resourcesGetTexture(textureHandle_t texture);
+void resourcesReleaseTexture(textureHandle_t texture);
+
+shaderHandle_t resourcesAddShader(GLuint program);
+// For programs still compiling (see shaderBatch_t), holds a reference to 'fallback' & draws with it until
+// resourcesSetShaderProgram
+shaderHandle_t resourcesAddShaderPending(shaderHandle_t fallback);
+// Takes ownership of 'program', replacing (& destroying) whatever the handle had before
+void resourcesSetShaderProgram(shaderHandle_t shader, GLuint program);
+// The fallback's program while pending, 0 for stale handles
+GLuint resourcesGetShader(shaderHandle_t shader);
+shaderHandle_t resourcesRetainShader(shaderHandle_t shader);
+void resourcesReleaseShader(shaderHandle_t shader);
+
+// For iterating a whole kind at once with poolAt
+const pool_t* resourcesMeshPool();
+const pool_t* resourcesModelPool();
+
+// Destroys whatever is still alive (saying how much leaked) & frees the pools
+void resourcesDestroyPools();
+
+#endif //RESOURCES_H
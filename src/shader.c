@@ -4,132 +4,603 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "shader.h"
+#include "glstate.h"
+#include "shadercache.h"
 #include "util.h"
 
-void shaderCompile(GLuint* shader, const GLenum shaderType, const char* shaderFile)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1 // Same value as the ARB one
+#endif
+
+typedef void (APIENTRYP maxShaderCompilerThreadsFunc_t)(GLuint count);
+
+// Set by shaderInitParallelCompile, completion status is only asked for with it
+static maxShaderCompilerThreadsFunc_t maxShaderCompilerThreads = NULL;
+static bool parallelCompile = false;
+
+static GLint lookupLocation(const GLuint program, const char* name)
 {
-	*shader = glCreateShader(shaderType);
-	if (*shader == 0)
-		fprintf(stderr, "Could not load shader: %s\n", shaderFile);
+	return shaderGetLocation(program, uniformName(name));
+}
+
+char* shaderInclude(const char* shaderFile, char* source, const int depth)
+{
+	const char* directive = "#include \"";
+	size_t offset = 0;
+	char* include;
+	while ((include = strstr(source + offset, directive)) != NULL)
+	{
+		offset = include - source;
+		// Only at the start of a line, not in the middle of a comment
+		if (offset > 0 && source[offset - 1] != '\n')
+		{
+			offset++;
+			continue;
+		}
+		if (depth >= SHADER_INCLUDE_DEPTH)
+		{
+			fprintf(stderr, "Shader includes nested too deep: %s\n", shaderFile);
+			exit(-1);
+		}
+
+		const char* name = include + strlen(directive);
+		const char* nameEnd = strchr(name, '"');
+		if (nameEnd == NULL)
+		{
+			fprintf(stderr, "Unterminated #include in shader: %s\n", shaderFile);
+			exit(-1);
+		}
+		const char* slash = strrchr(shaderFile, '/');
+		const int directoryLength = slash ? (int) (slash - shaderFile + 1) : 0;
+		char path[directoryLength + (nameEnd - name) + 1];
+		snprintf(path, sizeof(path), "%.*s%.*s", directoryLength, shaderFile, (int) (nameEnd - name), name);
+		char* included = shaderInclude(path, readFile(path), depth + 1);
+
+		const char* rest = strchr(nameEnd, '\n');
+		rest = rest ? rest : nameEnd + strlen(nameEnd);
+		const size_t includedLength = strlen(included);
+		char* spliced = malloc(offset + includedLength + strlen(rest) + 1);
+		if (spliced == NULL)
+		{
+			fprintf(stderr, "Out of memory! Failed to include %s in %s!\n", path, shaderFile);
+			exit(EXIT_FAILURE);
+		}
+		memcpy(spliced, source, offset);
+		memcpy(spliced + offset, included, includedLength);
+		strcpy(spliced + offset + includedLength, rest);
+		free(source);
+		free(included);
+		source = spliced;
+		// The included text was already expanded
+		offset += includedLength;
+	}
+	return source;
+}
 
-	const char* shaderSource = readFile(shaderFile);
-	glShaderSource(*shader, 1, &shaderSource, NULL);
-	glCompileShader(*shader);
-//	printf("%s\n", shaderSource);
-	free((void*) shaderSource);
+// Printed after a failed compile or link, status checks only happen once the driver is done with it
+static void printShaderLog(const GLuint shader, const char* shaderFile)
+{
+	fprintf(stderr, "Shader compile error: %s\n", shaderFile);
+	GLint logSize = 0;
+	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logSize);
+	char infoBuffer[logSize + 1];
+	infoBuffer[0] = '\0';
+	glGetShaderInfoLog(shader, logSize + 1, NULL, infoBuffer);
+	fprintf(stderr, "%s", infoBuffer);
+}
 
-	GLint isCompiled = 0;
-	glGetShaderiv(*shader, GL_COMPILE_STATUS, &isCompiled);
+static void printProgramLog(const shaderBuild_t* build)
+{
+	fprintf(stderr, "Shader link error: %s, %s%s%s\n", build->files[0], build->files[1], build->numStages > 2 ? ", " : "",
+			build->numStages > 2 ? build->files[2] : "");
+	GLint logSize = 0;
+	glGetProgramiv(build->program, GL_INFO_LOG_LENGTH, &logSize);
+	char infoBuffer[logSize + 1];
+	infoBuffer[0] = '\0';
+	glGetProgramInfoLog(build->program, logSize + 1, NULL, infoBuffer);
+	fprintf(stderr, "%s", infoBuffer);
+}
 
-	if (isCompiled == GL_FALSE)
+bool shaderInitParallelCompile(const GLADloadproc load)
+{
+	bool khr = false, arb = false;
+	GLint numExtensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+	for (GLint i = 0; i < numExtensions; i++)
 	{
-		fprintf(stderr, "Shader compile error: %s\n", shaderFile);
+		const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, (GLuint) i);
+		khr = khr || strcmp(extension, "GL_KHR_parallel_shader_compile") == 0;
+		arb = arb || strcmp(extension, "GL_ARB_parallel_shader_compile") == 0;
+	}
+	maxShaderCompilerThreads = NULL;
+	if (khr)
+		maxShaderCompilerThreads = (maxShaderCompilerThreadsFunc_t) load("glMaxShaderCompilerThreadsKHR");
+	else if (arb)
+		maxShaderCompilerThreads = (maxShaderCompilerThreadsFunc_t) load("glMaxShaderCompilerThreadsARB");
+	parallelCompile = maxShaderCompilerThreads != NULL;
+	if (parallelCompile)
+		maxShaderCompilerThreads(0xFFFFFFFFu); // As many as the driver likes
+	printf("Parallel shader compile %s\n", parallelCompile ? "enabled" : "not supported");
+	return parallelCompile;
+}
 
-		GLint logSize = 0;
-		glGetShaderiv(*shader, GL_INFO_LOG_LENGTH, &logSize);
-		char infoBuffer[logSize];
-		glGetShaderInfoLog(*shader, logSize, &logSize, infoBuffer);
-		fprintf(stderr, infoBuffer);
+void shaderBatchInit(shaderBatch_t* batch, const shaderReadyFunc_t ready)
+{
+	memset(batch, 0, sizeof(shaderBatch_t));
+	batch->ready = ready;
+}
 
-		glDeleteShader(*shader);
-		exit(-1);
+// Takes ownership of 'source', the defines go on the line after #version (which has to stay first)
+static char* injectDefines(char* source, const char* defines)
+{
+	if (defines == NULL || defines[0] == '\0')
+		return source;
+	const char* lineEnd = strncmp(source, "#version", 8) == 0 ? strchr(source, '\n') : NULL;
+	const size_t prefixLength = lineEnd ? (size_t) (lineEnd - source + 1) : 0;
+	const size_t definesLength = strlen(defines);
+	char* injected = malloc(prefixLength + definesLength + strlen(source + prefixLength) + 1);
+	if (injected == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate shader defines!\n");
+		exit(EXIT_FAILURE);
 	}
-	printf("Shader '%s' compile success\n", shaderFile);
+	memcpy(injected, source, prefixLength);
+	memcpy(injected + prefixLength, defines, definesLength);
+	strcpy(injected + prefixLength + definesLength, source + prefixLength);
+	free(source);
+	return injected;
 }
 
-//void createShader(GLuint* shaderProgram)
-GLuint shaderCreate(const char* vertexFile, const char* fragmentFile, const char* geometryFile)
+// Into any slot, new or one a variant was evicted from
+static void submitBuild(shaderBatch_t* batch, const uint32_t index, const char* vertexFile, const char* fragmentFile,
+						const char* geometryFile, const char* defines, void* user)
+{
+	shaderBuild_t* build = &batch->builds[index];
+	memset(build, 0, sizeof(shaderBuild_t));
+	build->startTime = timeGetSeconds();
+	build->files[0] = vertexFile;
+	build->files[1] = fragmentFile;
+	build->files[2] = geometryFile;
+	build->numStages = geometryFile ? 3 : 2;
+	build->user = user;
+
+	char* sources[SHADER_STAGES];
+	for (int i = 0; i < build->numStages; i++)
+		sources[i] = injectDefines(shaderInclude(build->files[i], readFile(build->files[i]), 0), defines);
+
+	// Sources are hashed after includes & defines, so editing frame.glsl misses every program using it
+	shaderCachePath(build->cachePath, sizeof(build->cachePath), vertexFile, fragmentFile, geometryFile, defines);
+	build->key = shaderCacheKey((const char* const*) sources, build->numStages);
+	build->program = shaderCacheSupported() ? shaderCacheLoad(build->cachePath, build->key) : 0;
+	build->cached = build->program != 0;
+	if (build->cached)
+		build->state = SHADER_BUILD_LINKING;
+	else
+	{
+		const GLenum types[SHADER_STAGES] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER};
+		for (int i = 0; i < build->numStages; i++)
+		{
+			build->shaders[i] = glCreateShader(types[i]);
+			glShaderSource(build->shaders[i], 1, (const char* const*) &sources[i], NULL);
+			glCompileShader(build->shaders[i]);
+		}
+		build->state = SHADER_BUILD_COMPILING;
+	}
+	for (int i = 0; i < build->numStages; i++)
+		free(sources[i]);
+
+	batch->numPending++;
+}
+
+uint32_t shaderBatchAdd(shaderBatch_t* batch, const char* vertexFile, const char* fragmentFile, const char* geometryFile,
+						const char* defines, void* user)
+{
+	if (batch->numBuilds == SHADER_BATCH_MAX)
+	{
+		fprintf(stderr, "Too many programs in one shader batch! (%d)\n", SHADER_BATCH_MAX);
+		exit(EXIT_FAILURE);
+	}
+	submitBuild(batch, batch->numBuilds, vertexFile, fragmentFile, geometryFile, defines, user);
+	return batch->numBuilds++;
+}
+
+static bool isComplete(const GLuint object, const bool program)
 {
-	GLuint vertexShader, fragmentShader, geometryShader;
-	shaderCompile(&vertexShader, GL_VERTEX_SHADER, vertexFile);
-	shaderCompile(&fragmentShader, GL_FRAGMENT_SHADER, fragmentFile);
-	if (geometryFile)
-		shaderCompile(&geometryShader, GL_GEOMETRY_SHADER, geometryFile);
+	GLint complete = GL_TRUE;
+	if (program)
+		glGetProgramiv(object, GL_COMPLETION_STATUS_KHR, &complete);
+	else
+		glGetShaderiv(object, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+static void failBuild(shaderBatch_t* batch, shaderBuild_t* build)
+{
+	for (int i = 0; i < build->numStages; i++)
+	{
+		if (build->shaders[i])
+			glDeleteShader(build->shaders[i]);
+		build->shaders[i] = 0;
+	}
+	if (build->program)
+		glDeleteProgram(build->program);
+	build->program = 0;
+	build->state = SHADER_BUILD_FAILED;
+	batch->numPending--;
+	batch->numFailed++;
+}
 
-	const GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	if (geometryFile)
-		glAttachShader(shaderProgram, geometryShader);
+// Advances one build as far as it can go, returns false if it's waiting on the driver
+static bool updateBuild(shaderBatch_t* batch, shaderBuild_t* build, const bool wait)
+{
+	if (build->state == SHADER_BUILD_COMPILING)
+	{
+		for (int i = 0; i < build->numStages; i++)
+		{
+			if (!wait && parallelCompile && !isComplete(build->shaders[i], false))
+				return false;
+		}
+		bool compiled = true;
+		for (int i = 0; i < build->numStages; i++)
+		{
+			GLint isCompiled = GL_FALSE;
+			glGetShaderiv(build->shaders[i], GL_COMPILE_STATUS, &isCompiled);
+			if (isCompiled == GL_FALSE)
+			{
+				printShaderLog(build->shaders[i], build->files[i]);
+				compiled = false;
+			}
+		}
+		if (!compiled)
+		{
+			failBuild(batch, build);
+			return true;
+		}
 
-	glBindFragDataLocation(shaderProgram, 0, "FragColor");
+		build->program = glCreateProgram();
+		for (int i = 0; i < build->numStages; i++)
+			glAttachShader(build->program, build->shaders[i]);
+		glBindFragDataLocation(build->program, 0, "FragColor");
+		if (shaderCacheSupported())
+			glProgramParameteri(build->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(build->program);
+		// Only flagged, they go with the program
+		for (int i = 0; i < build->numStages; i++)
+			glDeleteShader(build->shaders[i]);
+		memset(build->shaders, 0, sizeof(build->shaders));
+		build->state = SHADER_BUILD_LINKING;
+	}
 
-	glLinkProgram(shaderProgram);
-//	glUseProgram(shaderProgram);
+	if (!wait && parallelCompile && !isComplete(build->program, true))
+		return false;
+	GLint linked = GL_FALSE;
+	glGetProgramiv(build->program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE)
+	{
+		printProgramLog(build);
+		failBuild(batch, build);
+		return true;
+	}
+	if (!build->cached && shaderCacheSupported() && !shaderCacheWrite(build->cachePath, build->key, build->program))
+		fprintf(stderr, "Failed to write program cache: %s\n", build->cachePath);
 
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-	if (geometryFile)
-		glDeleteShader(geometryShader);
+	shaderReflect(build->program);
+	build->buildMs = (timeGetSeconds() - build->startTime) * 1000.;
+	printf("Shader %d %s in %.2f ms (%u uniform locations)\n", build->program,
+		   build->cached ? "loaded from cache" : "compiled & linked", build->buildMs, uniformTableCount(build->program));
+	build->state = SHADER_BUILD_READY;
+	batch->buildMs += build->buildMs;
+	batch->numPending--;
+	if (batch->ready)
+		batch->ready(build->program, build->user);
+	return true;
+}
 
-	printf("Shader %d linked\n", shaderProgram);
+uint32_t shaderBatchUpdate(shaderBatch_t* batch, const bool wait)
+{
+	const double startTime = timeGetSeconds();
+	for (uint32_t i = 0; i < batch->numBuilds && batch->numPending > 0; i++)
+	{
+		shaderBuild_t* build = &batch->builds[i];
+		if (build->state == SHADER_BUILD_COMPILING || build->state == SHADER_BUILD_LINKING)
+			updateBuild(batch, build, wait);
+	}
+	batch->lastUpdateMs = (timeGetSeconds() - startTime) * 1000.;
+	return batch->numPending;
+}
+
+GLuint shaderBatchProgram(const shaderBatch_t* batch, const uint32_t build)
+{
+	return build < batch->numBuilds && batch->builds[build].state == SHADER_BUILD_READY ? batch->builds[build].program : 0;
+}
+
+void shaderVariantsInit(shaderVariants_t* variants, const char* vertexFile, const char* fragmentFile, const char* geometryFile,
+						const shaderDefinesFunc_t defines, const shaderReadyFunc_t ready)
+{
+	memset(variants, 0, sizeof(shaderVariants_t));
+	variants->files[0] = vertexFile;
+	variants->files[1] = fragmentFile;
+	variants->files[2] = geometryFile;
+	variants->defines = defines;
+	shaderBatchInit(&variants->batch, ready);
+}
+
+void shaderVariantsDestroy(shaderVariants_t* variants)
+{
+	shaderBatchUpdate(&variants->batch, true);
+	for (uint32_t i = 0; i < variants->batch.numBuilds; i++)
+	{
+		const GLuint program = shaderBatchProgram(&variants->batch, i);
+		if (program)
+		{
+			uniformTableForget(program);
+			glDeleteProgram(program);
+		}
+	}
+	variants->batch.numBuilds = 0;
+	glStateReset();
+}
+
+void shaderVariantsNextFrame(shaderVariants_t* variants)
+{
+	variants->frame++;
+}
+
+// Least recently used variant that wasn't asked for this frame (its program may be about to draw) & isn't in flight,
+// SHADER_BATCH_MAX if there's none
+static uint32_t findEvictable(const shaderVariants_t* variants)
+{
+	uint32_t oldest = SHADER_BATCH_MAX;
+	for (uint32_t i = 0; i < variants->batch.numBuilds; i++)
+	{
+		const shaderBuildState_t state = variants->batch.builds[i].state;
+		if (variants->lastUsed[i] == variants->frame || state == SHADER_BUILD_COMPILING || state == SHADER_BUILD_LINKING)
+			continue;
+		if (oldest == SHADER_BATCH_MAX || variants->lastUsed[i] < variants->lastUsed[oldest])
+			oldest = i;
+	}
+	return oldest;
+}
+
+static void evictVariant(shaderVariants_t* variants, const uint32_t variant)
+{
+	shaderBuild_t* build = &variants->batch.builds[variant];
+	if (build->state == SHADER_BUILD_READY)
+	{
+		uniformTableForget(build->program);
+		glDeleteProgram(build->program);
+		glStateReset();
+	} else
+		variants->batch.numFailed--;
+	variants->numEvicted++;
+}
+
+GLuint shaderVariantGet(shaderVariants_t* variants, const uint64_t key, const GLuint fallback)
+{
+	shaderBatch_t* batch = &variants->batch;
+	uint32_t variant = 0;
+	while (variant < batch->numBuilds && variants->keys[variant] != key)
+		variant++;
+	if (variant == batch->numBuilds)
+	{
+		if (batch->numBuilds == SHADER_BATCH_MAX)
+		{
+			variant = findEvictable(variants);
+			if (variant == SHADER_BATCH_MAX)
+			{
+				if (!variants->full)
+					fprintf(stderr, "Too many variants of %s in use at once! (%d)\n", variants->files[1], SHADER_BATCH_MAX);
+				variants->full = true;
+				return fallback;
+			}
+			evictVariant(variants, variant);
+			variants->full = false;
+		} else
+			batch->numBuilds++;
+		char defines[SHADER_DEFINES_LENGTH];
+		variants->defines(key, defines, sizeof(defines));
+		variants->keys[variant] = key;
+		submitBuild(batch, variant, variants->files[0], variants->files[1], variants->files[2], defines, NULL);
+	}
+	variants->lastUsed[variant] = variants->frame;
+
+	shaderBuild_t* build = &batch->builds[variant];
+	if (build->state == SHADER_BUILD_COMPILING || build->state == SHADER_BUILD_LINKING)
+		updateBuild(batch, build, false);
+	return build->state == SHADER_BUILD_READY ? build->program : fallback;
+}
+
+//void createShader(GLuint* shaderProgram)
+GLuint shaderCreate(const char* vertexFile, const char* fragmentFile, const char* geometryFile)
+{
+	// A batch of one that's waited on straight away
+	shaderBatch_t* batch = malloc(sizeof(shaderBatch_t));
+	if (batch == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate shader batch!\n");
+		exit(EXIT_FAILURE);
+	}
+	shaderBatchInit(batch, NULL);
+	shaderBatchAdd(batch, vertexFile, fragmentFile, geometryFile, NULL, NULL);
+	shaderBatchUpdate(batch, true);
+	const GLuint shaderProgram = shaderBatchProgram(batch, 0);
+	free(batch);
+	if (shaderProgram == 0)
+		exit(-1);
 	return shaderProgram;
 }
 
+void shaderReflect(const GLuint program)
+{
+	GLint numUniforms = 0, maxNameLength = 0;
+	glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numUniforms);
+	glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	// Room to swap an element index in for "[0]"
+	char name[maxNameLength + 16];
+	const GLenum properties[] = {GL_LOCATION, GL_ARRAY_SIZE};
+	for (GLint i = 0; i < numUniforms; i++)
+	{
+		GLint values[2];
+		glGetProgramResourceiv(program, GL_UNIFORM, (GLuint) i, 2, properties, 2, NULL, values);
+		// Block members have no location
+		if (values[0] < 0)
+			continue;
+		glGetProgramResourceName(program, GL_UNIFORM, (GLuint) i, maxNameLength, NULL, name);
+		uniformTableAdd(program, name, values[0]);
+
+		// Arrays of basic types come back once as "name[0]", the other elements' locations follow on from it
+		const size_t length = strlen(name);
+		if (length > 3 && strcmp(name + length - 3, "[0]") == 0)
+		{
+			name[length - 3] = '\0';
+			uniformTableAdd(program, name, values[0]);
+			for (GLint element = 1; element < values[1]; element++)
+			{
+				snprintf(name + length - 3, sizeof(name) - (length - 3), "[%d]", element);
+				uniformTableAdd(program, name, values[0] + element);
+			}
+		}
+	}
+}
+
+GLint shaderGetLocation(const GLuint program, const uniform_t uniform)
+{
+	GLint location;
+	return uniformTableGet(program, uniform, &location) ? location : glGetUniformLocation(program, uniform.name);
+}
+
 void setUniform1i(const GLuint* shader, const char* name, const GLint x)
 {
 	// glUniform1i(glGetUniformLocation(*shader, name), x);
-	glProgramUniform1i(*shader, glGetUniformLocation(*shader, name), x);
+	glProgramUniform1i(*shader, lookupLocation(*shader, name), x);
 }
 
 void setUniform1ui(const GLuint* shader, const char* name, const GLuint x)
 {
 	// glUniform1ui(glGetUniformLocation(*shader, name), x);
-	glProgramUniform1ui(*shader, glGetUniformLocation(*shader, name), x);
+	glProgramUniform1ui(*shader, lookupLocation(*shader, name), x);
 }
 
 void setUniform1f(const GLuint* shader, const char* name, const GLfloat x)
 {
 	// glUniform1f(glGetUniformLocation(*shader, name), x);
-	glProgramUniform1f(*shader, glGetUniformLocation(*shader, name), x);
+	glProgramUniform1f(*shader, lookupLocation(*shader, name), x);
 }
 
 void setUniform1fv(const GLuint* shader, const char* name, const GLfloat* value)
 {
 	// glUniform1fv(glGetUniformLocation(*shader, name), 1, value);
-	glProgramUniform1fv(*shader, glGetUniformLocation(*shader, name), 1, value);
+	glProgramUniform1fv(*shader, lookupLocation(*shader, name), 1, value);
 }
 
 void setUniform2f(const GLuint* shader, const char* name, const GLfloat x, const GLfloat y)
 {
 	// glUniform2f(glGetUniformLocation(*shader, name), x, y);
-	glProgramUniform2f(*shader, glGetUniformLocation(*shader, name), x, y);
+	glProgramUniform2f(*shader, lookupLocation(*shader, name), x, y);
 }
 
 void setUniform2fv(const GLuint* shader, const char* name, vec2 value)
 {
 	// glUniform2fv(glGetUniformLocation(*shader, name), 1, (const GLfloat*) value);
-	glProgramUniform2fv(*shader, glGetUniformLocation(*shader, name), 1, (const GLfloat*) value);
+	glProgramUniform2fv(*shader, lookupLocation(*shader, name), 1, (const GLfloat*) value);
 }
 
 void setUniform3f(const GLuint* shader, const char* name, const GLfloat x, const GLfloat y, const GLfloat z)
 {
 	// glUniform3f(glGetUniformLocation(*shader, name), x, y, z);
-	glProgramUniform3f(*shader, glGetUniformLocation(*shader, name), x, y, z);
+	glProgramUniform3f(*shader, lookupLocation(*shader, name), x, y, z);
 }
 
 void setUniform3fv(const GLuint* shader, const char* name, vec3 value)
 {
 	// glUniform3fv(glGetUniformLocation(*shader, name), 1, (const GLfloat*) value);
-	glProgramUniform3fv(*shader, glGetUniformLocation(*shader, name), 1, (const GLfloat*) value);
+	glProgramUniform3fv(*shader, lookupLocation(*shader, name), 1, (const GLfloat*) value);
 }
 
 void setUniform4f(const GLuint* shader, const char* name, const GLfloat x, const GLfloat y, const GLfloat z, const GLfloat w)
 {
 	// glUniform4f(glGetUniformLocation(*shader, name), x, y, z, w);
-	glProgramUniform4f(*shader, glGetUniformLocation(*shader, name), x, y, z, w);
+	glProgramUniform4f(*shader, lookupLocation(*shader, name), x, y, z, w);
 }
 
 void setUniform4fv(const GLuint* shader, const char* name, vec4 value)
 {
 	// glUniform4fv(glGetUniformLocation(*shader, name), 1, (const GLfloat*) value);
-	glProgramUniform4fv(*shader, glGetUniformLocation(*shader, name), 1, (const GLfloat*) value);
+	glProgramUniform4fv(*shader, lookupLocation(*shader, name), 1, (const GLfloat*) value);
+}
+
+void setUniformMatrix3fv(const GLuint* shader, const char* name, const GLfloat* value)
+{
+	glProgramUniformMatrix3fv(*shader, lookupLocation(*shader, name), 1, GL_FALSE, value);
 }
 
 void setUniformMatrix4fv(const GLuint* shader, const char* name, const GLfloat* value)
 {
 	// glUniformMatrix4fv(glGetUniformLocation(*shader, name), 1, GL_FALSE, value);
-	glProgramUniformMatrix4fv(*shader, glGetUniformLocation(*shader, name), 1, GL_FALSE, value);
+	glProgramUniformMatrix4fv(*shader, lookupLocation(*shader, name), 1, GL_FALSE, value);
+}
+
+void setUniformLocation1i(const GLuint* shader, const GLint location, const GLint x)
+{
+	glProgramUniform1i(*shader, location, x);
+}
+
+void setUniformLocation1ui(const GLuint* shader, const GLint location, const GLuint x)
+{
+	glProgramUniform1ui(*shader, location, x);
+}
+
+void setUniformLocation1f(const GLuint* shader, const GLint location, const GLfloat x)
+{
+	glProgramUniform1f(*shader, location, x);
+}
+
+void setUniformLocation1fv(const GLuint* shader, const GLint location, const GLfloat* value)
+{
+	glProgramUniform1fv(*shader, location, 1, value);
+}
+
+void setUniformLocation2f(const GLuint* shader, const GLint location, const GLfloat x, const GLfloat y)
+{
+	glProgramUniform2f(*shader, location, x, y);
+}
+
+void setUniformLocation2fv(const GLuint* shader, const GLint location, vec2 value)
+{
+	glProgramUniform2fv(*shader, location, 1, (const GLfloat*) value);
+}
+
+void setUniformLocation3f(const GLuint* shader, const GLint location, const GLfloat x, const GLfloat y, const GLfloat z)
+{
+	glProgramUniform3f(*shader, location, x, y, z);
+}
+
+void setUniformLocation3fv(const GLuint* shader, const GLint location, vec3 value)
+{
+	glProgramUniform3fv(*shader, location, 1, (const GLfloat*) value);
+}
+
+void setUniformLocation4f(const GLuint* shader, const GLint location, const GLfloat x, const GLfloat y, const GLfloat z,
+						  const GLfloat w)
+{
+	glProgramUniform4f(*shader, location, x, y, z, w);
+}
+
+void setUniformLocation4fv(const GLuint* shader, const GLint location, vec4 value)
+{
+	glProgramUniform4fv(*shader, location, 1, (const GLfloat*) value);
+}
+
+void setUniformLocationMatrix3fv(const GLuint* shader, const GLint location, const GLfloat* value)
+{
+	glProgramUniformMatrix3fv(*shader, location, 1, GL_FALSE, value);
+}
+
+void setUniformLocationMatrix4fv(const GLuint* shader, const GLint location, const GLfloat* value)
+{
+	glProgramUniformMatrix4fv(*shader, location, 1, GL_FALSE, value);
 }
@@ -5,14 +5,121 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <glad/glad.h>
 
 #include <cglm/cglm.h>
 
-void shaderCompile(GLuint* shader, GLenum shaderType, const char* shaderFile);
+#include "uniformtable.h"
+
+#define SHADER_INCLUDE_DEPTH 8 // Nested #includes before it's assumed a file includes itself
+#define SHADER_BATCH_MAX 32 // Programs per batch
+#define SHADER_STAGES 3 // Vertex, fragment & optionally geometry
+#define SHADER_PATH_LENGTH 520
+#define SHADER_DEFINES_LENGTH 512
+
+// Takes ownership of 'source', '#include "file"' lines (relative to 'shaderFile') are replaced by the file
+char* shaderInclude(const char* shaderFile, char* source, int depth);
+
+typedef enum shaderBuildState_t
+{
+	SHADER_BUILD_COMPILING = 0,
+	SHADER_BUILD_LINKING,
+	SHADER_BUILD_READY,
+	SHADER_BUILD_FAILED
+} shaderBuildState_t;
+
+// Called from shaderBatchUpdate once a program has linked & been reflected
+typedef void (*shaderReadyFunc_t)(GLuint program, void* user);
+
+typedef struct shaderBuild_t
+{
+	const char* files[SHADER_STAGES]; // Not copied, only for the log
+	GLuint shaders[SHADER_STAGES];
+	int numStages;
+	GLuint program; // Set once it's linking
+	uint64_t key;
+	char cachePath[SHADER_PATH_LENGTH];
+	shaderBuildState_t state;
+	bool cached;
+	double startTime;
+	double buildMs; // Submit to ready
+	void* user;
+} shaderBuild_t;
+
+// Every stage of every program is submitted up front & nothing asks for a status until the driver says it's done, so
+// with GL_KHR_parallel_shader_compile the driver compiles them all on its own threads while the caller gets on
+typedef struct shaderBatch_t
+{
+	shaderBuild_t builds[SHADER_BATCH_MAX];
+	uint32_t numBuilds;
+	uint32_t numPending; // Compiling or linking
+	uint32_t numFailed;
+	shaderReadyFunc_t ready;
+	double lastUpdateMs;
+	double buildMs; // Every ready build's, added up
+} shaderBatch_t;
+
+// Writes the '#define' lines (newline terminated) for a variant key
+typedef void (*shaderDefinesFunc_t)(uint64_t key, char* defines, size_t size);
+
+// Specialized builds of one set of stages, each variant is the same source with a different block of defines after
+// #version. Variants are compiled the first time they're asked for & kept until SHADER_BATCH_MAX are, then the least
+// recently used one makes room (coming back from the program cache is cheap), the key is whatever the caller packs its
+// features into
+typedef struct shaderVariants_t
+{
+	const char* files[SHADER_STAGES];
+	shaderDefinesFunc_t defines;
+	shaderBatch_t batch; // A build per variant
+	uint64_t keys[SHADER_BATCH_MAX]; // Of each build
+	uint64_t lastUsed[SHADER_BATCH_MAX]; // Frame each build was last asked for
+	uint64_t frame;
+	uint32_t numEvicted;
+	bool full; // Every variant was in use, logged once until one can be evicted again
+} shaderVariants_t;
+
+// Loads GL_KHR_parallel_shader_compile (or the ARB one) if the driver has it, glad doesn't generate either, returns
+// false without it, batches then still work but a status check waits for that compile
+bool shaderInitParallelCompile(GLADloadproc load);
 
+// 'ready' can be NULL, programs can be taken with shaderBatchProgram instead
+void shaderBatchInit(shaderBatch_t* batch, shaderReadyFunc_t ready);
+// Reads the stages & submits their compiles (or loads the cached binary) without waiting, returns the build's index
+// 'defines' (can be NULL) goes into every stage right after #version
+uint32_t shaderBatchAdd(shaderBatch_t* batch, const char* vertexFile, const char* fragmentFile, const char* geometryFile,
+						const char* defines, void* user);
+// Links programs whose stages have all compiled & finishes programs that have linked, logging any errors. Only skips
+// what's still in flight with the parallel extension, 'wait' finishes everything. Returns how many are still pending
+uint32_t shaderBatchUpdate(shaderBatch_t* batch, bool wait);
+// 0 until the build is ready
+GLuint shaderBatchProgram(const shaderBatch_t* batch, uint32_t build);
+
+// 'ready' is called for every variant, like a batch's
+void shaderVariantsInit(shaderVariants_t* variants, const char* vertexFile, const char* fragmentFile, const char* geometryFile,
+						shaderDefinesFunc_t defines, shaderReadyFunc_t ready);
+// Finishes anything compiling & deletes every variant's program
+void shaderVariantsDestroy(shaderVariants_t* variants);
+// Before the frame's first shaderVariantGet, variants asked for since the last call are never evicted
+void shaderVariantsNextFrame(shaderVariants_t* variants);
+// The variant's program, 'fallback' while it's compiling (it's submitted the first time it's asked for) or if it failed.
+// Only valid for the frame, a later frame can evict it
+GLuint shaderVariantGet(shaderVariants_t* variants, uint64_t key, GLuint fallback);
+
+// Loads the program binary from its cache (see shadercache.h) if the sources & driver haven't changed, otherwise
+// compiles, links & caches it. Reflects the linked program's uniforms, so its locations come from shaderGetLocation
 GLuint shaderCreate(const char* vertexFile, const char* fragmentFile, const char* geometryFile);
 
+// Fills the program's name -> location table (see uniformtable.h) from its active uniforms, arrays get an entry per
+// element
+void shaderReflect(GLuint program);
+// -1 (which GL ignores) if the program has no such active uniform
+GLint shaderGetLocation(GLuint program, uniform_t uniform);
+
+// By name, through the location table (or the driver if the program was never reflected), fine outside the frame
+
 void setUniform1i(const GLuint* shader, const char* name, GLint x);
 void setUniform1ui(const GLuint* shader, const char* name, GLuint x);
 
@@ -28,6 +135,26 @@ void setUniform3fv(const GLuint* shader, const char* name, vec3 value);
 void setUniform4f(const GLuint* shader, const char* name, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
 void setUniform4fv(const GLuint* shader, const char* name, vec4 value);
 
+void setUniformMatrix3fv(const GLuint* shader, const char* name, const GLfloat* value);
 void setUniformMatrix4fv(const GLuint* shader, const char* name, const GLfloat* value);
 
+// By location, for hot code with a uniform_t (see shaderGetLocation)
+void setUniformLocation1i(const GLuint* shader, GLint location, GLint x);
+void setUniformLocation1ui(const GLuint* shader, GLint location, GLuint x);
+
+void setUniformLocation1f(const GLuint* shader, GLint location, GLfloat x);
+void setUniformLocation1fv(const GLuint* shader, GLint location, const GLfloat* value);
+
+void setUniformLocation2f(const GLuint* shader, GLint location, GLfloat x, GLfloat y);
+void setUniformLocation2fv(const GLuint* shader, GLint location, vec2 value);
+
+void setUniformLocation3f(const GLuint* shader, GLint location, GLfloat x, GLfloat y, GLfloat z);
+void setUniformLocation3fv(const GLuint* shader, GLint location, vec3 value);
+
+void setUniformLocation4f(const GLuint* shader, GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+void setUniformLocation4fv(const GLuint* shader, GLint location, vec4 value);
+
+void setUniformLocationMatrix3fv(const GLuint* shader, GLint location, const GLfloat* value);
+void setUniformLocationMatrix4fv(const GLuint* shader, GLint location, const GLfloat* value);
+
 #endif //SHADER_H
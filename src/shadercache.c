@@ -0,0 +1,119 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shadercache.h"
+#include "util.h"
+
+static uint64_t hashString(const char* string, const uint64_t hash)
+{
+	// Includes the terminator so "ab" + "c" & "a" + "bc" differ
+	return string ? hashFNV1a(string, strlen(string) + 1, hash) : hashFNV1a("", 1, hash);
+}
+
+void shaderCachePath(char* path, const size_t size, const char* vertexFile, const char* fragmentFile,
+					 const char* geometryFile, const char* defines)
+{
+	uint64_t hash = hashString(vertexFile, HASH_FNV1A_SEED);
+	hash = hashString(fragmentFile, hash);
+	hash = hashString(geometryFile, hash);
+	hash = hashString(defines, hash);
+	snprintf(path, size, "%s.%016llx%s", vertexFile, (unsigned long long) hash, SHADER_CACHE_EXTENSION);
+}
+
+uint64_t shaderCacheKey(const char* const* sources, const int numSources)
+{
+	uint64_t hash = hashString((const char*) glGetString(GL_VENDOR), HASH_FNV1A_SEED);
+	hash = hashString((const char*) glGetString(GL_RENDERER), hash);
+	hash = hashString((const char*) glGetString(GL_VERSION), hash);
+	for (int i = 0; i < numSources; i++)
+		hash = hashString(sources[i], hash);
+	return hash;
+}
+
+bool shaderCacheSupported()
+{
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	return numFormats > 0;
+}
+
+GLuint shaderCacheLoad(const char* cachePath, const uint64_t key)
+{
+	mappedFile_t file;
+	if (!fileMap(cachePath, &file))
+		return 0;
+
+	const shaderCacheHeader_t* header = (const shaderCacheHeader_t*) file.data;
+	const bool valid = file.size >= sizeof(shaderCacheHeader_t) &&
+		header->magic == SHADER_CACHE_MAGIC &&
+		header->version == SHADER_CACHE_VERSION &&
+		header->key == key &&
+		header->size > 0 && sizeof(shaderCacheHeader_t) + header->size <= file.size;
+	GLuint program = 0;
+	if (valid)
+	{
+		program = glCreateProgram();
+		glProgramBinary(program, header->format, (const unsigned char*) file.data + sizeof(shaderCacheHeader_t),
+						(GLsizei) header->size);
+		// Drivers reject binaries from before an update even when the version string didn't change
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (linked == GL_FALSE)
+		{
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+	fileUnmap(&file);
+	return program;
+}
+
+bool shaderCacheWrite(const char* cachePath, const uint64_t key, const GLuint program)
+{
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return false;
+	unsigned char* binary = malloc((size_t) size);
+	if (binary == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate program binary!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	shaderCacheHeader_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SHADER_CACHE_MAGIC;
+	header.version = SHADER_CACHE_VERSION;
+	header.key = key;
+	GLsizei length = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, size, &length, &format, binary);
+	header.format = format;
+	header.size = (uint32_t) length;
+
+	// Write to a temporary file first so a crash never leaves a half written cache behind
+	char tempPath[520];
+	snprintf(tempPath, sizeof(tempPath), "%s.tmp", cachePath);
+	FILE* file = length > 0 ? fopen(tempPath, "wb") : NULL;
+	bool ok = file != NULL;
+	ok = ok && fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(binary, 1, header.size, file) == header.size;
+	if (file)
+		ok = fclose(file) == 0 && ok;
+	free(binary);
+
+	if (ok)
+	{
+		remove(cachePath);
+		ok = rename(tempPath, cachePath) == 0;
+	}
+	if (!ok && file)
+		remove(tempPath);
+	return ok;
+}
@@ -0,0 +1,41 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * On disk cache of linked program binaries, so launches after the first skip compiling & linking
+ */
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <glad/glad.h>
+
+#define SHADER_CACHE_EXTENSION ".program"
+#define SHADER_CACHE_MAGIC 0x474F5250u // "PROG"
+#define SHADER_CACHE_VERSION 1
+
+typedef struct shaderCacheHeader_t
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key; // shaderCacheKey of what the binary was linked from
+	uint32_t format; // From glGetProgramBinary
+	uint32_t size; // Binary bytes following the header
+} shaderCacheHeader_t;
+
+// '<vertexFile>.<hash of the stage files & defines>.program', one per stage combination & variant so they don't collide
+void shaderCachePath(char* path, size_t size, const char* vertexFile, const char* fragmentFile, const char* geometryFile,
+					 const char* defines);
+// Hash of the (included) stage sources & the driver's vendor, renderer & version, binaries are only good for one driver
+uint64_t shaderCacheKey(const char* const* sources, int numSources);
+// false if the driver can't save program binaries at all
+bool shaderCacheSupported();
+
+// Creates a program from the cached binary, 0 if it's missing, for another key or rejected by the driver
+GLuint shaderCacheLoad(const char* cachePath, uint64_t key);
+// The program has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+bool shaderCacheWrite(const char* cachePath, uint64_t key, GLuint program);
+
+#endif //SHADERCACHE_H
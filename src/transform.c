@@ -0,0 +1,149 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "transform.h"
+
+// 32 bytes so cglm's avx mat4 paths can be used on the matrix arrays
+static void* growAligned(void* array, const size_t oldSize, const size_t newSize)
+{
+	const size_t size = (newSize + 31) & ~(size_t) 31;
+#ifdef _WIN32
+	void* grown = _aligned_malloc(size, 32);
+#else
+	void* grown = aligned_alloc(32, size);
+#endif
+	if (grown == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate transforms!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (array)
+	{
+		memcpy(grown, array, oldSize);
+#ifdef _WIN32
+		_aligned_free(array);
+#else
+		free(array);
+#endif
+	}
+	return grown;
+}
+
+static void reserve(transforms_t* transforms, const uint32_t capacity)
+{
+	const uint32_t count = transforms->count;
+	transforms->translations = growAligned(transforms->translations, count * sizeof(vec3), capacity * sizeof(vec3));
+	transforms->rotations = growAligned(transforms->rotations, count * sizeof(versor), capacity * sizeof(versor));
+	transforms->scales = growAligned(transforms->scales, count * sizeof(vec3), capacity * sizeof(vec3));
+	transforms->parents = growAligned(transforms->parents, count * sizeof(uint32_t), capacity * sizeof(uint32_t));
+	transforms->dirty = growAligned(transforms->dirty, count * sizeof(uint8_t), capacity * sizeof(uint8_t));
+	transforms->worlds = growAligned(transforms->worlds, count * sizeof(mat4), capacity * sizeof(mat4));
+	transforms->normals = growAligned(transforms->normals, count * sizeof(mat3), capacity * sizeof(mat3));
+	transforms->capacity = capacity;
+}
+
+transforms_t* transformsCreate(const uint32_t capacity)
+{
+	transforms_t* transforms = calloc(1, sizeof(transforms_t));
+	if (transforms == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate transforms!\n");
+		exit(EXIT_FAILURE);
+	}
+	reserve(transforms, capacity ? capacity : 16);
+	return transforms;
+}
+
+void transformsDestroy(transforms_t* transforms)
+{
+	void* arrays[] = {
+		transforms->translations, transforms->rotations, transforms->scales, transforms->parents, transforms->dirty,
+		transforms->worlds, transforms->normals
+	};
+	for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+	{
+#ifdef _WIN32
+		_aligned_free(arrays[i]);
+#else
+		free(arrays[i]);
+#endif
+	}
+	free(transforms);
+}
+
+uint32_t transformAdd(transforms_t* transforms, const uint32_t parent, const vec3 translation, const versor rotation,
+					  const vec3 scale)
+{
+	if (parent != TRANSFORM_ROOT && parent >= transforms->count)
+	{
+		fprintf(stderr, "Transform parent %u doesn't exist yet!\n", parent);
+		return TRANSFORM_ROOT;
+	}
+	if (transforms->count == transforms->capacity)
+		reserve(transforms, transforms->capacity * 2);
+
+	const uint32_t transform = transforms->count++;
+	glm_vec3_copy((float*) translation, transforms->translations[transform]);
+	glm_vec4_copy((float*) rotation, transforms->rotations[transform]);
+	glm_vec3_copy((float*) scale, transforms->scales[transform]);
+	transforms->parents[transform] = parent;
+	transforms->dirty[transform] = 1;
+	return transform;
+}
+
+void transformSetTranslation(transforms_t* transforms, const uint32_t transform, const vec3 translation)
+{
+	glm_vec3_copy((float*) translation, transforms->translations[transform]);
+	transforms->dirty[transform] = 1;
+}
+
+void transformSetRotation(transforms_t* transforms, const uint32_t transform, const versor rotation)
+{
+	glm_vec4_copy((float*) rotation, transforms->rotations[transform]);
+	transforms->dirty[transform] = 1;
+}
+
+void transformSetScale(transforms_t* transforms, const uint32_t transform, const vec3 scale)
+{
+	glm_vec3_copy((float*) scale, transforms->scales[transform]);
+	transforms->dirty[transform] = 1;
+}
+
+void transformsUpdate(transforms_t* transforms)
+{
+	uint32_t updated = 0;
+	for (uint32_t i = 0; i < transforms->count; i++)
+	{
+		// A parent's flag is still set when its children are reached, so dirtiness flows down the subtree
+		const uint32_t parent = transforms->parents[i];
+		if (parent != TRANSFORM_ROOT)
+			transforms->dirty[i] |= transforms->dirty[parent];
+		if (!transforms->dirty[i])
+			continue;
+
+		// Translation * rotation * scale, the scale just multiplies the rotation's columns
+		mat4 local;
+		glm_quat_mat4(transforms->rotations[i], local);
+		glm_vec4_scale(local[0], transforms->scales[i][0], local[0]);
+		glm_vec4_scale(local[1], transforms->scales[i][1], local[1]);
+		glm_vec4_scale(local[2], transforms->scales[i][2], local[2]);
+		glm_vec4(transforms->translations[i], 1.f, local[3]);
+
+		if (parent == TRANSFORM_ROOT)
+			glm_mat4_copy(local, transforms->worlds[i]);
+		else
+			glm_mat4_mul(transforms->worlds[parent], local, transforms->worlds[i]);
+
+		glm_mat4_pick3(transforms->worlds[i], transforms->normals[i]);
+		glm_mat3_inv(transforms->normals[i], transforms->normals[i]);
+		glm_mat3_transpose(transforms->normals[i]);
+		updated++;
+	}
+	memset(transforms->dirty, 0, transforms->count);
+	transforms->numUpdated = updated;
+}
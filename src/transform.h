@@ -0,0 +1,44 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Structure of arrays transform hierarchy, world & normal matrices are only rebuilt for dirty subtrees
+ */
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stdint.h>
+
+#include <cglm/cglm.h>
+
+#define TRANSFORM_ROOT UINT32_MAX // Parent of top level transforms
+
+typedef struct transforms_t
+{
+	uint32_t count;
+	uint32_t capacity;
+	// Parents always come before their children, so one forward pass sees every parent updated first
+	vec3* translations;
+	versor* rotations;
+	vec3* scales;
+	uint32_t* parents;
+	uint8_t* dirty; // Local TRS changed since the last update
+	mat4* worlds;
+	mat3* normals; // Inverse transpose of the world's upper 3x3
+	uint32_t numUpdated; // By the last update
+} transforms_t;
+
+transforms_t* transformsCreate(uint32_t capacity);
+void transformsDestroy(transforms_t* transforms);
+
+// 'parent' has to already exist (or be TRANSFORM_ROOT), which keeps the arrays sorted parent first
+// Returns the new transform's index, TRANSFORM_ROOT if 'parent' doesn't exist
+uint32_t transformAdd(transforms_t* transforms, uint32_t parent, const vec3 translation, const versor rotation,
+					  const vec3 scale);
+void transformSetTranslation(transforms_t* transforms, uint32_t transform, const vec3 translation);
+void transformSetRotation(transforms_t* transforms, uint32_t transform, const versor rotation);
+void transformSetScale(transforms_t* transforms, uint32_t transform, const vec3 scale);
+
+// Rebuilds world & normal matrices of every dirty transform & everything under it in one pass over the arrays
+void transformsUpdate(transforms_t* transforms);
+
+#endif //TRANSFORM_H
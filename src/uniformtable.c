@@ -0,0 +1,164 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uniformtable.h"
+#include "util.h"
+
+typedef struct uniformTable_t
+{
+	uint32_t program; // 0 for free slots
+	uint32_t mask; // Table size - 1
+	uint32_t numUniforms;
+	uint64_t* hashes; // 0 for free slots
+	int32_t* locations;
+} uniformTable_t;
+
+// Open addressing on the program name, then on the uniform's hash inside each program
+static uniformTable_t programs[UNIFORM_TABLE_MAX_PROGRAMS];
+
+static uint32_t programSlot(const uint32_t program)
+{
+	return (program * 0x9E3779B1u) & (UNIFORM_TABLE_MAX_PROGRAMS - 1);
+}
+
+static uniformTable_t* findProgram(const uint32_t program)
+{
+	if (program == 0)
+		return NULL;
+	uint32_t slot = programSlot(program);
+	for (uint32_t i = 0; i < UNIFORM_TABLE_MAX_PROGRAMS && programs[slot].program != 0; i++)
+	{
+		if (programs[slot].program == program)
+			return &programs[slot];
+		slot = (slot + 1) & (UNIFORM_TABLE_MAX_PROGRAMS - 1);
+	}
+	return NULL;
+}
+
+static int32_t findLocation(const uniformTable_t* entry, const uint64_t hash)
+{
+	uint32_t slot = (uint32_t) hash & entry->mask;
+	while (entry->hashes[slot] != 0)
+	{
+		if (entry->hashes[slot] == hash)
+			return entry->locations[slot];
+		slot = (slot + 1) & entry->mask;
+	}
+	return -1;
+}
+
+static void insertLocation(uniformTable_t* entry, const uint64_t hash, const int32_t location)
+{
+	uint32_t slot = (uint32_t) hash & entry->mask;
+	while (entry->hashes[slot] != 0 && entry->hashes[slot] != hash)
+		slot = (slot + 1) & entry->mask;
+	if (entry->hashes[slot] == 0)
+		entry->numUniforms++;
+	entry->hashes[slot] = hash;
+	entry->locations[slot] = location;
+}
+
+static void growLocations(uniformTable_t* entry, const uint32_t capacity)
+{
+	uint64_t* hashes = entry->hashes;
+	int32_t* locations = entry->locations;
+	const uint32_t oldCapacity = hashes ? entry->mask + 1 : 0;
+
+	entry->hashes = calloc(capacity, sizeof(uint64_t));
+	entry->locations = malloc(capacity * sizeof(int32_t));
+	if (entry->hashes == NULL || entry->locations == NULL)
+	{
+		fprintf(stderr, "Out of memory! Failed to allocate uniform locations for shader %u!\n", entry->program);
+		exit(EXIT_FAILURE);
+	}
+	entry->mask = capacity - 1;
+	entry->numUniforms = 0;
+	for (uint32_t i = 0; i < oldCapacity; i++)
+	{
+		if (hashes[i] != 0)
+			insertLocation(entry, hashes[i], locations[i]);
+	}
+	free(hashes);
+	free(locations);
+}
+
+static uint64_t hashName(const char* name)
+{
+	const uint64_t hash = hashFNV1a(name, strlen(name), HASH_FNV1A_SEED);
+	return hash ? hash : 1;
+}
+
+uniform_t uniformName(const char* name)
+{
+	return (uniform_t) {hashName(name), name};
+}
+
+void uniformTableAdd(const uint32_t program, const char* name, const int32_t location)
+{
+	uniformTable_t* entry = findProgram(program);
+	if (entry == NULL)
+	{
+		uint32_t slot = programSlot(program);
+		for (uint32_t i = 0; programs[slot].program != 0; i++)
+		{
+			if (i == UNIFORM_TABLE_MAX_PROGRAMS)
+			{
+				fprintf(stderr, "Too many shader programs! Only %d can have location tables\n", UNIFORM_TABLE_MAX_PROGRAMS);
+				exit(EXIT_FAILURE);
+			}
+			slot = (slot + 1) & (UNIFORM_TABLE_MAX_PROGRAMS - 1);
+		}
+		entry = &programs[slot];
+		entry->program = program;
+		growLocations(entry, UNIFORM_TABLE_CAPACITY);
+	}
+	if ((entry->numUniforms + 1) * 2 > entry->mask + 1)
+		growLocations(entry, (entry->mask + 1) * 2);
+	insertLocation(entry, hashName(name), location);
+}
+
+void uniformTableForget(const uint32_t program)
+{
+	uniformTable_t* entry = findProgram(program);
+	if (entry == NULL)
+		return;
+	free(entry->hashes);
+	free(entry->locations);
+	memset(entry, 0, sizeof(uniformTable_t));
+
+	// Shift the rest of the run back so later probes don't stop at the hole
+	uint32_t hole = (uint32_t) (entry - programs);
+	uint32_t slot = (hole + 1) & (UNIFORM_TABLE_MAX_PROGRAMS - 1);
+	while (programs[slot].program != 0)
+	{
+		const uint32_t home = programSlot(programs[slot].program);
+		// Only moves if the hole sits between its home & where it ended up
+		if (((slot - home) & (UNIFORM_TABLE_MAX_PROGRAMS - 1)) >= ((slot - hole) & (UNIFORM_TABLE_MAX_PROGRAMS - 1)))
+		{
+			programs[hole] = programs[slot];
+			memset(&programs[slot], 0, sizeof(uniformTable_t));
+			hole = slot;
+		}
+		slot = (slot + 1) & (UNIFORM_TABLE_MAX_PROGRAMS - 1);
+	}
+}
+
+bool uniformTableGet(const uint32_t program, const uniform_t uniform, int32_t* location)
+{
+	const uniformTable_t* entry = findProgram(program);
+	if (entry == NULL)
+		return false;
+	*location = findLocation(entry, uniform.hash);
+	return true;
+}
+
+uint32_t uniformTableCount(const uint32_t program)
+{
+	const uniformTable_t* entry = findProgram(program);
+	return entry ? entry->numUniforms : 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * Created by Duncan on 17/10/2026.
+ * Per program name -> location tables of pre-hashed uniform names, no GL so it's usable without a context
+ */
+
+#ifndef UNIFORMTABLE_H
+#define UNIFORMTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UNIFORM_TABLE_MAX_PROGRAMS 64 // Programs with a location table at once
+#define UNIFORM_TABLE_CAPACITY 32 // Initial slots per program, doubles past half full
+
+// Pre-hashed uniform name, made once & kept so hot code never hashes a string or asks the driver
+typedef struct uniform_t
+{
+	uint64_t hash; // Never 0, that marks empty table slots
+	const char* name; // Only for debugging, has to outlive the handle
+} uniform_t;
+
+uniform_t uniformName(const char* name);
+// Adds one entry, creating the program's table the first time
+void uniformTableAdd(uint32_t program, const char* name, int32_t location);
+// Drops the program's table, call before deleting it as GL reuses program names
+void uniformTableForget(uint32_t program);
+// False if the program has no table, otherwise 'location' is -1 (which GL ignores) if it has no such active uniform
+bool uniformTableGet(uint32_t program, uniform_t uniform, int32_t* location);
+// Entries in the program's table, 0 if it has none
+uint32_t uniformTableCount(uint32_t program);
+
+#endif //UNIFORMTABLE_H
@@ -2,19 +2,27 @@
  * Created by Duncan on 05/04/2025.
  */
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <glad/glad.h>
 
-// #define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "util.h"
 
-unsigned char* loadImageDataFromFile(const char* path, int* width, int* height, GLenum* format);
-
 char* readFile(const char* filename)
 {
 	long size = 0;
@@ -40,6 +48,141 @@ char* readFile(const char* filename)
 	return content;
 }
 
+bool fileMap(const char* filename, mappedFile_t* file)
+{
+	file->data = NULL;
+	file->size = 0;
+	file->handle = file->mapping = NULL;
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size))
+	{
+		CloseHandle(handle);
+		return false;
+	}
+	file->handle = handle;
+	file->size = (size_t) size.QuadPart;
+	if (file->size == 0)
+		return true;
+
+	file->mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (file->mapping)
+		file->data = MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	const int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	file->size = (size_t) st.st_size;
+	if (file->size == 0)
+	{
+		close(fd);
+		return true;
+	}
+
+	void* data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // The mapping keeps its own reference
+	if (data != MAP_FAILED)
+	{
+		madvise(data, file->size, MADV_SEQUENTIAL);
+		file->data = data;
+	}
+#endif
+
+	if (file->data == NULL)
+	{
+		fileUnmap(file);
+		return false;
+	}
+	return true;
+}
+
+void fileUnmap(mappedFile_t* file)
+{
+#ifdef _WIN32
+	if (file->data)
+		UnmapViewOfFile(file->data);
+	if (file->mapping)
+		CloseHandle(file->mapping);
+	if (file->handle)
+		CloseHandle(file->handle);
+#else
+	if (file->data)
+		munmap((void*) file->data, file->size);
+#endif
+	file->data = NULL;
+	file->size = 0;
+	file->handle = file->mapping = NULL;
+}
+
+bool fileStat(const char* filename, uint64_t* size, uint64_t* mtime)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &attributes))
+		return false;
+	*size = (uint64_t) attributes.nFileSizeHigh << 32 | attributes.nFileSizeLow;
+	// FILETIME is 100ns ticks since 1601
+	const uint64_t ticks = (uint64_t) attributes.ftLastWriteTime.dwHighDateTime << 32 | attributes.ftLastWriteTime.dwLowDateTime;
+	*mtime = ticks / 10000000ull - 11644473600ull;
+#else
+	struct stat st;
+	if (stat(filename, &st) != 0)
+		return false;
+	*size = (uint64_t) st.st_size;
+	*mtime = (uint64_t) st.st_mtime;
+#endif
+	return true;
+}
+
+uint64_t hashFNV1a(const void* data, const size_t size, uint64_t hash)
+{
+	const unsigned char* bytes = data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+double timeGetSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+#endif
+}
+
+int cpuGetThreadCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const int count = (int) info.dwNumberOfProcessors;
+#else
+	const int count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? count : 1;
+}
+
 unsigned char* loadImageDataFromFile(const char* path, int* width, int* height, GLenum* format)
 {
 	int nChannels;
@@ -66,7 +209,8 @@ unsigned char* loadImageDataFromFile(const char* path, int* width, int* height,
 	return imageData;
 }
 
-GLuint loadTextureFromFile(const char* path, const GLint wrapS, const GLint wrapT)
+static GLuint createTexture(const unsigned char* imageData, const int width, const int height, const GLenum format,
+							const GLint wrapS, const GLint wrapT)
 {
 	GLuint textureId;
 	glCreateTextures(GL_TEXTURE_2D, 1, &textureId);
@@ -76,23 +220,58 @@ GLuint loadTextureFromFile(const char* path, const GLint wrapS, const GLint wrap
 	glTextureParameteri(textureId, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTextureParameteri(textureId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	int width, height;
-	GLenum format;
-	unsigned char* imageData = loadImageDataFromFile(path, &width, &height, &format);
 	if (imageData)
 	{
 		// Look into `internalFormat`
 		glTextureStorage2D(textureId, 1, GL_RGBA8, width, height);
 		glTextureSubImage2D(textureId, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, imageData);
 		glGenerateTextureMipmap(textureId);
+	}
+	return textureId;
+}
+
+void freeImageData(unsigned char* imageData)
+{
+	stbi_image_free(imageData);
+}
+
+GLuint loadTextureFromImageData(const unsigned char* imageData, const int width, const int height, const GLenum format,
+								const GLint wrapS, const GLint wrapT)
+{
+	return createTexture(imageData, width, height, format, wrapS, wrapT);
+}
+
+GLuint loadTextureFromFile(const char* path, const GLint wrapS, const GLint wrapT)
+{
+	int width, height;
+	GLenum format;
+	unsigned char* imageData = loadImageDataFromFile(path, &width, &height, &format);
+	const GLuint textureId = createTexture(imageData, width, height, format, wrapS, wrapT);
+	if (imageData)
 		printf("Texture '%s' loaded\n", path);
-	} else
+	else
 		fprintf(stderr, "Failed to load texture: %s\n", path);
 	stbi_image_free(imageData);
 
 	return textureId;
 }
 
+GLuint loadTextureFromMemory(const unsigned char* data, const size_t size, const char* name, const GLint wrapS,
+							 const GLint wrapT)
+{
+	int width = 0, height = 0, nChannels = 0;
+	unsigned char* imageData = size <= INT32_MAX ? stbi_load_from_memory(data, (int) size, &width, &height, &nChannels, 0) : NULL;
+	const GLenum format = nChannels == 1 ? GL_RED : nChannels == 3 ? GL_RGB : GL_RGBA;
+	const GLuint textureId = createTexture(imageData, width, height, format, wrapS, wrapT);
+	if (imageData)
+		printf("Texture '%s' loaded\n", name);
+	else
+		fprintf(stderr, "Failed to load texture: %s\n", name);
+	stbi_image_free(imageData);
+
+	return textureId;
+}
+
 GLuint loadCubeMapTextureFromFiles(const char* faces[], const GLint wrapS, const GLint wrapT, const GLint wrapR)
 {
 	GLuint textureId;
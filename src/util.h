@@ -5,14 +5,47 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #include <glad/glad.h>
 
 #define PI 3.14159265358979323846
 #define RAD(n) (n * PI / 180.0)
 
+typedef struct mappedFile_t
+{
+	const char* data;
+	size_t size;
+	void* handle; // Platform file handle/mapping, don't touch
+	void* mapping;
+} mappedFile_t;
+
 char* readFile(const char* filename);
 
+// Maps a whole file read-only into memory, empty files map to data=NULL size=0
+bool fileMap(const char* filename, mappedFile_t* file);
+void fileUnmap(mappedFile_t* file);
+// Size in bytes & last modification time (seconds since epoch), returns false if the file doesn't exist
+bool fileStat(const char* filename, uint64_t* size, uint64_t* mtime);
+
+uint64_t hashFNV1a(const void* data, size_t size, uint64_t hash);
+#define HASH_FNV1A_SEED 0xCBF29CE484222325ull
+
+// Monotonic wall clock in seconds, usable without a GL context (unlike glfwGetTime)
+double timeGetSeconds();
+int cpuGetThreadCount();
+
+// Decodes without touching GL so it can run on any thread, NULL if it fails, free it with freeImageData
+unsigned char* loadImageDataFromFile(const char* path, int* width, int* height, GLenum* format);
+void freeImageData(unsigned char* imageData);
+// Uploads what loadImageDataFromFile decoded the same way loadTextureFromFile does
+GLuint loadTextureFromImageData(const unsigned char* imageData, int width, int height, GLenum format, GLint wrapS,
+								GLint wrapT);
 GLuint loadTextureFromFile(const char* path, GLint wrapS, GLint wrapT);
+// Same as loadTextureFromFile for an encoded image (png, jpg...) already in memory, 'name' is only for the log
+GLuint loadTextureFromMemory(const unsigned char* data, size_t size, const char* name, GLint wrapS, GLint wrapT);
 GLuint loadCubeMapTextureFromFiles(const char* faces[], GLint wrapS, GLint wrapT, GLint wrapR);
 
 #endif //UTIL_H